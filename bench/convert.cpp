@@ -0,0 +1,101 @@
+/*  ========================================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ========================================================================================================================================
+*/
+#include <catch2/catch.hpp>
+#include <pack/pack.h>
+#include <vector>
+
+namespace bench {
+
+/// Text of the numbers of the type, spread over its range
+template <typename T>
+static std::vector<std::string> makeNumbers()
+{
+    std::vector<std::string> out;
+    for (int i = 0; i < 1000; ++i) {
+        if constexpr (std::is_floating_point_v<T>) {
+            out.push_back(pack::convert<std::string>(T(i * 12345.6789) / T(i % 7 + 1)));
+        } else {
+            out.push_back(pack::convert<std::string>(T(uint64_t(i) * 0x9e3779b97f4a7c15ull)));
+        }
+    }
+    return out;
+}
+
+template <typename T>
+static void parse(const char* name)
+{
+    static const std::vector<std::string> numbers = makeNumbers<T>();
+
+    BENCHMARK(std::string("parse ") + name)
+    {
+        T sum{};
+        for (const auto& str : numbers) {
+            sum += *pack::tryConvert<T>(str);
+        }
+        return sum;
+    };
+}
+
+template <typename T>
+static void format(const char* name)
+{
+    static const std::vector<T> numbers = [] {
+        std::vector<T> out;
+        for (const auto& str : makeNumbers<T>()) {
+            out.push_back(pack::convert<T>(str));
+        }
+        return out;
+    }();
+
+    BENCHMARK(std::string("format ") + name)
+    {
+        size_t size = 0;
+        for (T value : numbers) {
+            size += pack::convert<std::string>(value).size();
+        }
+        return size;
+    };
+}
+
+} // namespace bench
+
+TEST_CASE("Number parsing", "[!benchmark]")
+{
+    bench::parse<int8_t>("int8");
+    bench::parse<uint8_t>("uint8");
+    bench::parse<int16_t>("int16");
+    bench::parse<uint16_t>("uint16");
+    bench::parse<int32_t>("int32");
+    bench::parse<uint32_t>("uint32");
+    bench::parse<int64_t>("int64");
+    bench::parse<uint64_t>("uint64");
+    bench::parse<float>("float");
+    bench::parse<double>("double");
+}
+
+TEST_CASE("Number formatting", "[!benchmark]")
+{
+    bench::format<int8_t>("int8");
+    bench::format<uint8_t>("uint8");
+    bench::format<int16_t>("int16");
+    bench::format<uint16_t>("uint16");
+    bench::format<int32_t>("int32");
+    bench::format<uint32_t>("uint32");
+    bench::format<int64_t>("int64");
+    bench::format<uint64_t>("uint64");
+    bench::format<float>("float");
+    bench::format<double>("double");
+}
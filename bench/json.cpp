@@ -0,0 +1,94 @@
+/*  ========================================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ========================================================================================================================================
+*/
+#include <catch2/catch.hpp>
+#include <pack/pack.h>
+
+namespace bench {
+
+struct Address : public pack::Node
+{
+    pack::String street = FIELD("street");
+    pack::String city   = FIELD("city");
+    pack::UInt32 zip    = FIELD("zip");
+
+    using pack::Node::Node;
+    META(Address, street, city, zip);
+};
+
+struct Record : public pack::Node
+{
+    pack::Int64         id      = FIELD("id");
+    pack::String        name    = FIELD("name");
+    pack::String        comment = FIELD("comment");
+    pack::Double        score   = FIELD("score");
+    pack::Bool          active  = FIELD("active");
+    pack::StringList    tags    = FIELD("tags");
+    pack::Int32List     values  = FIELD("values");
+    pack::List<Address> address = FIELD("address");
+
+    using pack::Node::Node;
+    META(Record, id, name, comment, score, active, tags, values, address);
+};
+
+struct Document : public pack::Node
+{
+    pack::List<Record> records = FIELD("records");
+
+    using pack::Node::Node;
+    META(Document, records);
+};
+
+/// Makes about 4Mb of json
+static pack::string_t makeDocument()
+{
+    Document doc;
+    for (int i = 0; i < 10000; ++i) {
+        auto& rec   = doc.records.append();
+        rec.id      = 1000000 + i;
+        rec.name    = pack::fromStdString("record name " + std::to_string(i));
+        rec.comment = pack::fromStdString("some \"quoted\" text with escapes \\ and {structural} [chars], number " + std::to_string(i));
+        rec.score   = i * 0.37;
+        rec.active  = i % 2 == 0;
+        rec.tags    = {"first"_s, "second"_s, "third"_s};
+        rec.values  = {i, -i, i * 2, i * 3};
+        for (int j = 0; j < 2; ++j) {
+            auto& addr  = rec.address.append();
+            addr.street = pack::fromStdString("street " + std::to_string(j));
+            addr.city   = "city"_s;
+            addr.zip    = uint32_t(10000 + j);
+        }
+    }
+    return *pack::json::serialize(doc, pack::Option::PrettyPrint);
+}
+
+} // namespace bench
+
+TEST_CASE("Json deserialization", "[!benchmark]")
+{
+    static const pack::string_t json = bench::makeDocument();
+
+    BENCHMARK("nlohmann sax")
+    {
+        bench::Document doc;
+        return pack::json::deserialize(json, doc, pack::json::Parser::Sax).isValid();
+    };
+
+    BENCHMARK("structural index")
+    {
+        bench::Document doc;
+        return pack::json::deserialize(json, doc, pack::json::Parser::Structural).isValid();
+    };
+}
@@ -0,0 +1,174 @@
+/*  ========================================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ========================================================================================================================================
+*/
+#include <catch2/catch.hpp>
+#include <google/protobuf/descriptor.pb.h>
+#include <pack/pack.h>
+#include <thread>
+#include <vector>
+
+namespace bench {
+
+/// Count of the message types, each thread works with all of them
+static constexpr int TypesCount = 4;
+
+/// File descriptor of the messages, made in place as the benchmark is built without protoc-gen-pack
+static const std::string& fileDescriptor()
+{
+    static const std::string desc = [] {
+        namespace pb = google::protobuf;
+
+        pb::FileDescriptorSet set;
+        auto*                 file = set.add_file();
+        file->set_name("bench.proto");
+        file->set_package("bench");
+        file->set_syntax("proto3");
+
+        for (int i = 0; i < TypesCount; ++i) {
+            auto* msg = file->add_message_type();
+            msg->set_name("Sample" + std::to_string(i));
+
+            auto add = [&](const char* name, int number, pb::FieldDescriptorProto::Type type, bool repeated) {
+                auto* fld = msg->add_field();
+                fld->set_name(name);
+                fld->set_json_name(name);
+                fld->set_number(number);
+                fld->set_type(type);
+                fld->set_label(repeated ? pb::FieldDescriptorProto::LABEL_REPEATED : pb::FieldDescriptorProto::LABEL_OPTIONAL);
+            };
+            add("id", 1, pb::FieldDescriptorProto::TYPE_INT64, false);
+            add("name", 2, pb::FieldDescriptorProto::TYPE_STRING, false);
+            add("score", 3, pb::FieldDescriptorProto::TYPE_DOUBLE, false);
+            add("active", 4, pb::FieldDescriptorProto::TYPE_BOOL, false);
+            add("values", 5, pb::FieldDescriptorProto::TYPE_INT32, true);
+            add("weights", 6, pb::FieldDescriptorProto::TYPE_DOUBLE, true);
+        }
+        return set.SerializeAsString();
+    }();
+    return desc;
+}
+
+template <int N>
+struct Sample : public pack::Node
+{
+    pack::Int64      id      = FIELD("id");
+    pack::String     name    = FIELD("name");
+    pack::Double     score   = FIELD("score");
+    pack::Bool       active  = FIELD("active");
+    pack::Int32List  values  = FIELD("values");
+    pack::DoubleList weights = FIELD("weights");
+
+    using pack::Node::Node;
+    META(Sample, id, name, score, active, values, weights);
+
+    const std::string& fileDescriptor() const override
+    {
+        return bench::fileDescriptor();
+    }
+
+    std::string protoName() const override
+    {
+        return "bench.Sample" + std::to_string(N);
+    }
+};
+
+/// Serializes and reads back the message of the type
+template <int N>
+static bool roundTrip(int index, std::string& buffer)
+{
+    Sample<N> msg;
+    msg.id     = index;
+    msg.name   = pack::fromStdString("sample " + std::to_string(index));
+    msg.score  = index * 0.37;
+    msg.active = index % 2 == 0;
+    msg.values = {index, -index, index * 2};
+
+    buffer.clear();
+    Sample<N> restored;
+    return pack::protobuf::serialize(msg, buffer) && pack::protobuf::deserialize(std::string_view(buffer), restored);
+}
+
+/// Runs the round trips of all message types in the threads, returns count of the failed ones
+static int run(int threads, int count)
+{
+    std::vector<std::thread> pool;
+    std::vector<int>         failed(size_t(threads), 0);
+    for (int t = 0; t < threads; ++t) {
+        pool.emplace_back([t, count, &failed]() {
+            std::string buffer;
+            for (int i = 0; i < count; ++i) {
+                bool ok = false;
+                switch ((i + t) % TypesCount) {
+                case 0:
+                    ok = roundTrip<0>(i, buffer);
+                    break;
+                case 1:
+                    ok = roundTrip<1>(i, buffer);
+                    break;
+                case 2:
+                    ok = roundTrip<2>(i, buffer);
+                    break;
+                default:
+                    ok = roundTrip<3>(i, buffer);
+                    break;
+                }
+                failed[size_t(t)] += ok ? 0 : 1;
+            }
+        });
+    }
+    int ret = 0;
+    for (int t = 0; t < threads; ++t) {
+        pool[size_t(t)].join();
+        ret += failed[size_t(t)];
+    }
+    return ret;
+}
+
+} // namespace bench
+
+TEST_CASE("Protobuf throughput", "[!benchmark]")
+{
+    // Every thread makes the same count of round trips, so time should stay flat while the threads have cores
+    for (int threads : {1, 2, 4, 8}) {
+        BENCHMARK("10000 round trips per thread, " + std::to_string(threads) + " threads")
+        {
+            return bench::run(threads, 10000);
+        };
+    }
+}
+
+TEST_CASE("Protobuf packed lists", "[!benchmark]")
+{
+    bench::Sample<0> msg;
+    for (int i = 0; i < 10000; ++i) {
+        msg.values.append(i % 7 ? i * 131 : -i);
+        msg.weights.append(i / 3.0);
+    }
+
+    std::string buffer;
+    REQUIRE(pack::protobuf::serialize(msg, buffer));
+
+    BENCHMARK("serialize 2 x 10000 numbers")
+    {
+        std::string out;
+        return pack::protobuf::serialize(msg, out).isValid();
+    };
+
+    BENCHMARK("deserialize 2 x 10000 numbers")
+    {
+        bench::Sample<0> restored;
+        return pack::protobuf::deserialize(std::string_view(buffer), restored).isValid();
+    };
+}
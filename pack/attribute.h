@@ -19,9 +19,12 @@
 #pragma once
 #include "pack/types.h"
 #include "pack/options.h"
+#include <memory>
 
 namespace pack {
 
+class INode;
+
 // =========================================================================================================================================
 
 class Attribute
@@ -41,8 +44,8 @@ public:
     template <typename... Args>
     Attribute(NodeType type, const Args&... args);
     Attribute(NodeType type, const string_t& key = {});
-    Attribute(const Attribute&) = default;
-    Attribute(Attribute&&)      = default;
+    Attribute(const Attribute& other);
+    Attribute(Attribute&& other) noexcept;
     virtual ~Attribute();
 
     virtual bool     compare(const Attribute& other) const = 0;
@@ -57,14 +60,44 @@ public:
     bool operator==(const Attribute& other) const;
     bool operator!=(const Attribute& other) const;
 
-    Attribute& operator=(const Attribute&) = default;
-    Attribute& operator=(Attribute&&)      = default;
+    Attribute& operator=(const Attribute& other);
+    Attribute& operator=(Attribute&& other) noexcept;
 
     NodeType type() const;
 
+    /// Binds the items of the container or the fields of the node to it, so the changes of the items are reported up to the owners.
+    /// Serializers do it on demand before caching, fields of the node with presence bitmap are bound on construction.
+    virtual void adoptChildren() const;
+
+protected:
+    /// Notifies the owner that this attribute was changed, present is the new presence state of the attribute
+    void changed(bool present) const;
+
+    /// Called when a child attribute was changed, by default propagates the change to own owner
+    virtual void childChanged(uint32_t slot, bool present);
+
+    /// Makes this attribute an owner of the child
+    void adopt(const Attribute& child, uint32_t slot = 0) const;
+
+    /// Returns the attribute which holds this one, nullptr if it was not bound
+    const Attribute* owner() const;
+
+private:
+    /// Sets the key given at runtime, the attribute keeps own copy of it
+    void setKey(const string_t& key);
+
 protected:
-    string_t m_key;
-    NodeType m_type;
+    const string_t* m_key;
+    NodeType        m_type;
+
+private:
+    /// Storage of the runtime key, keys of the declared fields are shared with the declaration and are not copied
+    std::unique_ptr<const string_t> m_ownKey;
+
+    /// Owner is a node or a container which holds this attribute, slot is an index of the field in the owner field table. This is a
+    /// bookkeeping, not a value, so it's not copied and could be set on const objects.
+    mutable uint32_t   m_slot  = 0;
+    mutable Attribute* m_owner = nullptr;
 };
 
 // =========================================================================================================================================
@@ -73,11 +106,31 @@ template <typename... Args>
 Attribute::Attribute(NodeType type, const Args&... args)
     : Attribute(type)
 {
-    if (auto ret = pickOption<Key>(args...); ret) {
-        m_key = ret->value;
+    if (auto ret = pickOption<Declaration>(args...); ret) {
+        m_key = &ret->key();
+    } else if (auto ret = pickOption<Key>(args...); ret) {
+        setKey(ret->value);
     }
 }
 
+inline void Attribute::changed(bool present) const
+{
+    if (m_owner) {
+        m_owner->childChanged(m_slot, present);
+    }
+}
+
+inline const Attribute* Attribute::owner() const
+{
+    return m_owner;
+}
+
+inline void Attribute::adopt(const Attribute& child, uint32_t slot) const
+{
+    child.m_owner = const_cast<Attribute*>(this);
+    child.m_slot  = slot;
+}
+
 // =========================================================================================================================================
 
 } // namespace pack
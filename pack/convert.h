@@ -18,238 +18,136 @@
 ========================================================================================================================================= */
 #pragma once
 
+#include "pack/expected.h"
 #include "pack/utils.h"
-#include <sstream>
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #ifdef WITH_QSTRING
 #include <QString>
 #endif
 
 namespace pack {
-// =========================================================================================================================================
-
-template <typename T, typename ValueT>
-std::enable_if_t<std::is_same_v<T, std::string> || std::is_constructible_v<std::string, T>, std::string> convert(ValueT&& value)
-{
-    if constexpr (std::is_same_v<std::string, ValueT>) {
-        return value;
-    } else if constexpr (std::is_floating_point_v<ValueT>) {
-        std::stringstream ss;
-        ss << value;
-        return ss.str();
-    } else if constexpr (std::is_integral_v<ValueT> && !std::is_same_v<bool, ValueT>) {
-        return std::to_string(value);
-    } else if constexpr (std::is_same_v<bool, ValueT>) {
-        return value ? std::string{"true"} : std::string{"false"};
-    } else if constexpr (std::is_constructible_v<std::string, ValueT> && !std::is_same_v<std::string, ValueT>) {
-        return std::string{value};
-#ifdef WITH_QTSTRING
-    } else if constexpr (std::is_same_v<QString, ValueT>) {
-        return value.toStdString();
-#endif
-    } else {
-        static_assert(always_false<ValueT>, "Unsupported type to cast into std::string");
-    }
-}
-
-// =========================================================================================================================================
-
-template <typename T, typename ValueT>
-std::enable_if_t<std::is_same_v<T, int8_t>, int8_t> convert(ValueT&& value)
-{
-    if constexpr (std::is_same_v<int8_t, ValueT>) {
-        return value;
-    } else if constexpr (std::is_constructible_v<std::string, ValueT>) {
-        return type(std::stoi(value));
-#ifdef WITH_QTSTRING
-    } else if constexpr (std::is_same_v<QString, ValueT>) {
-        return type(value.toShort());
-#endif
-    } else if constexpr (std::is_integral_v<ValueT> || std::is_floating_point_v<ValueT>) {
-        return static_cast<int8_t>(value);
-    } else {
-        static_assert(always_false<ValueT>, "Unsupported type to cast into int8_t");
-    }
-}
-
-// =========================================================================================================================================
-
-template <typename T, typename ValueT>
-std::enable_if_t<std::is_same_v<T, uint8_t>, uint8_t> convert(ValueT&& value)
-{
-    if constexpr (std::is_same_v<uint8_t, ValueT>) {
-        return value;
-    } else if constexpr (std::is_constructible_v<std::string, ValueT>) {
-        return uint8_t(std::stoul(value));
-#ifdef WITH_QTSTRING
-    } else if constexpr (std::is_same_v<QString, ValueT>) {
-        return uint8_t(value.toUShort());
-#endif
-    } else if constexpr (std::is_integral_v<ValueT> || std::is_floating_point_v<ValueT>) {
-        return static_cast<uint8_t>(value);
-    } else {
-        static_assert(always_false<ValueT>, "Unsupported type to cast into uint8_t");
-    }
-}
 
 // =========================================================================================================================================
 
-template <typename T, typename ValueT>
-std::enable_if_t<std::is_same_v<T, int16_t>, int16_t> convert(ValueT&& value)
-{
-    if constexpr (std::is_same_v<int16_t, ValueT>) {
-        return value;
-    } else if constexpr (std::is_constructible_v<std::string, ValueT>) {
-        return int16_t(std::stoi(value));
-#ifdef WITH_QTSTRING
-    } else if constexpr (std::is_same_v<QString, ValueT>) {
-        return int16_t(value.toInt());
-#endif
-    } else if constexpr (std::is_integral_v<ValueT> || std::is_floating_point_v<ValueT>) {
-        return static_cast<int16_t>(value);
-    } else {
-        static_assert(always_false<ValueT>, "Unsupported type to cast into int16_t");
-    }
-}
-
-// =========================================================================================================================================
-
-template <typename T, typename ValueT>
-std::enable_if_t<std::is_same_v<T, uint16_t>, uint16_t> convert(ValueT&& value)
-{
-    if constexpr (std::is_same_v<uint16_t, ValueT>) {
-        return value;
-    } else if constexpr (std::is_constructible_v<std::string, ValueT>) {
-        return uint16_t(std::stoul(value));
-#ifdef WITH_QTSTRING
-    } else if constexpr (std::is_same_v<QString, ValueT>) {
-        return uint16_t(value.toUInt());
-#endif
-    } else if constexpr (std::is_integral_v<ValueT> || std::is_floating_point_v<ValueT>) {
-        return static_cast<uint16_t>(value);
-    } else {
-        static_assert(always_false<ValueT>, "Unsupported type to cast into uint16_t");
+namespace details {
+
+    template <typename T>
+    constexpr bool isStringView = std::is_convertible_v<const T&, std::string_view>;
+
+    inline std::string_view trimmed(std::string_view str)
+    {
+        auto isSpace = [](char ch) {
+            return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r' || ch == '\f' || ch == '\v';
+        };
+        while (!str.empty() && isSpace(str.front())) {
+            str.remove_prefix(1);
+        }
+        while (!str.empty() && isSpace(str.back())) {
+            str.remove_suffix(1);
+        }
+        return str;
     }
-}
-
-// =========================================================================================================================================
 
-template <typename T, typename ValueT>
-std::enable_if_t<std::is_same_v<T, int32_t>, int32_t> convert(ValueT&& value)
-{
-    if constexpr (std::is_same_v<int32_t, ValueT>) {
-        return int32_t(value);
-    } else if constexpr (std::is_constructible_v<std::string, ValueT>) {
-        return int32_t(std::stol(value));
-#ifdef WITH_QTSTRING
-    } else if constexpr (std::is_same_v<QString, ValueT>) {
-        return int32_t(value.toLong());
-#endif
-    } else if constexpr (std::is_integral_v<ValueT> || std::is_floating_point_v<ValueT>) {
-        return static_cast<int32_t>(value);
-    } else {
-        static_assert(always_false<ValueT>, "Unsupported type to cast into int32_t");
+    /// Parses the whole text as a number or boolean, surrounding whitespaces are allowed. Does not allocate unless there is an error.
+    template <typename T>
+    Expected<T> fromChars(std::string_view str)
+    {
+        auto text = trimmed(str);
+        if constexpr (std::is_same_v<T, bool>) {
+            auto equals = [&](std::string_view word) {
+                return std::equal(text.begin(), text.end(), word.begin(), word.end(), [](char left, char right) {
+                    return (left >= 'A' && left <= 'Z' ? char(left - 'A' + 'a') : left) == right;
+                });
+            };
+            return equals("true") || equals("1") || equals("on");
+        } else {
+            const char* first = text.data();
+            const char* last  = text.data() + text.size();
+            if (last - first > 1 && *first == '+' && first[1] != '-') {
+                ++first;
+            }
+
+            T value{};
+            auto [ptr, ec] = std::from_chars(first, last, value);
+            if (ec == std::errc::result_out_of_range) {
+                return unexpected("Value '{}' is out of range"_s, str);
+            }
+            if (ec != std::errc() || ptr != last) {
+                return unexpected("Cannot convert '{}' into the number"_s, str);
+            }
+            return value;
+        }
     }
-}
 
-// =========================================================================================================================================
-
-template <typename T, typename ValueT>
-std::enable_if_t<std::is_same_v<T, uint32_t>, uint32_t> convert(ValueT&& value)
-{
-    if constexpr (std::is_same_v<uint32_t, ValueT>) {
-        return value;
-    } else if constexpr (std::is_constructible_v<std::string, ValueT>) {
-        return uint32_t(std::stoul(value));
-#ifdef WITH_QTSTRING
-    } else if constexpr (std::is_same_v<QString, ValueT>) {
-        return uint32_t(value.toULong());
-#endif
-    } else if constexpr (std::is_integral_v<ValueT> || std::is_floating_point_v<ValueT>) {
-        return static_cast<uint32_t>(value);
-    } else {
-        static_assert(always_false<ValueT>, "Unsupported type to cast into uint32_t");
+    /// Formats the number, floating point numbers get the shortest text which reads back into the same value
+    template <typename T>
+    std::string toChars(T value)
+    {
+        char buffer[64];
+        auto [ptr, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        return std::string(buffer, ptr);
     }
-}
-
-// =========================================================================================================================================
 
-template <typename T, typename ValueT>
-std::enable_if_t<std::is_same_v<T, int64_t>, int64_t> convert(ValueT&& value)
-{
-    if constexpr (std::is_same_v<int64_t, ValueT>) {
-        return value;
-    } else if constexpr (std::is_constructible_v<std::string, ValueT>) {
-        return int64_t(std::stoll(value));
-#ifdef WITH_QTSTRING
-    } else if constexpr (std::is_same_v<QString, ValueT>) {
-        return int64_t(value.toLongLong());
-#endif
-    } else if constexpr (std::is_integral_v<ValueT> || std::is_floating_point_v<ValueT>) {
-        return static_cast<int64_t>(value);
-    } else {
-        static_assert(always_false<ValueT>, "Unsupported type to cast into int64_t");
+    template <typename T>
+    T valueOrThrow(Expected<T>&& value)
+    {
+        if (!value) {
+            throw std::invalid_argument(toStdString(value.error()));
+        }
+        return *value;
     }
-}
-
-// =========================================================================================================================================
 
-template <typename T, typename ValueT>
-std::enable_if_t<std::is_same_v<T, uint64_t>, uint64_t> convert(ValueT&& value)
-{
-    if constexpr (std::is_same_v<uint64_t, ValueT>) {
-        return value;
-    } else if constexpr (std::is_constructible_v<std::string, ValueT>) {
-        return uint64_t(std::stoull(value));
-#ifdef WITH_QTSTRING
-    } else if constexpr (std::is_same_v<QString, ValueT>) {
-        return uint64_t(value.toULongLong());
-#endif
-    } else if constexpr (std::is_integral_v<ValueT> || std::is_floating_point_v<ValueT>) {
-        return static_cast<uint64_t>(value);
-    } else {
-        static_assert(always_false<ValueT>, "Unsupported type to cast into uint64_t");
-    }
-}
+} // namespace details
 
 // =========================================================================================================================================
 
 template <typename T, typename ValueT>
-std::enable_if_t<std::is_same_v<T, float>, float> convert(ValueT&& value)
+std::enable_if_t<std::is_same_v<T, std::string> || std::is_constructible_v<std::string, T>, std::string> convert(ValueT&& value)
 {
-    if constexpr (std::is_same_v<float, ValueT>) {
+    using Type = std::decay_t<ValueT>;
+    if constexpr (std::is_same_v<std::string, Type>) {
         return value;
-    } else if constexpr (std::is_constructible_v<std::string, ValueT>) {
-        return std::stof(value);
+    } else if constexpr (std::is_same_v<bool, Type>) {
+        return value ? std::string{"true"} : std::string{"false"};
+    } else if constexpr (std::is_arithmetic_v<Type>) {
+        return details::toChars(value);
+    } else if constexpr (std::is_constructible_v<std::string, Type>) {
+        return std::string{value};
 #ifdef WITH_QTSTRING
-    } else if constexpr (std::is_same_v<QString, ValueT>) {
-        return float(value.toDouble());
+    } else if constexpr (std::is_same_v<QString, Type>) {
+        return value.toStdString();
 #endif
-    } else if constexpr (std::is_integral_v<ValueT> || std::is_floating_point_v<ValueT>) {
-        return static_cast<float>(value);
     } else {
-        static_assert(always_false<ValueT>, "Unsupported type to cast into float");
+        static_assert(always_false<ValueT>, "Unsupported type to cast into std::string");
     }
 }
 
 // =========================================================================================================================================
 
+/// Converts into the number, the text is parsed with std::from_chars. Throws std::invalid_argument if the text is not a number or
+/// does not fit into the type, use tryConvert to get an error instead.
 template <typename T, typename ValueT>
-std::enable_if_t<std::is_same_v<T, double>, double> convert(ValueT&& value)
+std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, T> convert(ValueT&& value)
 {
-    if constexpr (std::is_same_v<double, ValueT>) {
+    using Type = std::decay_t<ValueT>;
+    if constexpr (std::is_same_v<T, Type>) {
         return value;
-    } else if constexpr (std::is_constructible_v<std::string, ValueT>) {
-        return std::stod(value);
+    } else if constexpr (details::isStringView<Type>) {
+        return details::valueOrThrow(details::fromChars<T>(value));
 #ifdef WITH_QTSTRING
-    } else if constexpr (std::is_same_v<QString, ValueT>) {
-        return value.toDouble();
+    } else if constexpr (std::is_same_v<QString, Type>) {
+        QByteArray utf = value.toUtf8();
+        return details::valueOrThrow(details::fromChars<T>(std::string_view(utf.constData(), size_t(utf.size()))));
 #endif
-    } else if constexpr (std::is_integral_v<ValueT> || std::is_floating_point_v<ValueT>) {
-        return static_cast<double>(value);
+    } else if constexpr (std::is_integral_v<Type> || std::is_floating_point_v<Type>) {
+        return static_cast<T>(value);
     } else {
-        static_assert(always_false<ValueT>, "Unsupported type to cast into double");
+        static_assert(always_false<ValueT>, "Unsupported type to cast into the number");
     }
 }
 
@@ -258,20 +156,20 @@ std::enable_if_t<std::is_same_v<T, double>, double> convert(ValueT&& value)
 template <typename T, typename ValueT>
 std::enable_if_t<std::is_same_v<T, bool>, bool> convert(ValueT&& value)
 {
-    if constexpr (std::is_same_v<bool, ValueT>) {
+    using Type = std::decay_t<ValueT>;
+    if constexpr (std::is_same_v<bool, Type>) {
         return value;
-    } else if constexpr (std::is_constructible_v<std::string, ValueT>) {
-        auto lower = tolower(value);
-        return lower == "true" || lower == "1" || lower == "on";
+    } else if constexpr (details::isStringView<Type>) {
+        return *details::fromChars<bool>(value);
 #ifdef WITH_QTSTRING
-    } else if constexpr (std::is_same_v<QString, ValueT>) {
+    } else if constexpr (std::is_same_v<QString, Type>) {
         auto lower = value.toLower();
         return lower == "true"_s || lower == "1"_s || lower == "on"_s;
 #endif
-    } else if constexpr (std::is_integral_v<ValueT>) {
+    } else if constexpr (std::is_integral_v<Type>) {
         return value != 0;
-    } else if constexpr (std::is_floating_point_v<ValueT>) {
-        return value > ValueT(0.f) || value < ValueT(0.f);
+    } else if constexpr (std::is_floating_point_v<Type>) {
+        return value > Type(0.f) || value < Type(0.f);
     } else {
         static_assert(always_false<ValueT>, "Unsupported type to cast into bool");
     }
@@ -283,16 +181,16 @@ std::enable_if_t<std::is_same_v<T, bool>, bool> convert(ValueT&& value)
 template <typename T, typename ValueT>
 std::enable_if_t<std::is_same_v<T, QString>, QString> convert(ValueT&& value)
 {
-    if constexpr (std::is_same_v<QString, ValueT> || std::is_convertible_v<QString, ValueT>) {
+    using Type = std::decay_t<ValueT>;
+    if constexpr (std::is_same_v<QString, Type> || std::is_convertible_v<QString, Type>) {
         return value;
-    } else if constexpr (std::is_constructible_v<std::string, ValueT>) {
-        return QString::fromStdString(value);
-    } else if constexpr (std::is_integral_v<ValueT> && !std::is_same_v<bool, ValueT>) {
-        return QString::number(value);
-    } else if constexpr (std::is_floating_point_v<ValueT>) {
-        return QString::number(double(value));
-    } else if constexpr (std::is_same_v<bool, ValueT>) {
+    } else if constexpr (details::isStringView<Type>) {
+        std::string_view str(value);
+        return QString::fromUtf8(str.data(), int(str.size()));
+    } else if constexpr (std::is_same_v<bool, Type>) {
         return value ? "true"_s : "false"_s;
+    } else if constexpr (std::is_arithmetic_v<Type>) {
+        return QString::fromStdString(details::toChars(value));
     } else {
         static_assert(always_false<ValueT>, "Unsupported type to cast into QString");
     }
@@ -323,4 +221,23 @@ std::enable_if_t<std::is_same_v<T, std::vector<std::byte>>, std::vector<std::byt
     }
 }
 
+// =========================================================================================================================================
+
+/// Converts the value as convert does, but reports malformed or out of range text as an error instead of throwing
+template <typename T, typename ValueT>
+Expected<T> tryConvert(ValueT&& value)
+{
+    using Type = std::decay_t<ValueT>;
+    if constexpr (std::is_arithmetic_v<T> && details::isStringView<Type>) {
+        return details::fromChars<T>(value);
+#ifdef WITH_QTSTRING
+    } else if constexpr (std::is_arithmetic_v<T> && std::is_same_v<QString, Type>) {
+        QByteArray utf = value.toUtf8();
+        return details::fromChars<T>(std::string_view(utf.constData(), size_t(utf.size())));
+#endif
+    } else {
+        return convert<T>(std::forward<ValueT>(value));
+    }
+}
+
 } // namespace pack
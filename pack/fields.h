@@ -0,0 +1,524 @@
+/* =========================================================================================================================================
+    ____ __ _ ____ __  __
+   |    |  ` |    |  /  /
+   | |  | |  | |__|    /
+   | ___| |  | |  |    \
+   |_|  |__,_|____|__\__\ DSO library
+
+   Copyright (C) 2020 Eaton
+   Copyright (C) 2020-2022 zJes
+
+   This program is free software; you can redistribute it and/or modify it under the terms of the GNU Lesser General Public License as
+   published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+========================================================================================================================================= */
+#pragma once
+#include "pack/attribute.h"
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <iterator>
+#include <mutex>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace pack {
+
+class INode;
+class IValue;
+class IEnum;
+class IList;
+class IMap;
+class IVariant;
+
+// =========================================================================================================================================
+
+/// Static description of the node field, generated by META macro
+struct FieldInfo
+{
+    using Accessor = Attribute& (*)(INode&);
+    using Assign   = void (*)(INode& to, const INode& from);
+    using Move     = void (*)(INode& to, INode& from);
+    using Equal    = bool (*)(const INode& left, const INode& right);
+
+    /// Name of the class member
+    std::string_view name = {};
+
+    /// Kind of the attribute
+    Attribute::NodeType type = Attribute::NodeType::Node;
+
+    /// Returns the field of the given node instance
+    Accessor access = nullptr;
+
+    /// Copies the field between two instances of the same type
+    Assign assign = nullptr;
+
+    /// Moves the field between two instances of the same type
+    Move move = nullptr;
+
+    /// Compares the field of two instances of the same type
+    Equal equal = nullptr;
+};
+
+// =========================================================================================================================================
+
+/// Hashed lookup of the field slots by name or by key
+///
+/// Index is a per type static object, filled on first use. Both names and keys are placed into open addressing tables, hash seed is
+/// chosen to avoid collisions (perfect hash) when possible, so lookup usually is a single probe and one string compare.
+class FieldIndex
+{
+public:
+    FieldIndex() = default;
+
+    FieldIndex(const FieldIndex&)            = delete;
+    FieldIndex& operator=(const FieldIndex&) = delete;
+
+    /// Returns slot of the field by its name or -1
+    int byName(const FieldInfo* fields, size_t size, std::string_view name) const;
+
+    /// Returns slot of the field by its key or -1, keys are taken from the node on first call
+    int byKey(const FieldInfo* fields, size_t size, std::string_view key, const INode& node) const;
+
+private:
+    struct Table
+    {
+        void build(const std::vector<std::string_view>& items);
+        int  find(std::string_view item) const;
+
+        std::vector<std::string_view> items;
+        std::vector<int>              slots;
+        uint32_t                      seed = 0;
+        uint32_t                      mask = 0;
+    };
+
+private:
+    mutable std::once_flag           m_namesOnce;
+    mutable std::once_flag           m_keysOnce;
+    mutable Table                    m_names;
+    mutable Table                    m_keys;
+#ifdef WITH_QTSTRING
+    mutable std::vector<std::string> m_keysStorage;
+#endif
+};
+
+// =========================================================================================================================================
+
+/// View over static per type table of the fields descriptions
+class FieldTable
+{
+public:
+    constexpr FieldTable() = default;
+    constexpr FieldTable(const FieldInfo* data, size_t size, const FieldIndex* index = nullptr)
+        : m_data(data)
+        , m_size(size)
+        , m_index(index)
+    {
+    }
+
+    constexpr const FieldInfo* begin() const
+    {
+        return m_data;
+    }
+
+    constexpr const FieldInfo* end() const
+    {
+        return m_data + m_size;
+    }
+
+    constexpr size_t size() const
+    {
+        return m_size;
+    }
+
+    constexpr const FieldInfo& operator[](size_t index) const
+    {
+        return m_data[index];
+    }
+
+    /// Returns a list of the fields names
+    std::vector<string_t> names() const;
+
+    /// Returns index of the field by the class member name or -1
+    int indexOfName(std::string_view name) const;
+
+    /// Returns index of the field by the key or -1
+    int indexOfKey(std::string_view key, const INode& node) const;
+
+private:
+    const FieldInfo*  m_data  = nullptr;
+    size_t            m_size  = 0;
+    const FieldIndex* m_index = nullptr;
+};
+
+// =========================================================================================================================================
+
+/// Bitmap of the node fields which have a value
+///
+/// Bits are maintained by the field setters: values and enums keep the bit exact, containers set it on any modifying access and clear
+/// it when become empty, so set bits are a superset of the fields with value. The words are owned by the node (see META), this class is a
+/// view over them.
+class Presence
+{
+public:
+    constexpr Presence() = default;
+    constexpr Presence(uint64_t* words, size_t size)
+        : m_words(words)
+        , m_size(size)
+    {
+    }
+
+    /// Returns true if the bitmap is attached to the node
+    explicit operator bool() const
+    {
+        return m_words != nullptr;
+    }
+
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    bool test(size_t index) const
+    {
+        return (m_words[index / 64] >> (index % 64)) & 1u;
+    }
+
+    void set(size_t index, bool value)
+    {
+        if (value) {
+            m_words[index / 64] |= uint64_t(1) << (index % 64);
+        } else {
+            m_words[index / 64] &= ~(uint64_t(1) << (index % 64));
+        }
+    }
+
+    /// Returns count of the set bits
+    size_t count() const
+    {
+        size_t ret = 0;
+        for (size_t i = 0; i < words(); ++i) {
+            ret += std::bitset<64>(m_words[i]).count();
+        }
+        return ret;
+    }
+
+    bool any() const
+    {
+        for (size_t i = 0; i < words(); ++i) {
+            if (m_words[i]) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Returns index of the first set bit starting from the given one or size() if there are no more
+    size_t next(size_t from) const
+    {
+        while (from < m_size) {
+            uint64_t word = m_words[from / 64] >> (from % 64);
+            if (!word) {
+                from = (from / 64 + 1) * 64;
+                continue;
+            }
+#if defined(__GNUC__) || defined(__clang__)
+            return from + size_t(__builtin_ctzll(word));
+#else
+            while (!(word & 1u)) {
+                word >>= 1;
+                ++from;
+            }
+            return from;
+#endif
+        }
+        return m_size;
+    }
+
+private:
+    size_t words() const
+    {
+        return (m_size + 63) / 64;
+    }
+
+private:
+    uint64_t* m_words = nullptr;
+    size_t    m_size  = 0;
+};
+
+// =========================================================================================================================================
+
+/// Allocation free range of the node fields
+template <typename AttrT>
+class Fields
+{
+public:
+    using NodeT = std::conditional_t<std::is_const_v<AttrT>, const INode, INode>;
+
+    class Iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = AttrT;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = AttrT*;
+        using reference         = AttrT&;
+
+        Iterator(const FieldInfo* it, NodeT* node, const FieldInfo* first = nullptr, const Presence* presence = nullptr)
+            : m_it(it)
+            , m_node(node)
+            , m_first(first)
+            , m_presence(presence)
+        {
+        }
+
+        AttrT& operator*() const
+        {
+            return m_it->access(const_cast<INode&>(*m_node));
+        }
+
+        AttrT* operator->() const
+        {
+            return &operator*();
+        }
+
+        Iterator& operator++()
+        {
+            advance();
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            Iterator copy = *this;
+            advance();
+            return copy;
+        }
+
+        bool operator==(const Iterator& other) const
+        {
+            return m_it == other.m_it;
+        }
+
+        bool operator!=(const Iterator& other) const
+        {
+            return m_it != other.m_it;
+        }
+
+        /// Returns static description of the current field
+        const FieldInfo& info() const
+        {
+            return *m_it;
+        }
+
+    private:
+        void advance()
+        {
+            if (m_presence) {
+                m_it = m_first + m_presence->next(size_t(m_it - m_first) + 1);
+            } else {
+                ++m_it;
+            }
+        }
+
+    private:
+        const FieldInfo* m_it;
+        NodeT*           m_node;
+        const FieldInfo* m_first;
+        const Presence*  m_presence;
+    };
+
+public:
+    /// Range over all fields or, if presence is given, iteration goes only over the fields marked in it. Indexed access and size are
+    /// always related to the whole table.
+    Fields(NodeT& node, FieldTable table, const Presence* presence = nullptr)
+        : m_node(&node)
+        , m_table(table)
+        , m_presence(presence && *presence ? presence : nullptr)
+    {
+    }
+
+    Iterator begin() const
+    {
+        if (m_presence) {
+            return Iterator(m_table.begin() + m_presence->next(0), m_node, m_table.begin(), m_presence);
+        }
+        return Iterator(m_table.begin(), m_node);
+    }
+
+    Iterator end() const
+    {
+        return Iterator(m_table.end(), m_node);
+    }
+
+    size_t size() const
+    {
+        return m_table.size();
+    }
+
+    bool empty() const
+    {
+        return m_table.size() == 0;
+    }
+
+    AttrT& operator[](size_t index) const
+    {
+        return m_table[index].access(const_cast<INode&>(*m_node));
+    }
+
+    const FieldTable& table() const
+    {
+        return m_table;
+    }
+
+private:
+    NodeT*          m_node;
+    FieldTable      m_table;
+    const Presence* m_presence;
+};
+
+// =========================================================================================================================================
+
+namespace details {
+
+    template <typename T>
+    constexpr Attribute::NodeType nodeType()
+    {
+        if constexpr (std::is_base_of_v<INode, T>) {
+            return Attribute::NodeType::Node;
+        } else if constexpr (std::is_base_of_v<IValue, T>) {
+            return Attribute::NodeType::Value;
+        } else if constexpr (std::is_base_of_v<IEnum, T>) {
+            return Attribute::NodeType::Enum;
+        } else if constexpr (std::is_base_of_v<IList, T>) {
+            return Attribute::NodeType::List;
+        } else if constexpr (std::is_base_of_v<IMap, T>) {
+            return Attribute::NodeType::Map;
+        } else if constexpr (std::is_base_of_v<IVariant, T>) {
+            return Attribute::NodeType::Variant;
+        } else {
+            static_assert(always_false<T>, "Field is not an attribute");
+        }
+    }
+
+    constexpr bool isSpace(char ch)
+    {
+        return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r';
+    }
+
+    /// Picks the name by index from stringified list of META fields ("a, b, c")
+    constexpr std::string_view fieldName(std::string_view names, size_t index)
+    {
+        size_t start = 0;
+        for (size_t i = 0; i < index; ++i) {
+            start = names.find(',', start) + 1;
+        }
+        size_t end = names.find(',', start);
+        if (end == std::string_view::npos) {
+            end = names.size();
+        }
+        while (start < end && isSpace(names[start])) {
+            ++start;
+        }
+        while (end > start && isSpace(names[end - 1])) {
+            --end;
+        }
+        return names.substr(start, end - start);
+    }
+
+    template <typename T, typename Tie, size_t... Is>
+    constexpr std::array<FieldInfo, sizeof...(Is)> makeFields(std::string_view names, std::index_sequence<Is...>)
+    {
+        return {{FieldInfo{
+            fieldName(names, Is),
+            nodeType<std::decay_t<std::tuple_element_t<Is, Tie>>>(),
+            &T::template metaField<Is>,
+            &T::template metaAssign<Is>,
+            &T::template metaMove<Is>,
+            &T::template metaEqual<Is>}...}};
+    }
+
+    template <typename T, typename = void>
+    struct hasEqual : std::false_type
+    {
+    };
+
+    template <typename T>
+    struct hasEqual<T, std::void_t<decltype(bool(std::declval<const T&>() == std::declval<const T&>()))>> : std::true_type
+    {
+    };
+
+    template <typename To, typename From, size_t... Is>
+    void assignFields(To&& to, const From& from, std::index_sequence<Is...>)
+    {
+        ((std::get<Is>(to) = std::as_const(std::get<Is>(from))), ...);
+    }
+
+    template <typename To, typename From, size_t... Is>
+    void moveFields(To&& to, From&& from, std::index_sequence<Is...>)
+    {
+        ((std::get<Is>(to) = std::move(std::get<Is>(from))), ...);
+    }
+
+} // namespace details
+
+// =========================================================================================================================================
+
+/// Creates field table for the class T, Tie is a tuple of references to the fields
+template <typename T, typename Tie>
+constexpr auto makeFields(std::string_view names)
+{
+    return details::makeFields<T, Tie>(names, std::make_index_sequence<std::tuple_size_v<Tie>>{});
+}
+
+/// Concatenates base class fields and own fields
+template <size_t N, size_t M>
+constexpr std::array<FieldInfo, N + M> joinFields(const std::array<FieldInfo, N>& base, const std::array<FieldInfo, M>& own)
+{
+    std::array<FieldInfo, N + M> ret = {};
+    for (size_t i = 0; i < N; ++i) {
+        ret[i] = base[i];
+    }
+    for (size_t i = 0; i < M; ++i) {
+        ret[N + i] = own[i];
+    }
+    return ret;
+}
+
+/// Compares two fields of the same type, typed comparison is used when it's available
+template <typename T>
+bool isEqual(const T& left, const T& right)
+{
+    if constexpr (details::hasEqual<T>::value) {
+        return left == right;
+    } else {
+        return left.compare(right);
+    }
+}
+
+/// Memberwise copy of the fields of the same type, arguments are tuples of references to the fields
+template <typename... To, typename... From>
+void assignFields(std::tuple<To&...> to, std::tuple<From&...> from)
+{
+    static_assert(sizeof...(To) == sizeof...(From), "Fields mismatch");
+    details::assignFields(to, from, std::index_sequence_for<To...>{});
+}
+
+/// Memberwise move of the fields of the same type, arguments are tuples of references to the fields
+template <typename... To, typename... From>
+void moveFields(std::tuple<To&...> to, std::tuple<From&...> from)
+{
+    static_assert(sizeof...(To) == sizeof...(From), "Fields mismatch");
+    details::moveFields(to, from, std::index_sequence_for<To...>{});
+}
+
+// =========================================================================================================================================
+
+} // namespace pack
@@ -0,0 +1,391 @@
+/* =========================================================================================================================================
+    ____ __ _ ____ __  __
+   |    |  ` |    |  /  /
+   | |  | |  | |__|    /
+   | ___| |  | |  |    \
+   |_|  |__,_|____|__\__\ DSO library
+
+   Copyright (C) 2020 Eaton
+   Copyright (C) 2020-2022 zJes
+
+   This program is free software; you can redistribute it and/or modify it under the terms of the GNU Lesser General Public License as
+   published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+========================================================================================================================================= */
+#pragma once
+#include "pack/json-writer.h"
+#include "pack/protobuf-wire.h"
+#include "pack/types/binary.h"
+#include "pack/types/enum.h"
+#include "pack/types/list.h"
+#include "pack/types/value.h"
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+// Support of the code protoc-gen-pack generates for the messages. Generated code knows field numbers, wire types and keys at compile
+// time, the functions below encode and decode the fields exactly as the reflection based providers do.
+
+namespace pack::protobuf {
+
+// =========================================================================================================================================
+
+/// Returns content of the string or bytes value, the buffer keeps the converted string if the value is not kept as std::string
+template <Type ValType>
+inline std::string_view bytesOf(const Value<ValType>& node, std::string& buffer)
+{
+    if constexpr (ValType == Type::Binary) {
+        const auto& value = node.value();
+        return std::string_view(reinterpret_cast<const char*>(value.data()), value.size());
+    } else {
+#ifdef WITH_QTSTRING
+        buffer = toStdString(node.value());
+        return buffer;
+#else
+        (void)buffer;
+        return node.value();
+#endif
+    }
+}
+
+template <Type ValType>
+inline void setBytes(Value<ValType>& node, std::string_view bytes)
+{
+    if constexpr (ValType == Type::Binary) {
+        static_cast<Binary&>(node).setString(bytes.data(), bytes.size());
+    } else {
+        node = fromStdString(std::string(bytes));
+    }
+}
+
+template <Encoding Enc, typename Out>
+inline void writeWire(WireWriter<Out>& out, uint64_t value)
+{
+    if constexpr (wireType<Enc>() == WireType::Fixed32) {
+        out.fixed32(uint32_t(value));
+    } else if constexpr (wireType<Enc>() == WireType::Fixed64) {
+        out.fixed64(value);
+    } else {
+        out.varint(value);
+    }
+}
+
+template <Encoding Enc>
+inline uint64_t readWire(WireReader& in)
+{
+    if constexpr (wireType<Enc>() == WireType::Fixed32) {
+        return in.fixed32();
+    } else if constexpr (wireType<Enc>() == WireType::Fixed64) {
+        return in.fixed64();
+    } else {
+        return in.varint();
+    }
+}
+
+// =========================================================================================================================================
+
+/// Writes the number, zero is written only if the field tracks presence
+template <Encoding Enc, typename Out, Type ValType>
+inline void writeNumber(WireWriter<Out>& out, uint32_t number, const Value<ValType>& node, bool presence)
+{
+    uint64_t value = toWire<Enc>(node.value());
+    if (value || presence) {
+        out.tag(number, wireType<Enc>());
+        writeWire<Enc>(out, value);
+    }
+}
+
+/// Writes the numbers as a single packed field. Size of the content is known up front, so the buffer grows once and the numbers are
+/// written in place.
+template <Encoding Enc, typename Out, typename T>
+inline void writePacked(WireWriter<Out>& out, uint32_t number, const List<T>& list)
+{
+    constexpr size_t width = fixedSize<Enc>();
+    if (list.empty()) {
+        return;
+    }
+
+    size_t size = 0;
+    if constexpr (width != 0) {
+        size = size_t(list.size()) * width;
+    } else {
+        for (const auto& it : list) {
+            size += varintSize(toWire<Enc>(it.value()));
+        }
+    }
+    out.tag(number, WireType::Length);
+    out.varint(size);
+
+    char* ptr = out.extend(size);
+    for (const auto& it : list) {
+        if constexpr (width != 0) {
+            ptr = writeFixed<width>(ptr, toWire<Enc>(it.value()));
+        } else {
+            ptr = writeVarint(ptr, toWire<Enc>(it.value()));
+        }
+    }
+}
+
+/// Writes the numbers, packed ones share a single tag
+template <Encoding Enc, typename Out, typename T>
+inline void writeNumbers(WireWriter<Out>& out, uint32_t number, const List<T>& list, bool packed)
+{
+    if (packed) {
+        writePacked<Enc>(out, number, list);
+    } else {
+        for (const auto& it : list) {
+            out.tag(number, wireType<Enc>());
+            writeWire<Enc>(out, toWire<Enc>(it.value()));
+        }
+    }
+}
+
+/// Writes the string or bytes, empty value is written only if the field tracks presence
+template <typename Out, Type ValType>
+inline void writeBytes(WireWriter<Out>& out, uint32_t number, const Value<ValType>& node, bool presence)
+{
+    std::string      buffer;
+    std::string_view value = bytesOf(node, buffer);
+    if (!value.empty() || presence) {
+        out.tag(number, WireType::Length);
+        out.bytes(value.data(), value.size());
+    }
+}
+
+template <typename Out, typename T>
+inline void writeBytes(WireWriter<Out>& out, uint32_t number, const List<T>& list)
+{
+    std::string buffer;
+    for (const auto& it : list) {
+        std::string_view value = bytesOf(it, buffer);
+        out.tag(number, WireType::Length);
+        out.bytes(value.data(), value.size());
+    }
+}
+
+/// Writes the number of the enum value, zero is written only if the field tracks presence
+template <typename Out>
+inline void writeEnum(WireWriter<Out>& out, uint32_t number, const IEnum& en, bool presence)
+{
+    int value = en.asInt();
+    if (value || presence) {
+        out.tag(number, WireType::Varint);
+        out.varint(uint64_t(int64_t(value)));
+    }
+}
+
+/// Writes embedded message with its generated code
+template <typename Out, typename T>
+inline void writeMessage(WireWriter<Out>& out, uint32_t number, const T& message)
+{
+    out.tag(number, WireType::Length);
+    size_t start = out.beginLength();
+    message.serializeTo(out);
+    out.endLength(start);
+}
+
+template <typename Out, typename T>
+inline void writeMessages(WireWriter<Out>& out, uint32_t number, const List<T>& list)
+{
+    for (const auto& it : list) {
+        writeMessage(out, number, it);
+    }
+}
+
+/// Proto2 required fields should have a value, the fields are given as pairs of the name and presence of the value
+inline void checkRequired(const char* message, std::initializer_list<std::pair<const char*, bool>> fields)
+{
+    std::string missing;
+    for (const auto& [name, present] : fields) {
+        if (!present) {
+            missing += (missing.empty() ? "" : ", ") + std::string(name);
+        }
+    }
+    if (!missing.empty()) {
+        throw std::runtime_error("Message " + std::string(message) + " is missing required fields: " + missing);
+    }
+}
+
+// =========================================================================================================================================
+
+// Readers of the fields return false if the value has other wire type than the field accepts, the caller skips it then
+
+template <Encoding Enc, Type ValType>
+inline bool readNumber(WireReader& in, WireType type, Value<ValType>& node)
+{
+    if (type != wireType<Enc>()) {
+        return false;
+    }
+    node = fromWire<Enc, typename Value<ValType>::CppType>(readWire<Enc>(in));
+    return true;
+}
+
+/// Appends the packed numbers. Count of them is known before reading: by the size for fixed ones, by the last bytes for varints, so
+/// the list is reserved once.
+template <Encoding Enc, typename T>
+inline void appendPacked(std::string_view bytes, List<T>& list)
+{
+    using CppType          = typename T::CppType;
+    constexpr size_t width = fixedSize<Enc>();
+
+    size_t count = 0;
+    if constexpr (width != 0) {
+        if (bytes.size() % width) {
+            WireReader::malformed();
+        }
+        count = bytes.size() / width;
+    } else {
+        for (char ch : bytes) {
+            count += (uint8_t(ch) & 0x80) ? 0 : 1;
+        }
+    }
+    if (!count) {
+        return;
+    }
+
+    auto& items = list.toVector();
+    items.reserve(items.size() + count);
+    if constexpr (width != 0) {
+        for (const char* ptr = bytes.data(); ptr != bytes.data() + bytes.size(); ptr += width) {
+            items.emplace_back(fromWire<Enc, CppType>(readFixed<width>(ptr)));
+        }
+    } else {
+        WireReader packed(bytes);
+        while (!packed.atEnd()) {
+            items.emplace_back(fromWire<Enc, CppType>(packed.varint()));
+        }
+    }
+}
+
+/// Appends the items, packed numbers are accepted for any repeated numeric field
+template <Encoding Enc, typename T>
+inline bool readNumbers(WireReader& in, WireType type, List<T>& list)
+{
+    using CppType = typename T::CppType;
+
+    if (type == WireType::Length) {
+        appendPacked<Enc>(in.bytes(), list);
+        return true;
+    }
+    if (type != wireType<Enc>()) {
+        return false;
+    }
+    list.append(fromWire<Enc, CppType>(readWire<Enc>(in)));
+    return true;
+}
+
+template <Type ValType>
+inline bool readBytes(WireReader& in, WireType type, Value<ValType>& node)
+{
+    if (type != WireType::Length) {
+        return false;
+    }
+    setBytes(node, in.bytes());
+    return true;
+}
+
+template <typename T>
+inline bool readBytes(WireReader& in, WireType type, List<T>& list)
+{
+    if (type != WireType::Length) {
+        return false;
+    }
+    setBytes(list.append(), in.bytes());
+    return true;
+}
+
+inline bool readEnum(WireReader& in, WireType type, IEnum& en)
+{
+    if (type != WireType::Varint) {
+        return false;
+    }
+    en.fromInt(int32_t(in.varint()));
+    return true;
+}
+
+/// Merges embedded message into the current value, as protobuf does
+template <typename T>
+inline bool readMessage(WireReader& in, WireType type, T& message)
+{
+    if (type != WireType::Length) {
+        return false;
+    }
+    message.parseFrom(in.bytes(), in.nestedDepth());
+    return true;
+}
+
+/// Appends the message, fields which are not in the message get the protobuf defaults
+template <typename T>
+inline bool readMessages(WireReader& in, WireType type, List<T>& list)
+{
+    if (type != WireType::Length) {
+        return false;
+    }
+    std::string_view bytes = in.bytes();
+    T&               item  = list.append();
+    item.resetProto();
+    item.parseFrom(bytes, in.nestedDepth());
+    return true;
+}
+
+// =========================================================================================================================================
+
+} // namespace pack::protobuf
+
+namespace pack::json {
+
+// =========================================================================================================================================
+
+// Writers of the fields are called for the fields which have a value or if the defaults are written
+
+template <typename Out, Type ValType>
+inline void writeValue(JsonWriter<Out>& out, const Value<ValType>& node)
+{
+    out.value(node.value());
+}
+
+template <typename Out>
+inline void writeEnum(JsonWriter<Out>& out, const IEnum& en)
+{
+    out.string(toStdString(en.asString()));
+}
+
+/// Writes the items, item without a value is null unless the defaults are written
+template <typename Out, typename T>
+inline void writeValues(JsonWriter<Out>& out, const List<T>& list, Option opt)
+{
+    const bool withDefaults = isSet(opt, Option::WithDefaults);
+
+    out.beginArray();
+    for (const auto& it : list) {
+        out.item();
+        if (withDefaults || it.hasValue()) {
+            out.value(it.value());
+        } else {
+            out.null();
+        }
+    }
+    out.endArray();
+}
+
+/// Writes the messages with their generated code
+template <typename Out, typename T>
+inline void writeMessages(JsonWriter<Out>& out, const List<T>& list, Option opt)
+{
+    out.beginArray();
+    for (const auto& it : list) {
+        out.item();
+        it.serializeTo(out, opt);
+    }
+    out.endArray();
+}
+
+// =========================================================================================================================================
+
+} // namespace pack::json
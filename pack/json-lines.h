@@ -0,0 +1,126 @@
+/* =========================================================================================================================================
+    ____ __ _ ____ __  __
+   |    |  ` |    |  /  /
+   | |  | |  | |__|    /
+   | ___| |  | |  |    \
+   |_|  |__,_|____|__\__\ DSO library
+
+   Copyright (C) 2020 Eaton
+   Copyright (C) 2020-2022 zJes
+
+   This program is free software; you can redistribute it and/or modify it under the terms of the GNU Lesser General Public License as
+   published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+========================================================================================================================================= */
+#pragma once
+#include "pack/serialization.h"
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pack::json {
+
+// =========================================================================================================================================
+
+/// Reads json lines (NDJSON): one json document per line with the given parser. Input is read by big chunks, parser state is kept between
+/// the records.
+class BasicLinesReader
+{
+public:
+    static constexpr size_t DefaultBufferSize = 1 << 16;
+
+    explicit BasicLinesReader(std::istream& stream, Parser parser = Parser::Sax, size_t bufferSize = DefaultBufferSize);
+    explicit BasicLinesReader(int fd, Parser parser = Parser::Sax, size_t bufferSize = DefaultBufferSize);
+    ~BasicLinesReader();
+
+    BasicLinesReader(const BasicLinesReader&) = delete;
+    BasicLinesReader& operator=(const BasicLinesReader&) = delete;
+
+    /// Clears the attribute and reads the next record into it, returns false at the end of the input. Empty lines are skipped.
+    Expected<bool> read(Attribute& record);
+
+    /// Returns number of the line of the last read record
+    size_t line() const;
+
+private:
+    struct State;
+
+    /// Returns the next not empty line, false at the end of the input
+    Expected<bool> nextLine(std::string_view& line);
+
+    /// Reads more data into the buffer, sets eof flag at the end of the input
+    Expected<void> fill();
+
+private:
+    std::istream*          m_stream = nullptr;
+    int                    m_fd     = -1;
+    Parser                 m_parser;
+    std::vector<char>      m_buffer;
+    size_t                 m_begin = 0;
+    size_t                 m_end   = 0;
+    size_t                 m_line  = 0;
+    bool                   m_eof   = false;
+    std::unique_ptr<State> m_state;
+};
+
+// =========================================================================================================================================
+
+/// Reads json lines records of the type T, the record object is reused for all of them
+template <typename T>
+class LinesReader : public BasicLinesReader
+{
+public:
+    using BasicLinesReader::BasicLinesReader;
+
+    /// Reads the next record, returns nullptr at the end of the input. The record is owned by the reader and valid till the next call.
+    Expected<T*> next()
+    {
+        auto ret = read(m_record);
+        if (!ret) {
+            return unexpected(ret.error());
+        }
+        return *ret ? &m_record : nullptr;
+    }
+
+private:
+    T m_record;
+};
+
+// =========================================================================================================================================
+
+/// Writes json lines (NDJSON): every record is serialized into one line. Lines are collected in the buffer and written to the output by
+/// big chunks, the rest is written on flush() or destruction.
+class LinesWriter
+{
+public:
+    static constexpr size_t DefaultBufferSize = 1 << 16;
+
+    explicit LinesWriter(std::ostream& stream, Option opt = Option::No, size_t bufferSize = DefaultBufferSize);
+    explicit LinesWriter(int fd, Option opt = Option::No, size_t bufferSize = DefaultBufferSize);
+    ~LinesWriter();
+
+    LinesWriter(const LinesWriter&) = delete;
+    LinesWriter& operator=(const LinesWriter&) = delete;
+
+    /// Appends the record, PrettyPrint option is ignored as the record should fit one line
+    Expected<void> write(const Attribute& record);
+
+    /// Writes buffered records to the output
+    Expected<void> flush();
+
+private:
+    std::ostream* m_stream = nullptr;
+    int           m_fd     = -1;
+    Option        m_opt;
+    size_t        m_bufferSize;
+    std::string   m_buffer;
+};
+
+// =========================================================================================================================================
+
+} // namespace pack::json
@@ -0,0 +1,350 @@
+/* =========================================================================================================================================
+    ____ __ _ ____ __  __
+   |    |  ` |    |  /  /
+   | |  | |  | |__|    /
+   | ___| |  | |  |    \
+   |_|  |__,_|____|__\__\ DSO library
+
+   Copyright (C) 2020 Eaton
+   Copyright (C) 2020-2022 zJes
+
+   This program is free software; you can redistribute it and/or modify it under the terms of the GNU Lesser General Public License as
+   published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+========================================================================================================================================= */
+#pragma once
+#include "pack/serialization.h"
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace pack::json {
+
+// =========================================================================================================================================
+
+/// Writes json text directly into the output buffer (std::string or std::vector<char>), without building of the document tree. Output is
+/// the same as nlohmann dump() gives for the same document: compact or indented by 4 spaces.
+template <typename Out = std::string>
+class JsonWriter
+{
+public:
+    /// Incremental serialization keeps written text of the nodes
+    using Fragment = std::string;
+
+    JsonWriter(Out& out, bool pretty)
+        : m_out(out)
+        , m_pretty(pretty)
+    {
+    }
+
+public:
+    void beginObject()
+    {
+        put('{');
+        ++m_depth;
+        m_first = true;
+    }
+
+    void endObject()
+    {
+        close('}');
+    }
+
+    void beginArray()
+    {
+        put('[');
+        ++m_depth;
+        m_first = true;
+    }
+
+    void endArray()
+    {
+        close(']');
+    }
+
+    /// Starts a member of the current object, the value should be written next
+    void key(std::string_view name)
+    {
+        separate();
+        string(name);
+        put(m_pretty ? ": " : ":");
+    }
+
+    /// Starts an item of the current array, the value should be written next
+    void item()
+    {
+        separate();
+    }
+
+public:
+    void null()
+    {
+        put("null");
+    }
+
+    void boolean(bool value)
+    {
+        put(value ? "true" : "false");
+    }
+
+    template <typename T>
+    void integer(T value)
+    {
+        char buf[24];
+        auto res = std::to_chars(buf, buf + sizeof(buf), value);
+        put(std::string_view(buf, size_t(res.ptr - buf)));
+    }
+
+    /// Writes shortest round trip representation of the number, formatted like nlohmann does: fixed notation with ".0" for the
+    /// integral values, exponent for the numbers out of [1e-5, 1e15].
+    void number(double value)
+    {
+        if (!std::isfinite(value)) {
+            null();
+            return;
+        }
+        if (value == 0) {
+            put(std::signbit(value) ? "-0.0" : "0.0");
+            return;
+        }
+
+        char buf[32];
+        auto res = std::to_chars(buf, buf + sizeof(buf), value, std::chars_format::scientific);
+
+        std::string_view sci(buf, size_t(res.ptr - buf));
+        if (sci.front() == '-') {
+            put('-');
+            sci.remove_prefix(1);
+        }
+
+        size_t epos = sci.find('e');
+        char   digits[20];
+        int    len = 0;
+        for (char ch : sci.substr(0, epos)) {
+            if (ch != '.') {
+                digits[len++] = ch;
+            }
+        }
+        int exp = 0;
+        std::from_chars(sci.data() + epos + (sci[epos + 1] == '+' ? 2 : 1), sci.data() + sci.size(), exp);
+
+        const int n = exp + 1;
+        if (len <= n && n <= 15) {
+            put(std::string_view(digits, size_t(len)));
+            fill(size_t(n - len), '0');
+            put(".0");
+        } else if (0 < n && n <= 15) {
+            put(std::string_view(digits, size_t(n)));
+            put('.');
+            put(std::string_view(digits + n, size_t(len - n)));
+        } else if (-4 < n && n <= 0) {
+            put("0.");
+            fill(size_t(-n), '0');
+            put(std::string_view(digits, size_t(len)));
+        } else {
+            put(digits[0]);
+            if (len > 1) {
+                put('.');
+                put(std::string_view(digits + 1, size_t(len - 1)));
+            }
+            put(exp < 0 ? "e-" : "e+");
+            if (std::abs(exp) < 10) {
+                put('0');
+            }
+            integer(std::abs(exp));
+        }
+    }
+
+    void string(std::string_view value)
+    {
+        static constexpr char hex[] = "0123456789abcdef";
+
+        put('"');
+        size_t from = 0;
+        for (size_t i = 0; i < value.size(); ++i) {
+            auto ch = static_cast<unsigned char>(value[i]);
+            if (ch >= 0x80) {
+                // Multibyte sequence is written as is, invalid UTF-8 is rejected as nlohmann dump() does
+                size_t size = utf8Size(value, i);
+                if (!size) {
+                    invalidUtf8(i, ch);
+                }
+                i += size - 1;
+                continue;
+            }
+            if (ch >= 0x20 && ch != '"' && ch != '\\') {
+                continue;
+            }
+            put(value.substr(from, i - from));
+            from = i + 1;
+            switch (ch) {
+            case '"':
+                put("\\\"");
+                break;
+            case '\\':
+                put("\\\\");
+                break;
+            case '\b':
+                put("\\b");
+                break;
+            case '\f':
+                put("\\f");
+                break;
+            case '\n':
+                put("\\n");
+                break;
+            case '\r':
+                put("\\r");
+                break;
+            case '\t':
+                put("\\t");
+                break;
+            default:
+                put("\\u00");
+                put(hex[ch >> 4]);
+                put(hex[ch & 0xf]);
+            }
+        }
+        put(value.substr(from));
+        put('"');
+    }
+
+    /// Writes the value of the scalar type: bytes are written as array of numbers, strings are escaped
+    template <typename T>
+    void value(const T& val)
+    {
+        if constexpr (std::is_same_v<T, bool>) {
+            boolean(val);
+        } else if constexpr (std::is_floating_point_v<T>) {
+            number(double(val));
+        } else if constexpr (std::is_integral_v<T>) {
+            integer(val);
+        } else if constexpr (std::is_same_v<T, std::vector<std::byte>>) {
+            beginArray();
+            for (auto byte : val) {
+                item();
+                integer(std::to_integer<unsigned>(byte));
+            }
+            endArray();
+        } else {
+            string(toStdString(val));
+        }
+    }
+
+public:
+    size_t mark() const
+    {
+        return m_out.size();
+    }
+
+    Fragment fragment(size_t mark) const
+    {
+        return Fragment(m_out.begin() + std::ptrdiff_t(mark), m_out.end());
+    }
+
+    void append(const Fragment& fragment)
+    {
+        put(fragment);
+    }
+
+    /// Indented text depends on the nesting level, so pretty printed fragments are kept per level
+    uint32_t cacheKey(Option opt) const
+    {
+        return m_pretty ? uint32_t(opt) | uint32_t(m_depth) << 16 : uint32_t(opt);
+    }
+
+private:
+    void separate()
+    {
+        if (!m_first) {
+            put(',');
+        }
+        m_first = false;
+        if (m_pretty) {
+            indent();
+        }
+    }
+
+    /// Returns size of the well-formed UTF-8 sequence which starts at the position, 0 if it's not one
+    static size_t utf8Size(std::string_view value, size_t pos)
+    {
+        auto byte = [&](size_t offset) {
+            return pos + offset < value.size() ? static_cast<unsigned char>(value[pos + offset]) : 0;
+        };
+        auto inRange = [](unsigned char ch, unsigned char from, unsigned char to) {
+            return ch >= from && ch <= to;
+        };
+
+        unsigned char lead = byte(0);
+        if (inRange(lead, 0xc2, 0xdf)) {
+            return inRange(byte(1), 0x80, 0xbf) ? 2 : 0;
+        }
+        if (inRange(lead, 0xe0, 0xef)) {
+            unsigned char from = lead == 0xe0 ? 0xa0 : 0x80;
+            unsigned char to   = lead == 0xed ? 0x9f : 0xbf;
+            return inRange(byte(1), from, to) && inRange(byte(2), 0x80, 0xbf) ? 3 : 0;
+        }
+        if (inRange(lead, 0xf0, 0xf4)) {
+            unsigned char from = lead == 0xf0 ? 0x90 : 0x80;
+            unsigned char to   = lead == 0xf4 ? 0x8f : 0xbf;
+            return inRange(byte(1), from, to) && inRange(byte(2), 0x80, 0xbf) && inRange(byte(3), 0x80, 0xbf) ? 4 : 0;
+        }
+        return 0;
+    }
+
+    [[noreturn]] static void invalidUtf8(size_t pos, unsigned char ch)
+    {
+        static constexpr char hex[] = "0123456789ABCDEF";
+        throw std::runtime_error("invalid UTF-8 byte at index " + std::to_string(pos) + ": 0x" + hex[ch >> 4] + hex[ch & 0xf]);
+    }
+
+    void close(char ch)
+    {
+        --m_depth;
+        if (m_pretty && !m_first) {
+            indent();
+        }
+        put(ch);
+        m_first = false;
+    }
+
+    void indent()
+    {
+        put('\n');
+        fill(size_t(m_depth) * 4, ' ');
+    }
+
+    void put(char ch)
+    {
+        m_out.push_back(ch);
+    }
+
+    void put(std::string_view str)
+    {
+        m_out.insert(m_out.end(), str.begin(), str.end());
+    }
+
+    void fill(size_t count, char ch)
+    {
+        m_out.insert(m_out.end(), count, ch);
+    }
+
+private:
+    Out&         m_out;
+    bool         m_pretty;
+    int          m_depth = 0;
+    bool         m_first = true;
+};
+
+// =========================================================================================================================================
+
+} // namespace pack::json
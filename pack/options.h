@@ -19,6 +19,9 @@
 #pragma once
 #include "pack/convert.h"
 #include <any>
+#include <memory>
+#include <mutex>
+#include <optional>
 
 namespace pack {
 
@@ -53,26 +56,30 @@ struct Default : public FieldOption
     template <typename T>
     T get() const
     {
-        if (value.type() == typeid(int32_t)) {
-            return convert<T>(std::any_cast<int32_t>(value));
-        } else if (value.type() == typeid(int64_t)) {
-            return convert<T>(std::any_cast<int64_t>(value));
-        } else if (value.type() == typeid(uint32_t)) {
-            return convert<T>(std::any_cast<uint32_t>(value));
-        } else if (value.type() == typeid(uint64_t)) {
-            return convert<T>(std::any_cast<uint64_t>(value));
-        } else if (value.type() == typeid(float)) {
-            return convert<T>(std::any_cast<float>(value));
-        } else if (value.type() == typeid(double)) {
-            return convert<T>(std::any_cast<double>(value));
-        } else if (value.type() == typeid(bool)) {
-            return convert<T>(std::any_cast<bool>(value));
-        } else if (value.type() == typeid(const char*)) {
-            return convert<T>(std::any_cast<const char*>(value));
-        } else if (value.type() == typeid(string_t)) {
-            return convert<T>(std::any_cast<string_t>(value));
+        if constexpr (std::is_enum_v<T>) {
+            return std::any_cast<T>(value);
+        } else {
+            if (value.type() == typeid(int32_t)) {
+                return convert<T>(std::any_cast<int32_t>(value));
+            } else if (value.type() == typeid(int64_t)) {
+                return convert<T>(std::any_cast<int64_t>(value));
+            } else if (value.type() == typeid(uint32_t)) {
+                return convert<T>(std::any_cast<uint32_t>(value));
+            } else if (value.type() == typeid(uint64_t)) {
+                return convert<T>(std::any_cast<uint64_t>(value));
+            } else if (value.type() == typeid(float)) {
+                return convert<T>(std::any_cast<float>(value));
+            } else if (value.type() == typeid(double)) {
+                return convert<T>(std::any_cast<double>(value));
+            } else if (value.type() == typeid(bool)) {
+                return convert<T>(std::any_cast<bool>(value));
+            } else if (value.type() == typeid(const char*)) {
+                return convert<T>(std::any_cast<const char*>(value));
+            } else if (value.type() == typeid(string_t)) {
+                return convert<T>(std::any_cast<string_t>(value));
+            }
+            return convert<T>(std::any_cast<T>(value));
         }
-        return convert<T>(std::any_cast<T>(value));
     }
 
     std::any value;
@@ -83,7 +90,7 @@ struct Default : public FieldOption
 template <typename... Args>
 constexpr auto allIsOptions()
 {
-    return (std::is_base_of<FieldOption, Args>::value && ...);
+    return (std::is_base_of<FieldOption, std::decay_t<Args>>::value && ...);
 }
 
 template <>
@@ -116,4 +123,82 @@ constexpr const T* pickOption(const Options&... opts)
 
 // =========================================================================================================================================
 
+/// Field declaration: key and default shared by all instances of the field. FIELD creates one static declaration per member, so the
+/// options are evaluated and the default is converted to the field type only once, not on every construction of the owning node.
+class Declaration : public FieldOption
+{
+public:
+    template <typename... Options, typename = isOptions<Options...>>
+    explicit Declaration(const string_t& key, Options&&... opts)
+        : m_key(key)
+    {
+        if (auto ret = pickOption<Default>(opts...)) {
+            m_default = *ret;
+        }
+    }
+
+    Declaration(const Declaration&) = delete;
+    Declaration& operator=(const Declaration&) = delete;
+
+    /// Returns the key of the field
+    const string_t& key() const
+    {
+        return m_key;
+    }
+
+    /// Returns default value converted to T, conversion is done once on first request
+    template <typename T>
+    const T& defaultValue() const;
+
+private:
+    string_t               m_key;
+    std::optional<Default> m_default;
+    mutable std::once_flag m_once;
+    mutable std::any       m_value;
+};
+
+// =========================================================================================================================================
+
+/// Returns a reference to the value-initialized T shared by all attributes without default
+template <typename T>
+const T& emptyValue()
+{
+    if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+        static constexpr T value = {};
+        return value;
+    } else {
+        static const T value = {};
+        return value;
+    }
+}
+
+template <typename T>
+const T& Declaration::defaultValue() const
+{
+    if (!m_default) {
+        return emptyValue<T>();
+    }
+    std::call_once(m_once, [&]() {
+        m_value = m_default->template get<T>();
+    });
+    return *std::any_cast<T>(&m_value);
+}
+
+/// Resolves the default value of the attribute from the options. Default of the declaration is shared by all instances of the field,
+/// default passed directly via pack::Default is converted into the storage owned by the attribute.
+template <typename T, typename... Options>
+const T& defaultValue(std::unique_ptr<const T>& own, const Options&... opts)
+{
+    if (auto ret = pickOption<Declaration>(opts...)) {
+        return ret->template defaultValue<T>();
+    }
+    if (auto ret = pickOption<Default>(opts...)) {
+        own = std::make_unique<const T>(ret->template get<T>());
+        return *own;
+    }
+    return emptyValue<T>();
+}
+
+// =========================================================================================================================================
+
 } // namespace pack
@@ -0,0 +1,82 @@
+/* =========================================================================================================================================
+    ____ __ _ ____ __  __
+   |    |  ` |    |  /  /
+   | |  | |  | |__|    /
+   | ___| |  | |  |    \
+   |_|  |__,_|____|__\__\ DSO library
+
+   Copyright (C) 2020 Eaton
+   Copyright (C) 2020-2022 zJes
+
+   This program is free software; you can redistribute it and/or modify it under the terms of the GNU Lesser General Public License as
+   published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+========================================================================================================================================= */
+#pragma once
+
+#include "pack/pack.h"
+
+namespace pack {
+
+// =========================================================================================================================================
+
+/// Single change of the patch. Path addresses the changed attribute starting from the patched root: field keys for the nodes, indexes
+/// for the lists and keys for the maps, variants are stepped through. Value is a json form of the new attribute value.
+class Change : public Node
+{
+public:
+    enum class Operation
+    {
+        Set,
+        Insert,
+        Remove
+    };
+
+public:
+    using Node::Node;
+
+public:
+    Enum<Operation> operation = FIELD("op");
+    StringList      path      = FIELD("path");
+    String          value     = FIELD("value");
+
+    META(Change, operation, path, value);
+
+public:
+    const std::string& fileDescriptor() const override;
+    std::string        protoName() const override;
+};
+
+// =========================================================================================================================================
+
+/// Ordered set of changes which turns one attribute into another. Is a regular node, so could be stored by any provider.
+class Patch : public Node
+{
+public:
+    using Node::Node;
+
+public:
+    List<Change> changes = FIELD("changes");
+
+    META(Patch, changes);
+
+public:
+    const std::string& fileDescriptor() const override;
+    std::string        protoName() const override;
+};
+
+// =========================================================================================================================================
+
+/// Makes a patch which turns attribute `from` into `to`, both of them should be of the same type
+Expected<Patch> diff(const Attribute& from, const Attribute& to);
+
+/// Applies the patch to the attribute, changes are applied in order and processing stops on the first failed one
+Expected<void> apply(const Patch& patch, Attribute& attr);
+
+// =========================================================================================================================================
+
+} // namespace pack
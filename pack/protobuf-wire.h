@@ -0,0 +1,461 @@
+/* =========================================================================================================================================
+    ____ __ _ ____ __  __
+   |    |  ` |    |  /  /
+   | |  | |  | |__|    /
+   | ___| |  | |  |    \
+   |_|  |__,_|____|__\__\ DSO library
+
+   Copyright (C) 2020 Eaton
+   Copyright (C) 2020-2022 zJes
+
+   This program is free software; you can redistribute it and/or modify it under the terms of the GNU Lesser General Public License as
+   published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+========================================================================================================================================= */
+#pragma once
+#include "pack/serialization.h"
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace pack::protobuf {
+
+// =========================================================================================================================================
+
+/// Wire types of the protobuf encoding
+enum class WireType : uint32_t
+{
+    Varint     = 0,
+    Fixed64    = 1,
+    Length     = 2,
+    StartGroup = 3,
+    EndGroup   = 4,
+    Fixed32    = 5
+};
+
+/// Reinterprets the bits of the value, floats are kept on the wire by their IEEE representation
+template <typename To, typename From>
+inline To bitCast(From value)
+{
+    static_assert(sizeof(To) == sizeof(From));
+    To ret;
+    std::memcpy(&ret, &value, sizeof(To));
+    return ret;
+}
+
+inline uint32_t zigzag(int32_t value)
+{
+    return (uint32_t(value) << 1) ^ uint32_t(value >> 31);
+}
+
+inline uint64_t zigzag(int64_t value)
+{
+    return (uint64_t(value) << 1) ^ uint64_t(value >> 63);
+}
+
+inline int32_t unzigzag(uint32_t value)
+{
+    return int32_t((value >> 1) ^ (~(value & 1) + 1));
+}
+
+inline int64_t unzigzag(uint64_t value)
+{
+    return int64_t((value >> 1) ^ (~(value & 1) + 1));
+}
+
+/// Returns count of bytes the value takes as varint
+inline size_t varintSize(uint64_t value)
+{
+    size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        ++size;
+    }
+    return size;
+}
+
+/// Writes the value as varint into the memory, returns the position after it
+inline char* writeVarint(char* ptr, uint64_t value)
+{
+    while (value >= 0x80) {
+        *ptr++ = char(value | 0x80);
+        value >>= 7;
+    }
+    *ptr++ = char(value);
+    return ptr;
+}
+
+/// Writes little endian value of the size into the memory, returns the position after it. Byte loop is folded by compilers into a
+/// single store.
+template <size_t Size>
+inline char* writeFixed(char* ptr, uint64_t value)
+{
+    for (size_t i = 0; i < Size; ++i) {
+        ptr[i] = char(value >> (i * 8));
+    }
+    return ptr + Size;
+}
+
+template <size_t Size>
+inline uint64_t readFixed(const char* ptr)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < Size; ++i) {
+        value |= uint64_t(uint8_t(ptr[i])) << (i * 8);
+    }
+    return value;
+}
+
+// =========================================================================================================================================
+
+/// Encodings of the scalar protobuf types, the generated code knows them at compile time
+enum class Encoding
+{
+    /// int32, int64, uint32, uint64, enum
+    Varint,
+    Bool,
+    /// sint32
+    ZigZag32,
+    /// sint64
+    ZigZag64,
+    /// fixed32, sfixed32
+    Fixed32,
+    /// fixed64, sfixed64
+    Fixed64,
+    Float,
+    Double
+};
+
+/// Returns wire type of the value of the encoding
+template <Encoding Enc>
+constexpr WireType wireType()
+{
+    if constexpr (Enc == Encoding::Fixed32 || Enc == Encoding::Float) {
+        return WireType::Fixed32;
+    } else if constexpr (Enc == Encoding::Fixed64 || Enc == Encoding::Double) {
+        return WireType::Fixed64;
+    } else {
+        return WireType::Varint;
+    }
+}
+
+/// Returns size of the value of the encoding on the wire, 0 for varints
+template <Encoding Enc>
+constexpr size_t fixedSize()
+{
+    if constexpr (wireType<Enc>() == WireType::Fixed32) {
+        return 4;
+    } else if constexpr (wireType<Enc>() == WireType::Fixed64) {
+        return 8;
+    } else {
+        return 0;
+    }
+}
+
+/// Returns the number as it is kept on the wire
+template <Encoding Enc, typename T>
+inline uint64_t toWire(T value)
+{
+    if constexpr (Enc == Encoding::ZigZag32) {
+        return zigzag(int32_t(value));
+    } else if constexpr (Enc == Encoding::ZigZag64) {
+        return zigzag(int64_t(value));
+    } else if constexpr (Enc == Encoding::Float) {
+        return bitCast<uint32_t>(float(value));
+    } else if constexpr (Enc == Encoding::Double) {
+        return bitCast<uint64_t>(double(value));
+    } else if constexpr (std::is_signed_v<T>) {
+        return uint64_t(int64_t(value));
+    } else {
+        return uint64_t(value);
+    }
+}
+
+/// Returns the number kept on the wire as the value of the type
+template <Encoding Enc, typename T>
+inline T fromWire(uint64_t value)
+{
+    if constexpr (Enc == Encoding::ZigZag32) {
+        return T(unzigzag(uint32_t(value)));
+    } else if constexpr (Enc == Encoding::ZigZag64) {
+        return T(unzigzag(value));
+    } else if constexpr (Enc == Encoding::Float) {
+        return T(bitCast<float>(uint32_t(value)));
+    } else if constexpr (Enc == Encoding::Double) {
+        return T(bitCast<double>(value));
+    } else if constexpr (Enc == Encoding::Bool) {
+        return T(value != 0);
+    } else {
+        return T(value);
+    }
+}
+
+// =========================================================================================================================================
+
+/// Incremental serialization keeps encoded content of the nodes, own type keeps it apart from the text fragments of other providers
+struct WireFragment
+{
+    std::string bytes;
+};
+
+/// Writes protobuf wire format directly into the output buffer (std::string or std::vector<char>). Content of the length delimited
+/// fields is written in place: one byte is reserved for the length and the content is moved only if the length needs more.
+template <typename Out = std::string>
+class WireWriter
+{
+public:
+    using Fragment = WireFragment;
+
+    explicit WireWriter(Out& out)
+        : m_out(out)
+    {
+    }
+
+public:
+    void tag(uint32_t number, WireType type)
+    {
+        varint(uint64_t(number) << 3 | uint32_t(type));
+    }
+
+    void varint(uint64_t value)
+    {
+        char buf[10];
+        m_out.insert(m_out.end(), buf, writeVarint(buf, value));
+    }
+
+    void fixed32(uint32_t value)
+    {
+        char buf[4];
+        m_out.insert(m_out.end(), buf, writeFixed<4>(buf, value));
+    }
+
+    void fixed64(uint64_t value)
+    {
+        char buf[8];
+        m_out.insert(m_out.end(), buf, writeFixed<8>(buf, value));
+    }
+
+    void bytes(const char* data, size_t size)
+    {
+        varint(size);
+        m_out.insert(m_out.end(), data, data + size);
+    }
+
+    /// Appends the space of the size, returns its position to be filled by the caller
+    char* extend(size_t size)
+    {
+        size_t pos = m_out.size();
+        m_out.resize(pos + size);
+        return &m_out[pos];
+    }
+
+    /// Starts length delimited content, returns position of the content to pass into endLength()
+    size_t beginLength()
+    {
+        m_out.push_back(0);
+        return m_out.size();
+    }
+
+    /// Writes the length of the content started at the position. Content of 128 bytes and more is moved to make room for the length, as
+    /// the enclosing messages are moved again when they end, the innermost bytes of big nested messages are moved once per level. Sizes
+    /// are not computed in advance to keep writing in one pass.
+    void endLength(size_t start)
+    {
+        size_t length = m_out.size() - start;
+        size_t size   = varintSize(length);
+        if (size > 1) {
+            m_out.insert(m_out.begin() + std::ptrdiff_t(start), size - 1, 0);
+        }
+        char* ptr = &m_out[start - 1];
+        while (length >= 0x80) {
+            *ptr++ = char(length | 0x80);
+            length >>= 7;
+        }
+        *ptr = char(length);
+    }
+
+public:
+    size_t mark() const
+    {
+        return m_out.size();
+    }
+
+    Fragment fragment(size_t mark) const
+    {
+        return {std::string(m_out.begin() + std::ptrdiff_t(mark), m_out.end())};
+    }
+
+    void append(const Fragment& fragment)
+    {
+        m_out.insert(m_out.end(), fragment.bytes.begin(), fragment.bytes.end());
+    }
+
+    uint32_t cacheKey(Option opt) const
+    {
+        return uint32_t(opt);
+    }
+
+private:
+    Out& m_out;
+};
+
+// =========================================================================================================================================
+
+/// Reads protobuf wire format from the caller memory, values of the length delimited fields are views into it. Depth is the nesting of
+/// the embedded message the data belongs to, as protobuf the reader refuses messages and groups nested deeper than MaxDepth.
+class WireReader
+{
+public:
+    static constexpr int MaxDepth = 100;
+
+    explicit WireReader(std::string_view data, int depth = 0)
+        : m_ptr(data.data())
+        , m_end(data.data() + data.size())
+        , m_depth(depth)
+    {
+        if (depth > MaxDepth) {
+            malformed();
+        }
+    }
+
+    /// Nesting depth of the embedded messages read from the data
+    int nestedDepth() const
+    {
+        return m_depth + 1;
+    }
+
+    bool atEnd() const
+    {
+        return m_ptr == m_end;
+    }
+
+    /// Reads the tag of the next field, returns false at the end of the data
+    bool next(uint32_t& number, WireType& type)
+    {
+        if (atEnd()) {
+            return false;
+        }
+        uint64_t tag = varint();
+        if (tag >> 3 == 0 || tag >> 3 > 0x1fffffff || (tag & 7) > 5) {
+            malformed();
+        }
+        number = uint32_t(tag >> 3);
+        type   = WireType(tag & 7);
+        return true;
+    }
+
+    uint64_t varint()
+    {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (m_ptr == m_end) {
+                malformed();
+            }
+            uint8_t byte = uint8_t(*m_ptr++);
+            value |= uint64_t(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+        malformed();
+    }
+
+    uint32_t fixed32()
+    {
+        return uint32_t(fixed(4));
+    }
+
+    uint64_t fixed64()
+    {
+        return fixed(8);
+    }
+
+    std::string_view bytes()
+    {
+        uint64_t size = varint();
+        if (size > uint64_t(m_end - m_ptr)) {
+            malformed();
+        }
+        std::string_view ret(m_ptr, size_t(size));
+        m_ptr += size;
+        return ret;
+    }
+
+    [[noreturn]] static void malformed()
+    {
+        throw std::runtime_error("Malformed protobuf message");
+    }
+
+    /// Skips the value of the field, groups are skipped with all their content
+    void skip(uint32_t number, WireType type)
+    {
+        skip(number, type, m_depth);
+    }
+
+private:
+    void skip(uint32_t number, WireType type, int depth)
+    {
+        switch (type) {
+        case WireType::Varint:
+            varint();
+            break;
+        case WireType::Fixed64:
+            fixed(8);
+            break;
+        case WireType::Length:
+            bytes();
+            break;
+        case WireType::Fixed32:
+            fixed(4);
+            break;
+        case WireType::StartGroup: {
+            if (++depth > MaxDepth) {
+                malformed();
+            }
+            uint32_t childNumber;
+            WireType childType;
+            while (true) {
+                if (!next(childNumber, childType)) {
+                    malformed();
+                }
+                if (childType == WireType::EndGroup) {
+                    if (childNumber != number) {
+                        malformed();
+                    }
+                    break;
+                }
+                skip(childNumber, childType, depth);
+            }
+            break;
+        }
+        case WireType::EndGroup:
+            malformed();
+        }
+    }
+
+    uint64_t fixed(size_t size)
+    {
+        if (size_t(m_end - m_ptr) < size) {
+            malformed();
+        }
+        uint64_t value = size == 4 ? readFixed<4>(m_ptr) : readFixed<8>(m_ptr);
+        m_ptr += size;
+        return value;
+    }
+
+private:
+    const char* m_ptr;
+    const char* m_end;
+    int         m_depth;
+};
+
+// =========================================================================================================================================
+
+} // namespace pack::protobuf
@@ -20,8 +20,15 @@
 
 #include "pack/attribute.h"
 #include "pack/expected.h"
+#include "pack/sink.h"
 #include "pack/utils.h"
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
 
 namespace pack {
 
@@ -29,27 +36,158 @@ enum class Option
 {
     No           = 1 << 0,
     WithDefaults = 1 << 1,
-    PrettyPrint  = 1 << 2
+    PrettyPrint  = 1 << 2,
+    /// Keeps serialized form of the nodes, next serialization re-encodes only changed subtrees. Serialization stores the cache in the
+    /// nodes even though it takes them as const, so it needs exclusive access to the serialized object like any modification does.
+    Incremental  = 1 << 3
 };
 
 ENABLE_FLAGS(Option)
 
 namespace json {
+    /// Json parsers to deserialize with
+    enum class Parser
+    {
+        /// nlohmann SAX parser
+        Sax,
+        /// Structural index parser, classifies the characters with AVX2 or SSE4.2 instructions if the cpu supports them
+        Structural
+    };
+
+    /// How the json values of other type than the attribute are read
+    enum class Coercion
+    {
+        /// Value of other type is an error
+        Reject,
+        /// Strings are parsed into the numbers and numbers are casted into each other, value which cannot be converted is an error
+        Coerce,
+        /// Value of other type is skipped, the attribute keeps its value
+        Ignore
+    };
+
     Expected<string_t> serialize(const Attribute& node, Option opt = Option::No);
+    Expected<void>     serialize(const Attribute& node, std::string& out, Option opt = Option::No);
+    Expected<void>     serialize(const Attribute& node, std::vector<char>& out, Option opt = Option::No);
+    Expected<void>     serialize(const Attribute& node, Sink& sink, Option opt = Option::No);
     Expected<void>     deserialize(const string_t& content, Attribute& node);
+    Expected<void>     deserialize(const string_t& content, Attribute& node, Parser parser);
+    Expected<void>     deserialize(const string_t& content, Attribute& node, Parser parser, Coercion coercion);
+    /// Parses the content in place, without copying it
+    Expected<void>     deserialize(std::string_view content, Attribute& node);
+    Expected<void>     deserialize(std::string_view content, Attribute& node, Parser parser);
+    Expected<void>     deserialize(std::string_view content, Attribute& node, Parser parser, Coercion coercion);
+    Expected<void>     deserialize(
+            const std::byte* data, size_t size, Attribute& node, Parser parser = Parser::Sax, Coercion coercion = Coercion::Coerce);
+    /// Zero terminated content, string literal would be ambiguous between string_t and string_view otherwise
+    Expected<void>     deserialize(const char* content, Attribute& node, Parser parser = Parser::Sax, Coercion coercion = Coercion::Coerce);
     Expected<void>     deserializeFile(const string_t& fileName, Attribute& node);
     Expected<void>     serializeFile(const string_t& fileName, const Attribute& node, Option opt = Option::No);
 } // namespace json
 
 namespace yaml {
     Expected<string_t> serialize(const Attribute& node, Option opt = Option::No);
+    Expected<void>     serialize(const Attribute& node, std::string& out, Option opt = Option::No);
+    Expected<void>     serialize(const Attribute& node, std::vector<char>& out, Option opt = Option::No);
+    Expected<void>     serialize(const Attribute& node, Sink& sink, Option opt = Option::No);
     Expected<void>     deserialize(const string_t& content, Attribute& node);
+    /// Parses the content in place, without copying it
+    Expected<void>     deserialize(std::string_view content, Attribute& node);
+    Expected<void>     deserialize(const std::byte* data, size_t size, Attribute& node);
+    /// Zero terminated content, string literal would be ambiguous between string_t and string_view otherwise
+    Expected<void>     deserialize(const char* content, Attribute& node);
     Expected<void>     deserializeFile(const string_t& fileName, Attribute& node);
     Expected<void>     serializeFile(const string_t& fileName, const Attribute& node, Option opt = Option::No);
+
+    namespace details {
+        /// Returns the next document to write, nullptr when there are no more documents
+        using NextDocument = std::function<const Attribute*()>;
+        /// Called when the next document is read into the node, false stops the reading
+        using DocumentRead = std::function<bool()>;
+
+        Expected<void> serializeAll(const NextDocument& next, std::string& out, Option opt);
+        Expected<void> serializeAll(const NextDocument& next, Sink& sink, Option opt);
+        Expected<void> deserializeAll(std::istream& stream, Attribute& node, const DocumentRead& read);
+        Expected<void> deserializeAll(std::string_view content, Attribute& node, const DocumentRead& read);
+
+        template <typename Range>
+        NextDocument documents(const Range& range)
+        {
+            return [it = std::begin(range), end = std::end(range)]() mutable -> const Attribute* {
+                if (it == end) {
+                    return nullptr;
+                }
+                const Attribute& doc = *it++;
+                return &doc;
+            };
+        }
+
+        template <typename Node, typename Content, typename Func>
+        Expected<void> readAll(Content& content, Func&& callback)
+        {
+            Node node;
+            return deserializeAll(content, node, [&]() {
+                if constexpr (std::is_same_v<std::invoke_result_t<Func, Node&>, bool>) {
+                    return callback(node);
+                } else {
+                    callback(node);
+                    return true;
+                }
+            });
+        }
+    } // namespace details
+
+    /// Writes the documents of the range as the multi-document stream, separated by '---'
+    template <typename Range>
+    Expected<string_t> serializeAll(const Range& range, Option opt = Option::No)
+    {
+        std::string out;
+        if (auto ret = details::serializeAll(details::documents(range), out, opt); !ret) {
+            return unexpected(ret.error());
+        }
+        return fromStdString(out);
+    }
+
+    template <typename Range>
+    Expected<void> serializeAll(const Range& range, std::string& out, Option opt = Option::No)
+    {
+        return details::serializeAll(details::documents(range), out, opt);
+    }
+
+    /// Writes the documents one by one into the sink, only one document is kept in memory
+    template <typename Range>
+    Expected<void> serializeAll(const Range& range, Sink& sink, Option opt = Option::No)
+    {
+        return details::serializeAll(details::documents(range), sink, opt);
+    }
+
+    /// Reads the multi-document stream. Every document is read into the same instance of T, which is cleared before, and passed to
+    /// the callback. The callback may return false to stop reading.
+    template <typename T, typename Func>
+    Expected<void> deserializeAll(std::string_view content, Func&& callback)
+    {
+        return details::readAll<T>(content, std::forward<Func>(callback));
+    }
+
+    /// Reads the documents from the stream as they are parsed, the whole content is never kept in memory
+    template <typename T, typename Func>
+    Expected<void> deserializeAll(std::istream& stream, Func&& callback)
+    {
+        return details::readAll<T>(stream, std::forward<Func>(callback));
+    }
 } // namespace yaml
 
 #ifdef WITH_PROTOBUF
 namespace protobuf {
+    Expected<void> serialize(const Attribute& node, std::string& out, Option opt = Option::No);
+    Expected<void> serialize(const Attribute& node, std::vector<char>& out, Option opt = Option::No);
+    Expected<void> serialize(const Attribute& node, Sink& sink, Option opt = Option::No);
+    /// Parses the content in place, without copying it. Fields are set while the content is read, so on malformed content the node keeps
+    /// the fields read before the error; decode into a temporary node if the previous value should survive the failure.
+    Expected<void> deserialize(std::string_view content, Attribute& node);
+    Expected<void> deserialize(const std::byte* data, size_t size, Attribute& node);
+    /// Content up to the first zero byte, string literal would be ambiguous between the owning string and string_view otherwise
+    Expected<void> deserialize(const char* content, Attribute& node);
+
 #ifdef WITH_QTSTRING
     Expected<QByteArray> serialize(const Attribute& node, Option opt = Option::No);
     Expected<void>       deserialize(const QByteArray& content, Attribute& node);
@@ -0,0 +1,95 @@
+/* =========================================================================================================================================
+    ____ __ _ ____ __  __
+   |    |  ` |    |  /  /
+   | |  | |  | |__|    /
+   | ___| |  | |  |    \
+   |_|  |__,_|____|__\__\ DSO library
+
+   Copyright (C) 2020 Eaton
+   Copyright (C) 2020-2022 zJes
+
+   This program is free software; you can redistribute it and/or modify it under the terms of the GNU Lesser General Public License as
+   published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+========================================================================================================================================= */
+#pragma once
+#include "pack/expected.h"
+#include "pack/types.h"
+#include <functional>
+#include <iosfwd>
+
+namespace pack {
+
+// =========================================================================================================================================
+
+/// Output of the serializers
+class Sink
+{
+public:
+    virtual ~Sink() = default;
+
+    /// Writes the data to the output
+    virtual Expected<void> write(const char* data, size_t size) = 0;
+};
+
+// =========================================================================================================================================
+
+/// Writes to the stream
+class StreamSink : public Sink
+{
+public:
+    explicit StreamSink(std::ostream& stream);
+
+    Expected<void> write(const char* data, size_t size) override;
+
+private:
+    std::ostream& m_stream;
+};
+
+// =========================================================================================================================================
+
+/// Writes to the file descriptor
+class FdSink : public Sink
+{
+public:
+    explicit FdSink(int fd);
+
+    Expected<void> write(const char* data, size_t size) override;
+
+private:
+    int m_fd;
+};
+
+// =========================================================================================================================================
+
+/// Writes to the fixed buffer. When the buffer is full, its content is passed to overflow callback and the buffer is reused, without
+/// callback the write fails.
+class BufferSink : public Sink
+{
+public:
+    using Overflow = std::function<Expected<void>(const char* data, size_t size)>;
+
+    BufferSink(char* buffer, size_t capacity, Overflow overflow = {});
+
+    Expected<void> write(const char* data, size_t size) override;
+
+    /// Passes buffered content to overflow callback
+    Expected<void> flush();
+
+    /// Returns size of the buffered content
+    size_t size() const;
+
+private:
+    char*    m_buffer;
+    size_t   m_capacity;
+    size_t   m_size = 0;
+    Overflow m_overflow;
+};
+
+// =========================================================================================================================================
+
+} // namespace pack
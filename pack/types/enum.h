@@ -74,8 +74,8 @@ public:
     template <typename... Options, typename = isOptions<Options...>>
     Enum(Options&&... opts);
 
-    Enum(const Enum& other) = default;
-    Enum(Enum&& other)      = default;
+    Enum(const Enum& other);
+    Enum(Enum&& other) = default;
     Enum();
 
 public:
@@ -96,6 +96,12 @@ public:
     /// Assigmen operator
     Enum& operator=(const T& val);
 
+    /// Assigmen operator, copies the value only
+    Enum& operator=(const Enum& other);
+
+    /// Assigmen operator, copies the value only
+    Enum& operator=(Enum&& other);
+
 public:
     /// Compares enums
     bool compare(const Attribute& other) const override;
@@ -135,8 +141,9 @@ private:
     void            _setValue(T value);
 
 protected:
-    T m_value = {};
-    T m_def   = {};
+    T                        m_value = {};
+    std::unique_ptr<const T> m_ownDef;
+    const T*                 m_def = &emptyValue<T>();
 };
 
 // =========================================================================================================================================
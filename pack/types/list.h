@@ -43,9 +43,18 @@ public:
     /// Returns item by index
     virtual const Attribute& get(int index) const = 0;
 
+    /// Returns item by index
+    virtual Attribute& get(int index) = 0;
+
     /// emplace and return newly create element
     virtual Attribute& create() = 0;
 
+    /// Inserts new element before the index and returns it
+    virtual Attribute& insert(int index) = 0;
+
+    /// Removes element by index
+    virtual void removeAt(int index) = 0;
+
     virtual bool isValueList() const = 0;
     virtual Type valueType() const   = 0;
 };
@@ -72,6 +81,12 @@ public:
     template <typename... Options, typename = isOptions<Options...>>
     List(Options&&... opts);
 
+    List(const List& other) = default;
+    List(List&& other)      = default;
+
+    List& operator=(const List& other);
+    List& operator=(List&& other);
+
 public:
     const ListType& toVector() const;
     ListType&       toVector();
@@ -90,7 +105,10 @@ public:
 public:
     int              size() const override;
     const Attribute& get(int index) const override;
+    Attribute&       get(int index) override;
     Attribute&       create() override;
+    Attribute&       insert(int index) override;
+    void             removeAt(int index) override;
     bool             isValueList() const override;
     Type             valueType() const override;
 
@@ -144,6 +162,7 @@ public:
     void     set(Attribute&& other) override;
     bool     hasValue() const override;
     void     clear() override;
+    void     adoptChildren() const override;
 
     static string_t _typeName();
 
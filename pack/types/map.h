@@ -41,8 +41,11 @@ public:
     virtual std::vector<string_t> keys() const                   = 0;
     virtual int                   size() const                   = 0;
     virtual const string_t&       keyByIndex(int index) const    = 0;
+    virtual const Attribute&      valueByIndex(int index) const  = 0;
     virtual const Attribute&      get(const string_t& key) const = 0;
+    virtual Attribute&            get(const string_t& key)       = 0;
     virtual Attribute&            create(const string_t& key)    = 0;
+    virtual bool                  remove(const string_t& key)    = 0;
 };
 
 // =========================================================================================================================================
@@ -73,6 +76,12 @@ public:
     template <typename... Options, typename = isOptions<Options...>>
     Map(Options&&... opts);
 
+    Map(const Map& other) = default;
+    Map(Map&& other)      = default;
+
+    Map& operator=(const Map& other);
+    Map& operator=(Map&& other);
+
 #ifdef WITH_QTSTRING
     template <typename... Options, typename = isOptions<Options...>>
     Map(QHash<QString, typename T::CppType>&& map, Options&&... opts);
@@ -124,10 +133,12 @@ public:
     std::vector<string_t> keys() const override;
     int                   size() const override;
     const string_t&       keyByIndex(int index) const override;
+    const Attribute&      valueByIndex(int index) const override;
     const Attribute&      get(const string_t& key) const override;
+    Attribute&            get(const string_t& key) override;
     Attribute&            create(const string_t& key) override;
     bool                  contains(const string_t& key) const;
-    bool                  remove(const string_t& key);
+    bool                  remove(const string_t& key) override;
 
 public:
     bool     compare(const Attribute& other) const override;
@@ -136,6 +147,7 @@ public:
     void     set(Attribute&& other) override;
     bool     hasValue() const override;
     void     clear() override;
+    void     adoptChildren() const override;
 
     static string_t _typeName();
 
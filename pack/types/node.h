@@ -20,30 +20,61 @@
 
 #include "pack/attribute.h"
 #include "pack/expected.h"
+#include "pack/fields.h"
+#include <any>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
 
 namespace pack {
 
+enum class Option;
+
 // =========================================================================================================================================
 
-// Add metainformation to the value
+// Add metainformation to the value, the key is stored once per field declaration
 #define FIELD(key, ...)                                                                                                                    \
     {                                                                                                                                      \
-        pack::Key(key##_s), ##__VA_ARGS__                                                                                                  \
+        []() -> const pack::Declaration& {                                                                                                 \
+            static const pack::Declaration decl(key##_s, ##__VA_ARGS__);                                                                   \
+            return decl;                                                                                                                   \
+        }()                                                                                                                                \
     }
 
 #define META(className, ...)                                                                                                               \
     META_CTR(className, __VA_ARGS__)                                                                                                       \
-    META_FIELDS(className)                                                                                                                 \
     META_FIELDS_IMPL(className, __VA_ARGS__)                                                                                               \
+    META_FIELDS(className)                                                                                                                 \
     META_AUX(className)                                                                                                                    \
     META_INFO(className)                                                                                                                   \
     META_STATIC_INFO(className)
 
 #define META_BASE(className, base, ...)                                                                                                    \
     META_CTR_BASE(className, base, __VA_ARGS__)                                                                                            \
+    META_FIELDS_BASE_IMPL(className, base, __VA_ARGS__)                                                                                    \
+    META_FIELDS(className)                                                                                                                 \
+    META_AUX(className)                                                                                                                    \
+    META_INFO(className)                                                                                                                   \
+    META_STATIC_INFO(className)
+
+// Same as META, the node also keeps presence bitmap of the fields, see Node
+#define META_WITH_PRESENCE(className, ...)                                                                                                 \
+    META_CTR(className, __VA_ARGS__)                                                                                                       \
+    META_FIELDS_IMPL(className, __VA_ARGS__)                                                                                               \
     META_FIELDS(className)                                                                                                                 \
+    META_AUX(className)                                                                                                                    \
+    META_PRESENCE(__VA_ARGS__)                                                                                                             \
+    META_INFO(className)                                                                                                                   \
+    META_STATIC_INFO(className)
+
+// Same as META_BASE, the node also keeps presence bitmap of the own and base fields, see Node
+#define META_BASE_WITH_PRESENCE(className, base, ...)                                                                                      \
+    META_CTR_BASE(className, base, __VA_ARGS__)                                                                                            \
     META_FIELDS_BASE_IMPL(className, base, __VA_ARGS__)                                                                                    \
+    META_FIELDS(className)                                                                                                                 \
     META_AUX(className)                                                                                                                    \
+    META_PRESENCE_BASE(base, __VA_ARGS__)                                                                                                  \
     META_INFO(className)                                                                                                                   \
     META_STATIC_INFO(className)
 
@@ -78,7 +109,7 @@ public:
         copyFields(other);                                                                                                                 \
     }                                                                                                                                      \
     className(className&& other)                                                                                                           \
-        : base(other)                                                                                                                      \
+        : base(std::move(other))                                                                                                           \
     {                                                                                                                                      \
         moveFields(other);                                                                                                                 \
     }                                                                                                                                      \
@@ -90,7 +121,7 @@ public:
     }                                                                                                                                      \
     inline className& operator=(className&& other)                                                                                         \
     {                                                                                                                                      \
-        base::operator=(other);                                                                                                            \
+        base::operator=(std::move(other));                                                                                                 \
         moveFields(other);                                                                                                                 \
         return *this;                                                                                                                      \
     }
@@ -105,90 +136,92 @@ public:
 private:                                                                                                                                   \
     void copyFields(const className& other)                                                                                                \
     {                                                                                                                                      \
-        for (auto& it : _fields()) {                                                                                                       \
-            it.get().set(*other.fieldByKey(it.get().key()));                                                                               \
-        }                                                                                                                                  \
+        pack::assignFields(metaTie(), other.metaTie());                                                                                    \
     }                                                                                                                                      \
-    void moveFields(const className& other)                                                                                                \
+    void moveFields(className& other)                                                                                                      \
     {                                                                                                                                      \
-        for (auto& it : _fields()) {                                                                                                       \
-            it.get().set(std::move(*other.fieldByKey(it.get().key())));                                                                    \
-        }                                                                                                                                  \
+        pack::moveFields(metaTie(), other.metaTie());                                                                                      \
     }
 
+// Presence bitmap storage, it binds the fields on construction. Its type is computed from the listed fields, so a field declared after it
+// does not compile and all the fields are constructed when it binds them.
+#define META_PRESENCE(...)                                                                                                                 \
+private:                                                                                                                                   \
+    pack::PresenceBits<std::tuple_size_v<decltype(std::forward_as_tuple(__VA_ARGS__))>> m_metaPresence{this};
+
+#define META_PRESENCE_BASE(base, ...)                                                                                                      \
+private:                                                                                                                                   \
+    pack::PresenceBits<base::metaFieldArray().size() + std::tuple_size_v<decltype(std::forward_as_tuple(__VA_ARGS__))>> m_metaPresence{this};
+
 #define META_FIELDS(className)                                                                                                             \
 public:                                                                                                                                    \
-    inline std::vector<std::reference_wrapper<const pack::Attribute>> fields() const override                                              \
+    inline pack::FieldTable metaFields() const override                                                                                    \
     {                                                                                                                                      \
-        return _fields();                                                                                                                  \
+        return staticFields();                                                                                                             \
     }                                                                                                                                      \
-    inline std::vector<std::reference_wrapper<pack::Attribute>> fields() override                                                          \
+    inline static pack::FieldTable staticFields()                                                                                          \
     {                                                                                                                                      \
-        return _fields();                                                                                                                  \
+        static constexpr auto table = metaFieldArray();                                                                                    \
+        static const pack::FieldIndex index;                                                                                               \
+        return pack::FieldTable(table.data(), table.size(), &index);                                                                       \
     }                                                                                                                                      \
-    inline std::vector<pack::string_t> fieldNames() const override                                                                         \
+    inline static std::vector<pack::string_t> staticFieldNames()                                                                           \
     {                                                                                                                                      \
-        return staticFieldNames();                                                                                                         \
+        return staticFields().names();                                                                                                     \
     }
 
-#define META_FIELDS_IMPL(className, ...)                                                                                                   \
+#define META_FIELDS_ACCESS(className, ...)                                                                                                 \
 public:                                                                                                                                    \
-    inline static std::vector<pack::string_t> staticFieldNames()                                                                           \
+    template <std::size_t Index>                                                                                                           \
+    inline static pack::Attribute& metaField(pack::INode& node)                                                                            \
+    {                                                                                                                                      \
+        return std::get<Index>(static_cast<className&>(node).metaTie());                                                                   \
+    }                                                                                                                                      \
+    template <std::size_t Index>                                                                                                           \
+    inline static void metaAssign(pack::INode& to, const pack::INode& from)                                                                \
     {                                                                                                                                      \
-        static std::vector<pack::string_t> ret = pack::split(#__VA_ARGS__##_s);                                                            \
-        return ret;                                                                                                                        \
+        std::get<Index>(static_cast<className&>(to).metaTie()) = std::get<Index>(static_cast<const className&>(from).metaTie());           \
+    }                                                                                                                                      \
+    template <std::size_t Index>                                                                                                           \
+    inline static void metaMove(pack::INode& to, pack::INode& from)                                                                        \
+    {                                                                                                                                      \
+        std::get<Index>(static_cast<className&>(to).metaTie()) = std::move(std::get<Index>(static_cast<className&>(from).metaTie()));      \
+    }                                                                                                                                      \
+    template <std::size_t Index>                                                                                                           \
+    inline static bool metaEqual(const pack::INode& left, const pack::INode& right)                                                        \
+    {                                                                                                                                      \
+        return pack::isEqual(                                                                                                              \
+            std::get<Index>(static_cast<const className&>(left).metaTie()),                                                                \
+            std::get<Index>(static_cast<const className&>(right).metaTie()));                                                              \
     }                                                                                                                                      \
                                                                                                                                            \
 protected:                                                                                                                                 \
-    inline std::vector<std::reference_wrapper<const pack::Attribute>> _fields() const                                                      \
+    inline auto metaTie()                                                                                                                  \
     {                                                                                                                                      \
-        return std::apply(                                                                                                                 \
-            [](const auto&... elems) {                                                                                                     \
-                return std::vector<std::reference_wrapper<const pack::Attribute>>{std::cref(elems)...};                                    \
-            },                                                                                                                             \
-            std::forward_as_tuple(__VA_ARGS__));                                                                                           \
+        return std::forward_as_tuple(__VA_ARGS__);                                                                                         \
     }                                                                                                                                      \
-    inline std::vector<std::reference_wrapper<pack::Attribute>> _fields()                                                                  \
+    inline auto metaTie() const                                                                                                            \
     {                                                                                                                                      \
-        return std::apply(                                                                                                                 \
-            [](auto&... elems) {                                                                                                           \
-                return std::vector<std::reference_wrapper<pack::Attribute>>{std::ref(elems)...};                                           \
-            },                                                                                                                             \
-            std::forward_as_tuple(__VA_ARGS__));                                                                                           \
+        return std::forward_as_tuple(__VA_ARGS__);                                                                                         \
     }
 
-#define META_FIELDS_BASE_IMPL(className, base, ...)                                                                                        \
+#define META_FIELDS_IMPL(className, ...)                                                                                                   \
+    META_FIELDS_ACCESS(className, __VA_ARGS__)                                                                                             \
+                                                                                                                                           \
 public:                                                                                                                                    \
-    inline static std::vector<pack::string_t> staticFieldNames()                                                                           \
+    inline static constexpr auto metaFieldArray()                                                                                          \
     {                                                                                                                                      \
-        auto baseFields = base::staticFieldNames();                                                                                        \
-        auto thisFields = pack::split(#__VA_ARGS__##_s);                                                                                   \
-        baseFields.insert(baseFields.end(), thisFields.begin(), thisFields.end());                                                         \
-        return baseFields;                                                                                                                 \
-    }                                                                                                                                      \
+        return pack::makeFields<className, decltype(std::forward_as_tuple(__VA_ARGS__))>(#__VA_ARGS__);                                    \
+    }
+
+#define META_FIELDS_BASE_IMPL(className, base, ...)                                                                                        \
+    META_FIELDS_ACCESS(className, __VA_ARGS__)                                                                                             \
                                                                                                                                            \
-protected:                                                                                                                                 \
-    inline std::vector<std::reference_wrapper<const pack::Attribute>> _fields() const                                                      \
-    {                                                                                                                                      \
-        auto baseFields = base::fields();                                                                                                  \
-        auto thisFields = std::apply(                                                                                                      \
-            [](const auto&... elems) {                                                                                                     \
-                return std::vector<std::reference_wrapper<const pack::Attribute>>{elems...};                                               \
-            },                                                                                                                             \
-            std::forward_as_tuple(__VA_ARGS__));                                                                                           \
-        baseFields.insert(baseFields.end(), thisFields.begin(), thisFields.end());                                                         \
-        return baseFields;                                                                                                                 \
-    }                                                                                                                                      \
-    inline std::vector<std::reference_wrapper<pack::Attribute>> _fields()                                                                  \
+public:                                                                                                                                    \
+    inline static constexpr auto metaFieldArray()                                                                                          \
     {                                                                                                                                      \
-        auto baseFields = base::fields();                                                                                                  \
-        auto thisFields = std::apply(                                                                                                      \
-            [](auto&... elems) {                                                                                                           \
-                return std::vector<std::reference_wrapper<pack::Attribute>>{elems...};                                                     \
-            },                                                                                                                             \
-            std::forward_as_tuple(__VA_ARGS__));                                                                                           \
-        baseFields.insert(baseFields.end(), thisFields.begin(), thisFields.end());                                                         \
-        return baseFields;                                                                                                                 \
+        return pack::joinFields(                                                                                                           \
+            base::metaFieldArray(), pack::makeFields<className, decltype(std::forward_as_tuple(__VA_ARGS__))>(#__VA_ARGS__));              \
     }
 
 #define META_INFO(className)                                                                                                               \
@@ -217,6 +250,7 @@ public:
 
 // =========================================================================================================================================
 
+/// Splits the comma separated list of the field names. META does not use it anymore, it's kept for the existing users.
 std::vector<pack::string_t> split(const pack::string_t& str);
 
 // =========================================================================================================================================
@@ -226,6 +260,8 @@ class INode : public Attribute
 {
 public:
     INode();
+    INode(const INode& other);
+    INode(INode&& other) noexcept;
 
     template <typename... Args, typename = std::enable_if_t<std::is_base_of_v<FieldOption, Args...>>>
     INode(const Args&... args)
@@ -233,21 +269,136 @@ public:
     {
     }
 
+    INode& operator=(const INode& other);
+    INode& operator=(INode&& other) noexcept;
+
     /// Dumps a class as yaml serialized string
     virtual string_t dump() const = 0;
 
+    /// Returns static table of the fields descriptions
+    virtual FieldTable metaFields() const = 0;
+
     /// Returns a list of fields
-    virtual std::vector<std::reference_wrapper<pack::Attribute>> fields() = 0;
+    Fields<Attribute> fields();
 
     /// Returns a list of fields
-    virtual std::vector<std::reference_wrapper<const pack::Attribute>> fields() const = 0;
+    Fields<const Attribute> fields() const;
 
     /// Returns a list of the fields names
-    virtual std::vector<string_t> fieldNames() const = 0;
+    std::vector<string_t> fieldNames() const;
+
+    /// Returns the fields which may have a value: only marked in presence bitmap if the node tracks it, all fields otherwise
+    Fields<Attribute> presentFields();
+
+    /// Returns the fields which may have a value: only marked in presence bitmap if the node tracks it, all fields otherwise
+    Fields<const Attribute> presentFields() const;
+
+    /// Returns presence bitmap of the fields, empty if the node does not track presence
+    const Presence& presence() const;
+
+    /// Binds the fields to the node and the fields of the nested nodes, nodes with presence bitmap have them bound since construction
+    void adoptChildren() const override;
+
+    /// Returns true if the node or any of its children was changed since the node was cached by incremental serialization
+    bool isDirty() const;
+
+    /// Returns cached serialized form of the node made with the same options, nullptr if there is no one
+    template <typename Resource>
+    const Resource* cached(uint32_t options) const;
+
+    /// Stores serialized form of the node, it's kept until the node or any of its children is changed
+    template <typename Resource>
+    void setCached(const Resource& resource, uint32_t options) const;
 
     virtual const std::string& fileDescriptor() const = 0;
 
     virtual std::string protoName() const = 0;
+
+    /// Writes the node in protobuf wire format with the code protoc-gen-pack generated for the message, returns false if there is no one
+    virtual bool encodeProto(std::string& out) const = 0;
+
+    /// Reads the node from protobuf wire format with the generated code, returns false if there is no one
+    virtual bool decodeProto(std::string_view data) = 0;
+
+    /// Writes the node as json with the generated code, returns false if there is no one
+    virtual bool encodeJson(std::string& out, Option opt) const = 0;
+
+protected:
+    /// Attaches presence bitmap and takes ownership of the fields, called by META_WITH_PRESENCE once all fields are constructed
+    void bindPresence(Presence presence);
+
+    /// Updates presence of the field, drops cached serialized forms and propagates the change to the owner
+    void childChanged(uint32_t slot, bool present) override;
+
+private:
+    /// Counter of the cache stores, the owners of the node which reported a change in the same epoch are dirty already
+    static uint64_t cacheEpoch();
+    static void     nextCacheEpoch();
+
+    /// Returns true if the owner keeps presence bit of this node
+    bool ownerTracksPresence() const;
+
+private:
+    template <size_t>
+    friend class PresenceBits;
+
+    struct Cached
+    {
+        uint32_t options;
+        std::any value;
+    };
+
+private:
+    Presence                                     m_presence;
+    mutable std::unique_ptr<std::vector<Cached>> m_cache;
+    uint64_t                                     m_notified = 0;
+};
+
+// =========================================================================================================================================
+
+template <typename Resource>
+const Resource* INode::cached(uint32_t options) const
+{
+    if (m_cache) {
+        for (const auto& it : *m_cache) {
+            if (it.options == options) {
+                if (auto ret = std::any_cast<Resource>(&it.value)) {
+                    return ret;
+                }
+            }
+        }
+    }
+    return nullptr;
+}
+
+template <typename Resource>
+void INode::setCached(const Resource& resource, uint32_t options) const
+{
+    if (!m_cache) {
+        m_cache = std::make_unique<std::vector<Cached>>();
+    }
+    m_cache->push_back({options, resource});
+    nextCacheEpoch();
+}
+
+// =========================================================================================================================================
+
+/// Storage of the presence bitmap for N fields, generated by META_WITH_PRESENCE as a last member of the node
+template <size_t N>
+class PresenceBits
+{
+public:
+    template <typename T>
+    explicit PresenceBits(T* node)
+    {
+        static_cast<INode*>(node)->bindPresence(Presence(m_words.data(), N));
+    }
+
+    PresenceBits(const PresenceBits&)            = delete;
+    PresenceBits& operator=(const PresenceBits&) = delete;
+
+private:
+    std::array<uint64_t, (N + 63) / 64> m_words = {};
 };
 
 // =========================================================================================================================================
@@ -265,6 +416,9 @@ public:
 /// ---------------------------
 /// Where each field has a usage name (str) and real name used to serialization/deserialization (string-value)
 /// META macro just define metainformation about a struct, such as struct name and list of the fields.
+/// Nodes with many fields of which only a few are usually set could use META_WITH_PRESENCE instead: the setters then keep a bitmap of
+/// the fields with value, hasValue() and the serializers look only at the marked fields. The bitmap is a member added after the fields,
+/// so META_WITH_PRESENCE has to follow all of them, a field declared after it does not compile.
 class Node : public INode
 {
 public:
@@ -276,11 +430,19 @@ public:
     /// Dumps a class as yaml serialized string
     string_t dump() const override;
 
-    /// Returns field it's key
-    Expected<std::reference_wrapper<const Attribute>> fieldByKey(const string_t& name) const;
+    /// Returns field by it's key
+    Expected<std::reference_wrapper<const Attribute>> fieldByKey(std::string_view key) const;
+
+    /// Returns field by it's name
+    Expected<std::reference_wrapper<const pack::Attribute>> fieldByName(std::string_view name) const;
 
-    /// Returns field it's name
+#ifdef WITH_QTSTRING
+    /// Returns field by it's key
+    Expected<std::reference_wrapper<const Attribute>> fieldByKey(const string_t& key) const;
+
+    /// Returns field by it's name
     Expected<std::reference_wrapper<const pack::Attribute>> fieldByName(const string_t& name) const;
+#endif
 
     void set(const Attribute& other) override;
     void set(Attribute&& other) override;
@@ -292,6 +454,12 @@ public:
 
     std::string protoName() const override;
 
+    bool encodeProto(std::string& out) const override;
+
+    bool decodeProto(std::string_view data) override;
+
+    bool encodeJson(std::string& out, Option opt) const override;
+
     void clear() override;
 };
 
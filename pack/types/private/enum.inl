@@ -81,17 +81,24 @@ template <typename T>
 template <typename... Options, typename>
 Enum<T>::Enum(Options&&... opts)
     : IEnum(std::forward<Options>(opts)...)
+    , m_def(&defaultValue<T>(m_ownDef, opts...))
+{
+    m_value = *m_def;
+}
+
+template <typename T>
+Enum<T>::Enum(const Enum& other)
+    : IEnum(other)
+    , m_value(other.m_value)
+    , m_ownDef(other.m_ownDef ? std::make_unique<const T>(*other.m_ownDef) : nullptr)
+    , m_def(m_ownDef ? m_ownDef.get() : other.m_def)
 {
-    if (auto ret = pickOption<Default>(opts...)) {
-        m_def   = std::any_cast<const T&>(ret->value);
-        m_value = std::any_cast<const T&>(ret->value);
-    }
 }
 
 template <typename T>
 const T& Enum<T>::defValue() const
 {
-    return m_def;
+    return *m_def;
 }
 
 template <typename T>
@@ -113,6 +120,20 @@ Enum<T>& Enum<T>::operator=(const T& val)
     return *this;
 }
 
+template <typename T>
+Enum<T>& Enum<T>::operator=(const Enum& other)
+{
+    _setValue(other.m_value);
+    return *this;
+}
+
+template <typename T>
+Enum<T>& Enum<T>::operator=(Enum&& other)
+{
+    _setValue(other.m_value);
+    return *this;
+}
+
 template <typename T>
 template <typename Value>
 Expected<void> Enum<T>::setValue(Value&& val)
@@ -192,7 +213,7 @@ void Enum<T>::set(Attribute&& other)
 template <typename T>
 bool Enum<T>::hasValue() const
 {
-    return m_value != m_def;
+    return m_value != *m_def;
 }
 
 template <typename T>
@@ -256,7 +277,7 @@ Expected<void> Enum<T>::fromInt(int value)
 template <typename T>
 void Enum<T>::clear()
 {
-    _setValue(m_def);
+    _setValue(*m_def);
 }
 
 template <typename T>
@@ -264,6 +285,7 @@ void Enum<T>::_setValue(T val)
 {
     if (value() != val) {
         m_value = val;
+        changed(m_value != *m_def);
     }
 }
 
@@ -46,6 +46,24 @@ List<T>::List(Options&&... opts)
 {
 }
 
+template <typename T>
+List<T>& List<T>::operator=(const List& other)
+{
+    IList::operator=(other);
+    m_value = other.m_value;
+    changed(!m_value.empty());
+    return *this;
+}
+
+template <typename T>
+List<T>& List<T>::operator=(List&& other)
+{
+    IList::operator=(std::move(other));
+    m_value = std::move(other.m_value);
+    changed(!m_value.empty());
+    return *this;
+}
+
 // Element access
 
 template <typename T>
@@ -57,6 +75,8 @@ const typename List<T>::ListType& List<T>::toVector() const
 template <typename T>
 typename List<T>::ListType& List<T>::toVector()
 {
+    // Content could be changed by the caller, so mark as present, hasValue() gives the exact answer
+    changed(true);
     return m_value;
 }
 
@@ -64,32 +84,37 @@ template <typename T>
 void List<T>::setVector(const typename List<T>::ListType& list)
 {
     m_value = list;
+    changed(!m_value.empty());
 }
 
 template <typename T>
 void List<T>::setVector(typename List<T>::ListType&& list)
 {
     m_value = std::move(list);
+    changed(!m_value.empty());
 }
 
 template <typename T>
 template <typename TT, typename>
 void List<T>::setVector(std::vector<TT>&& value)
 {
-    m_value = std::vector<TT>(m_value.end(), std::make_move_iterator(value.begin()), std::make_move_iterator(value.end()));
+    m_value = ListType(std::make_move_iterator(value.begin()), std::make_move_iterator(value.end()));
+    changed(!m_value.empty());
 }
 
 template <typename T>
 template <typename TT, typename>
 void List<T>::setVector(const std::vector<TT>& value)
 {
-    m_value = std::vector<TT>(m_value.end(), value.begin(), value.end());
+    m_value = ListType(value.begin(), value.end());
+    changed(!m_value.empty());
 }
 
 template <typename T>
 void List<T>::operator=(std::initializer_list<ValueType> values)
 {
     m_value = std::vector<T>(values.begin(), values.end());
+    changed(!m_value.empty());
 }
 
 template <typename T>
@@ -170,14 +195,16 @@ void List<T>::set(const Attribute& other)
 {
     if (auto casted = dynamic_cast<const List*>(&other)) {
         m_value = casted->toVector();
+        changed(!m_value.empty());
     }
 }
 
 template <typename T>
 void List<T>::set(Attribute&& other)
 {
-    if (auto casted = dynamic_cast<const List*>(&other)) {
-        m_value = std::move(casted->toVector());
+    if (auto casted = dynamic_cast<List*>(&other)) {
+        m_value = std::move(casted->m_value);
+        changed(!m_value.empty());
     }
 }
 
@@ -193,6 +220,15 @@ template <typename T>
 void List<T>::clear()
 {
     m_value.clear();
+    changed(false);
+}
+
+template <typename T>
+void List<T>::adoptChildren() const
+{
+    for (const auto& it : m_value) {
+        adopt(it);
+    }
 }
 
 template <typename T>
@@ -201,12 +237,39 @@ const Attribute& List<T>::get(int index) const
     return m_value.at(size_t(index));
 }
 
+template <typename T>
+Attribute& List<T>::get(int index)
+{
+    return m_value.at(size_t(index));
+}
+
 template <typename T>
 Attribute& List<T>::create()
 {
     return append();
 }
 
+template <typename T>
+Attribute& List<T>::insert(int index)
+{
+    if (index < 0 || size_t(index) > m_value.size()) {
+        throw std::out_of_range(fmt::format("Index '{}' is out of range", index));
+    }
+    auto& ret = *m_value.emplace(m_value.begin() + index);
+    changed(true);
+    return ret;
+}
+
+template <typename T>
+void List<T>::removeAt(int index)
+{
+    if (index < 0 || size_t(index) >= m_value.size()) {
+        throw std::out_of_range(fmt::format("Index '{}' is out of range", index));
+    }
+    m_value.erase(m_value.begin() + index);
+    changed(!m_value.empty());
+}
+
 template <typename T>
 bool List<T>::isValueList() const
 {
@@ -229,17 +292,20 @@ template <typename T>
 void List<T>::append(const T& value)
 {
     m_value.emplace_back(value);
+    changed(!m_value.empty());
 }
 
 template <typename T>
 void List<T>::append(T&& value)
 {
     m_value.emplace_back(value);
+    changed(!m_value.empty());
 }
 
 template <typename T>
 T& List<T>::append()
 {
+    changed(true);
     return m_value.emplace_back();
 }
 
@@ -247,24 +313,28 @@ template <typename T>
 void List<T>::append(List<T>&& value)
 {
     m_value.insert(m_value.end(), std::make_move_iterator(value.begin()), std::make_move_iterator(value.end()));
+    changed(!m_value.empty());
 }
 
 template <typename T>
 void List<T>::append(const List<T>& value)
 {
     m_value.insert(m_value.end(), value.begin(), value.end());
+    changed(!m_value.empty());
 }
 
 template <typename T>
 void List<T>::append(List::ListType&& value)
 {
     m_value.insert(m_value.end(), std::make_move_iterator(value.begin()), std::make_move_iterator(value.end()));
+    changed(!m_value.empty());
 }
 
 template <typename T>
 void List<T>::append(const List::ListType& value)
 {
     m_value.insert(m_value.end(), value.begin(), value.end());
+    changed(!m_value.empty());
 }
 
 template <typename T>
@@ -272,6 +342,7 @@ template <typename TT, typename>
 void List<T>::append(std::vector<TT>&& value)
 {
     m_value.insert(m_value.end(), std::make_move_iterator(value.begin()), std::make_move_iterator(value.end()));
+    changed(!m_value.empty());
 }
 
 template <typename T>
@@ -279,6 +350,7 @@ template <typename TT, typename>
 void List<T>::append(const std::vector<TT>& value)
 {
     m_value.insert(m_value.end(), value.begin(), value.end());
+    changed(!m_value.empty());
 }
 
 // List access
@@ -336,6 +408,7 @@ bool List<T>::remove(ToRemove&& toRemove)
 {
     if (auto found = find(std::forward<ToRemove>(toRemove)); found != end()) {
         m_value.erase(found);
+        changed(!m_value.empty());
         return true;
     }
     return false;
@@ -346,12 +419,14 @@ template <typename Func>
 void List<T>::sort(Func&& func)
 {
     std::sort(m_value.begin(), m_value.end(), std::forward<Func>(func));
+    changed(!m_value.empty());
 }
 
 template <typename T>
 void List<T>::sort()
 {
     std::sort(m_value.begin(), m_value.end());
+    changed(!m_value.empty());
 }
 
 template <typename T>
@@ -63,6 +63,22 @@ Map<T>::Map(Options&&... opts)
 {
 }
 
+template <typename T>
+Map<T>& Map<T>::operator=(const Map& other)
+{
+    IMap::operator=(other);
+    setValue(other.m_value);
+    return *this;
+}
+
+template <typename T>
+Map<T>& Map<T>::operator=(Map&& other)
+{
+    IMap::operator=(std::move(other));
+    setValue(std::move(other.m_value));
+    return *this;
+}
+
 #ifdef WITH_QTSTRING
 
 template <typename T>
@@ -147,12 +163,14 @@ template <typename T>
 void Map<T>::setValue(const MapType& map)
 {
     m_value = map;
+    changed(!m_value.empty());
 }
 
 template <typename T>
 void Map<T>::setValue(MapType&& map)
 {
     m_value = std::move(map);
+    changed(!m_value.empty());
 }
 
 template <typename T>
@@ -162,6 +180,7 @@ void Map<T>::setValue(const std::map<pack::string_t, typename T::CppType>& map)
     for (const auto& [key, value] : map) {
         m_value.emplace_back(key, value);
     }
+    changed(!m_value.empty());
 }
 
 template <typename T>
@@ -171,6 +190,7 @@ void Map<T>::setValue(std::map<pack::string_t, typename T::CppType>&& map)
     for (const auto& [key, value] : map) {
         m_value.emplace_back(std::move(key), std::move(value));
     }
+    changed(!m_value.empty());
 }
 
 #ifdef WITH_QTSTRING
@@ -181,6 +201,7 @@ void Map<T>::setValue(const QHash<QString, typename T::CppType>& map)
     for (const auto& key : map.keys()) {
         m_value.emplace_back(key, map[key]);
     }
+    changed(!m_value.empty());
 }
 
 template <typename T>
@@ -190,6 +211,7 @@ void Map<T>::setValue(QHash<QString, typename T::CppType>&& map)
     for (const auto& key : map.keys()) {
         m_value.emplace_back(std::move(key), std::move(map[key]));
     }
+    changed(!m_value.empty());
 }
 
 template <typename T>
@@ -199,6 +221,7 @@ void Map<T>::setValue(const QMap<QString, typename T::CppType>& map)
     for (const auto& key : map.keys()) {
         m_value.emplace_back(key, map[key]);
     }
+    changed(!m_value.empty());
 }
 
 template <typename T>
@@ -208,6 +231,7 @@ void Map<T>::setValue(QMap<QString, typename T::CppType>&& map)
     for (const auto& key : map.keys()) {
         m_value.emplace_back(std::move(key), std::move(map[key]));
     }
+    changed(!m_value.empty());
 }
 
 #endif
@@ -240,6 +264,15 @@ const string_t& Map<T>::keyByIndex(int index) const
     return m_value.at(size_t(index)).first;
 }
 
+template <typename T>
+const Attribute& Map<T>::valueByIndex(int index) const
+{
+    if (index < 0 || index >= int(m_value.size())) {
+        throw std::out_of_range(fmt::format("Index '{}' was not found", index));
+    }
+    return m_value.at(size_t(index)).second;
+}
+
 template <typename T>
 const Attribute& Map<T>::get(const string_t& key) const
 {
@@ -254,6 +287,12 @@ const Attribute& Map<T>::get(const string_t& key) const
     throw std::out_of_range(fmt::format("Key '{}' was not found", key));
 }
 
+template <typename T>
+Attribute& Map<T>::get(const string_t& key)
+{
+    return (*this)[key];
+}
+
 template <typename T>
 Attribute& Map<T>::create(const string_t& key)
 {
@@ -277,6 +316,7 @@ bool Map<T>::remove(const string_t& key)
     });
     if (found != m_value.end()) {
         m_value.erase(found);
+        changed(!m_value.empty());
         return true;
     }
     return false;
@@ -289,6 +329,7 @@ template <typename T>
 T& Map<T>::append(const string_t& key)
 {
     m_value.emplace_back(key, std::move(T{}));
+    changed(true);
     return m_value.back().second;
 }
 
@@ -296,12 +337,14 @@ template <typename T>
 void Map<T>::append(const string_t& key, const T& val)
 {
     m_value.emplace_back(key, val);
+    changed(!m_value.empty());
 }
 
 template <typename T>
 void Map<T>::append(const string_t& key, T&& val)
 {
     m_value.emplace_back(key, std::move(val));
+    changed(!m_value.empty());
 }
 
 // =========================================================================================================================================
@@ -332,7 +375,7 @@ void Map<T>::set(const Attribute& other)
 template <typename T>
 void Map<T>::set(Attribute&& other)
 {
-    if (auto casted = dynamic_cast<const Map*>(&other)) {
+    if (auto casted = dynamic_cast<Map*>(&other)) {
         setValue(std::move(casted->m_value));
     }
 }
@@ -347,6 +390,15 @@ template <typename T>
 void Map<T>::clear()
 {
     m_value.clear();
+    changed(false);
+}
+
+template <typename T>
+void Map<T>::adoptChildren() const
+{
+    for (const auto& it : m_value) {
+        adopt(it.second);
+    }
 }
 
 template <typename T>
@@ -37,10 +37,10 @@ template <Type ValType>
 template <typename... Options, typename>
 Value<ValType>::Value(Options&&... opts)
     : IValue(std::forward<Options>(opts)...)
+    , m_def(&defaultValue<CppType>(m_ownDef, opts...))
 {
-    if (auto ret = pickOption<Default>(opts...)) {
-        m_def = ret->template get<typename ResolveType<ValType>::type>();
-        m_val = m_def;
+    if (m_def != &emptyValue<CppType>()) {
+        m_val = *m_def;
     }
 }
 
@@ -87,20 +87,26 @@ typename Value<ValType>::ConstRefType Value<ValType>::value() const
 template <Type ValType>
 typename Value<ValType>::ConstRefType Value<ValType>::defValue() const
 {
-    return m_def;
+    return *m_def;
 }
 
 template <Type ValType>
 template <typename T>
 void Value<ValType>::setValue(T&& val)
 {
-    if constexpr (isValueConstructable<T, CppType>::value) {
+    if constexpr (std::is_base_of_v<Value, std::decay_t<T>>) {
+        if (!compare(val.value())) {
+            if constexpr (std::is_lvalue_reference_v<T>) {
+                m_val = val.value();
+            } else {
+                m_val = std::move(static_cast<Value&>(val).m_val);
+            }
+            changed(hasValue());
+        }
+    } else if constexpr (isValueConstructable<T, CppType>::value) {
         if (!compare(val)) {
             m_val = val;
-        }
-    } else if constexpr (std::is_same_v<decltype(*this), std::decay_t<T>> || std::is_base_of_v<Value, std::decay_t<T>>) {
-        if (!compare(val.value())) {
-            m_val = val.value();
+            changed(hasValue());
         }
     } else {
         static_assert(always_false<T>, "Unsupported type");
@@ -191,7 +197,7 @@ void Value<ValType>::set(const Attribute& other)
 template <Type ValType>
 void Value<ValType>::set(Attribute&& other)
 {
-    if (auto casted = dynamic_cast<const Value<ValType>*>(&other)) {
+    if (auto casted = dynamic_cast<Value<ValType>*>(&other)) {
         setValue(std::move(*casted));
     }
 }
@@ -200,11 +206,11 @@ template <Type ValType>
 bool Value<ValType>::hasValue() const
 {
     if constexpr (ValType == Type::Float) {
-        return std::fabs(m_val - m_def) > std::numeric_limits<float>::epsilon();
+        return std::fabs(m_val - *m_def) > std::numeric_limits<float>::epsilon();
     } else if constexpr (ValType == Type::Double) {
-        return std::fabs(m_val - m_def) > std::numeric_limits<double>::epsilon();
+        return std::fabs(m_val - *m_def) > std::numeric_limits<double>::epsilon();
     } else {
-        return m_val != m_def;
+        return m_val != *m_def;
     }
 }
 
@@ -217,7 +223,7 @@ Type Value<ValType>::valueType() const
 template <Type ValType>
 void Value<ValType>::clear()
 {
-    setValue(m_def);
+    setValue(*m_def);
 }
 
 template <Type ValType>
@@ -25,8 +25,9 @@
 namespace pack {
 
 template <typename... Types>
-Variant<Types...>::Variant()
-    : IVariant({})
+template <typename... Options, typename>
+Variant<Types...>::Variant(Options&&... opts)
+    : IVariant(std::forward<Options>(opts)...)
 {
 }
 
@@ -48,6 +49,7 @@ template <typename... Types>
 Variant<Types...>& Variant<Types...>::operator=(const Variant& other)
 {
     m_value = other.m_value;
+    changed(true);
     return *this;
 }
 
@@ -55,6 +57,7 @@ template <typename... Types>
 Variant<Types...>& Variant<Types...>::operator=(Variant&& other)
 {
     m_value = std::move(other.m_value);
+    changed(true);
     return *this;
 }
 
@@ -127,6 +130,7 @@ template <typename T>
 T& Variant<Types...>::reset()
 {
     m_value = T{};
+    changed(true);
     return get<T>();
 }
 
@@ -157,6 +161,7 @@ void Variant<Types...>::set(const Attribute& other)
 {
     if (auto casted = dynamic_cast<const Variant<Types...>*>(&other)) {
         m_value = casted->m_value;
+        changed(true);
     }
 }
 
@@ -164,7 +169,8 @@ template <typename... Types>
 void Variant<Types...>::set(Attribute&& other)
 {
     if (auto casted = dynamic_cast<Variant<Types...>*>(&other)) {
-        m_value = casted->m_value;
+        m_value = std::move(casted->m_value);
+        changed(true);
     }
 }
 
@@ -178,6 +184,15 @@ template <typename... Types>
 void Variant<Types...>::clear()
 {
     m_value = {};
+    changed(true);
+}
+
+template <typename... Types>
+void Variant<Types...>::adoptChildren() const
+{
+    if (auto attr = get()) {
+        adopt(*attr);
+    }
 }
 
 template <typename T>
@@ -219,6 +234,7 @@ bool Variant<Types...>::findBetter(const std::vector<string_t>& fields)
                 m_value = ImplType{};
             }
         });
+        changed(true);
 
         return m_value.index() != std::variant_npos;
     } catch (const std::bad_variant_access&) {
@@ -226,4 +242,29 @@ bool Variant<Types...>::findBetter(const std::vector<string_t>& fields)
     }
 }
 
+template <typename... Types>
+int Variant<Types...>::index() const
+{
+    return m_value.index() != std::variant_npos ? int(m_value.index()) : -1;
+}
+
+template <typename... Types>
+Attribute* Variant<Types...>::emplace(int index)
+{
+    int  current = 0;
+    bool found   = false;
+    foreachType<Types...>([&](auto t) {
+        using ImplType = typename decltype(t)::Type;
+        if (current++ == index) {
+            m_value = ImplType{};
+            found   = true;
+        }
+    });
+    if (!found) {
+        return nullptr;
+    }
+    changed(true);
+    return get();
+}
+
 } // namespace pack
@@ -115,8 +115,9 @@ public:
     static string_t typeInfo();
 
 protected:
-    CppType m_val = {};
-    CppType m_def = {};
+    CppType                        m_val = {};
+    std::unique_ptr<const CppType> m_ownDef;
+    const CppType*                 m_def = &emptyValue<CppType>();
 };
 
 // =========================================================================================================================================
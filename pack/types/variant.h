@@ -28,14 +28,21 @@ namespace pack {
 class IVariant : public Attribute
 {
 public:
-    IVariant(const string_t& key)
-        : Attribute(NodeType::Variant, key)
+    template <typename... Options, typename = isOptions<Options...>>
+    explicit IVariant(Options&&... options)
+        : Attribute(NodeType::Variant, std::forward<Options>(options)...)
     {
     }
 
     virtual const Attribute* get() const                                     = 0;
     virtual Attribute*       get()                                           = 0;
     virtual bool             findBetter(const std::vector<string_t>& fields) = 0;
+
+    /// Returns index of the held alternative, -1 if there is no one
+    virtual int index() const = 0;
+
+    /// Makes the alternative of the index held with its default value, returns nullptr if there is no such alternative
+    virtual Attribute* emplace(int index) = 0;
 };
 
 // =========================================================================================================================================
@@ -44,20 +51,21 @@ template <typename... Types>
 class Variant : public IVariant
 {
 public:
-    using IVariant::IVariant;
-
     using CppType = typename std::variant<Types...>;
 
-    Variant();
+    template <typename... Options, typename = isOptions<Options...>>
+    Variant(Options&&... opts);
+
     Variant(const Variant& other);
     Variant(Variant&& other);
 
     Variant& operator=(const Variant& other);
     Variant& operator=(Variant&& other);
 
-    template <typename T, typename = std::enable_if_t<!std::is_same_v<std::decay_t<T>, Variant>>>
+    template <typename T,
+        typename = std::enable_if_t<!std::is_same_v<std::decay_t<T>, Variant> && !std::is_base_of_v<FieldOption, std::decay_t<T>>>>
     Variant(T&& val)
-        : IVariant({})
+        : IVariant()
         , m_value(val)
     {
     }
@@ -78,6 +86,8 @@ public:
     const Attribute* get() const override;
     Attribute*       get() override;
     bool             findBetter(const std::vector<string_t>& fields) override;
+    int              index() const override;
+    Attribute*       emplace(int index) override;
     static string_t  typeInfo();
 
 public:
@@ -87,6 +97,7 @@ public:
     void     set(Attribute&& other) override;
     bool     hasValue() const override;
     void     clear() override;
+    void     adoptChildren() const override;
 
 private:
     CppType m_value;
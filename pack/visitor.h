@@ -18,11 +18,31 @@
 ========================================================================================================================================= */
 #pragma once
 #include "pack/pack.h"
+#include <type_traits>
 
 namespace pack {
 
 // =========================================================================================================================================
 
+namespace details {
+
+    /// Streaming writers emit text straight into the output instead of building a resource tree, so incremental serialization keeps
+    /// written fragments of the nodes. Such writer defines Fragment type and mark(), fragment(mark), append(fragment) and
+    /// cacheKey(opt) methods.
+    template <typename Resource, typename = void>
+    struct IsStreamWriter : std::false_type
+    {
+    };
+
+    template <typename Resource>
+    struct IsStreamWriter<Resource, std::void_t<typename Resource::Fragment>> : std::true_type
+    {
+    };
+
+} // namespace details
+
+// =========================================================================================================================================
+
 template <typename Worker>
 class Deserialize
 {
@@ -131,6 +151,28 @@ public:
     template <typename Resource>
     static void visit(const INode& node, Resource& res, Option opt)
     {
+        if (isSet(opt, Option::Incremental)) {
+            if constexpr (details::IsStreamWriter<Resource>::value) {
+                uint32_t key = res.cacheKey(opt);
+                if (auto cached = node.template cached<typename Resource::Fragment>(key)) {
+                    res.append(*cached);
+                    return;
+                }
+                auto mark = res.mark();
+                node.adoptChildren();
+                Worker::packValue(node, res, opt);
+                node.setCached(res.fragment(mark), key);
+            } else {
+                if (auto cached = node.template cached<Resource>(uint32_t(opt))) {
+                    res = *cached;
+                    return;
+                }
+                node.adoptChildren();
+                Worker::packValue(node, res, opt);
+                node.setCached(res, uint32_t(opt));
+            }
+            return;
+        }
         Worker::packValue(node, res, opt);
     }
 
@@ -143,12 +185,18 @@ public:
     template <typename Resource>
     static void visit(const IList& list, Resource& res, Option opt)
     {
+        if (isSet(opt, Option::Incremental)) {
+            list.adoptChildren();
+        }
         Worker::packValue(list, res, opt);
     }
 
     template <typename Resource>
     static void visit(const IMap& map, Resource& res, Option opt)
     {
+        if (isSet(opt, Option::Incremental)) {
+            map.adoptChildren();
+        }
         Worker::packValue(map, res, opt);
     }
 
@@ -219,6 +267,9 @@ public:
     template <typename Resource>
     static void visit(const IVariant& var, Resource& res, Option opt)
     {
+        if (isSet(opt, Option::Incremental)) {
+            var.adoptChildren();
+        }
         Worker::packValue(var, res, opt);
     }
 };
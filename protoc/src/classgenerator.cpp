@@ -20,7 +20,11 @@
 #include "formatter.h"
 #include <google/protobuf/descriptor.pb.h>
 #include <google/protobuf/extension_set.h>
+#include <cmath>
+#include <cstdio>
 #include <iostream>
+#include <limits>
+#include <set>
 #include <sstream>
 
 namespace google::protobuf::compiler::pack {
@@ -102,6 +106,191 @@ static std::tuple<int, std::string> split(const std::string& s, char delim)
     return {std::stoi(elems[0]), elems[1]};
 }
 
+/// Returns true if the codec can be generated for the message. Maps, oneofs and groups are left to the reflection based providers, as
+/// well as the messages which embed such ones.
+static bool hasCodec(const Descriptor* desc, std::set<const Descriptor*>& visiting)
+{
+    if (desc->real_oneof_decl_count() || !visiting.insert(desc).second) {
+        return false;
+    }
+
+    bool ret = true;
+    for (int i = 0; i < desc->field_count() && ret; ++i) {
+        const auto& fld = desc->field(i);
+        if (fld->is_map() || fld->type() == FieldDescriptor::TYPE_GROUP) {
+            ret = false;
+        } else if (fld->is_repeated() && fld->cpp_type() == FieldDescriptor::CPPTYPE_ENUM) {
+            ret = false;
+        } else if (fld->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+            ret = hasCodec(fld->message_type(), visiting);
+        }
+    }
+
+    visiting.erase(desc);
+    return ret;
+}
+
+static bool hasCodec(const Descriptor* desc)
+{
+    std::set<const Descriptor*> visiting;
+    return hasCodec(desc, visiting);
+}
+
+/// Returns encoding of the numeric field, as it is named in pack::protobuf::Encoding
+static std::string encoding(const FieldDescriptor* fld)
+{
+    switch (fld->type()) {
+        case FieldDescriptor::TYPE_BOOL:
+            return "pack::protobuf::Encoding::Bool";
+        case FieldDescriptor::TYPE_SINT32:
+            return "pack::protobuf::Encoding::ZigZag32";
+        case FieldDescriptor::TYPE_SINT64:
+            return "pack::protobuf::Encoding::ZigZag64";
+        case FieldDescriptor::TYPE_FIXED32:
+        case FieldDescriptor::TYPE_SFIXED32:
+            return "pack::protobuf::Encoding::Fixed32";
+        case FieldDescriptor::TYPE_FIXED64:
+        case FieldDescriptor::TYPE_SFIXED64:
+            return "pack::protobuf::Encoding::Fixed64";
+        case FieldDescriptor::TYPE_FLOAT:
+            return "pack::protobuf::Encoding::Float";
+        case FieldDescriptor::TYPE_DOUBLE:
+            return "pack::protobuf::Encoding::Double";
+        default:
+            return "pack::protobuf::Encoding::Varint";
+    }
+}
+
+/// Returns C++ string literal of the bytes, all but letters and digits are escaped
+static std::string quoted(const std::string& bytes)
+{
+    std::string ret = "\"";
+    for (char ch : bytes) {
+        if (std::isalnum(static_cast<unsigned char>(ch)) || ch == ' ' || ch == '_' || ch == '-' || ch == '.') {
+            ret += ch;
+        } else {
+            char buf[5];
+            std::snprintf(buf, sizeof(buf), "\\%03o", static_cast<unsigned>(static_cast<unsigned char>(ch)));
+            ret += buf;
+        }
+    }
+    return ret + "\"";
+}
+
+/// Returns exact C++ literal of the floating point value
+template <typename T>
+static std::string floatLiteral(T value, const char* type)
+{
+    if (std::isnan(value)) {
+        return std::string("std::numeric_limits<") + type + ">::quiet_NaN()";
+    }
+    if (std::isinf(value)) {
+        return std::string(value < 0 ? "-" : "") + "std::numeric_limits<" + type + ">::infinity()";
+    }
+    if (value == 0 && !std::signbit(value)) {
+        return std::is_same_v<T, float> ? "0.0f" : "0.0";
+    }
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "%a", double(value));
+    return std::string(buf) + (std::is_same_v<T, float> ? "f" : "");
+}
+
+/// Returns the statement which sets the field to the default protobuf gives for the field which is not in the message
+static std::string resetStatement(const FieldDescriptor* fld, const std::string& name)
+{
+    switch (fld->cpp_type()) {
+        case FieldDescriptor::CPPTYPE_STRING:
+            if (fld->type() == FieldDescriptor::TYPE_BYTES) {
+                return name + ".setString(" + quoted(fld->default_value_string()) + ", " +
+                       std::to_string(fld->default_value_string().size()) + ");";
+            }
+            return name + " = " + quoted(fld->default_value_string()) + "_s;";
+        case FieldDescriptor::CPPTYPE_BOOL:
+            return name + " = " + (fld->default_value_bool() ? "true;" : "false;");
+        case FieldDescriptor::CPPTYPE_INT32:
+            return name + " = int32_t(" + std::to_string(fld->default_value_int32()) + ");";
+        case FieldDescriptor::CPPTYPE_INT64:
+            if (fld->default_value_int64() == std::numeric_limits<int64_t>::min()) {
+                return name + " = std::numeric_limits<int64_t>::min();";
+            }
+            return name + " = int64_t(" + std::to_string(fld->default_value_int64()) + "LL);";
+        case FieldDescriptor::CPPTYPE_UINT32:
+            return name + " = uint32_t(" + std::to_string(fld->default_value_uint32()) + "u);";
+        case FieldDescriptor::CPPTYPE_UINT64:
+            return name + " = uint64_t(" + std::to_string(fld->default_value_uint64()) + "ULL);";
+        case FieldDescriptor::CPPTYPE_FLOAT:
+            return name + " = " + floatLiteral(fld->default_value_float(), "float") + ";";
+        case FieldDescriptor::CPPTYPE_DOUBLE:
+            return name + " = " + floatLiteral(fld->default_value_double(), "double") + ";";
+        case FieldDescriptor::CPPTYPE_ENUM:
+            return name + ".fromInt(" + std::to_string(fld->default_value_enum()->number()) + ");";
+        case FieldDescriptor::CPPTYPE_MESSAGE:
+            return name + ".resetProto();";
+    }
+    return {};
+}
+
+/// Returns the call which writes the field in protobuf wire format
+static std::string protoWrite(const FieldDescriptor* fld, const std::string& name)
+{
+    const std::string number   = std::to_string(fld->number());
+    const std::string presence = fld->has_presence() ? "true" : "false";
+
+    switch (fld->cpp_type()) {
+        case FieldDescriptor::CPPTYPE_MESSAGE:
+            return std::string("pack::protobuf::") + (fld->is_repeated() ? "writeMessages" : "writeMessage") + "(out, " + number + ", " +
+                   name + ");";
+        case FieldDescriptor::CPPTYPE_ENUM:
+            return "pack::protobuf::writeEnum(out, " + number + ", " + name + ", " + presence + ");";
+        case FieldDescriptor::CPPTYPE_STRING:
+            if (fld->is_repeated()) {
+                return "pack::protobuf::writeBytes(out, " + number + ", " + name + ");";
+            }
+            return "pack::protobuf::writeBytes(out, " + number + ", " + name + ", " + presence + ");";
+        default:
+            if (fld->is_repeated()) {
+                return "pack::protobuf::writeNumbers<" + encoding(fld) + ">(out, " + number + ", " + name + ", " +
+                       (fld->is_packed() ? "true" : "false") + ");";
+            }
+            return "pack::protobuf::writeNumber<" + encoding(fld) + ">(out, " + number + ", " + name + ", " + presence + ");";
+    }
+}
+
+/// Returns the call which reads the field from protobuf wire format, it gives false if the value has other wire type
+static std::string protoRead(const FieldDescriptor* fld, const std::string& name)
+{
+    switch (fld->cpp_type()) {
+        case FieldDescriptor::CPPTYPE_MESSAGE:
+            return std::string("pack::protobuf::") + (fld->is_repeated() ? "readMessages" : "readMessage") + "(in, type, " + name + ")";
+        case FieldDescriptor::CPPTYPE_ENUM:
+            return "pack::protobuf::readEnum(in, type, " + name + ")";
+        case FieldDescriptor::CPPTYPE_STRING:
+            return "pack::protobuf::readBytes(in, type, " + name + ")";
+        default:
+            return std::string("pack::protobuf::") + (fld->is_repeated() ? "readNumbers<" : "readNumber<") + encoding(fld) + ">(in, type, " +
+                   name + ")";
+    }
+}
+
+/// Returns the statement which writes value of the field as json
+static std::string jsonWrite(const FieldDescriptor* fld, const std::string& name)
+{
+    switch (fld->cpp_type()) {
+        case FieldDescriptor::CPPTYPE_MESSAGE:
+            if (fld->is_repeated()) {
+                return "pack::json::writeMessages(out, " + name + ", opt);";
+            }
+            return name + ".serializeTo(out, opt);";
+        case FieldDescriptor::CPPTYPE_ENUM:
+            return "pack::json::writeEnum(out, " + name + ");";
+        default:
+            if (fld->is_repeated()) {
+                return "pack::json::writeValues(out, " + name + ", opt);";
+            }
+            return "pack::json::writeValue(out, " + name + ");";
+    }
+}
+
 void ClassGenerator::generateHeader(Formatter& frm, const std::string& descNamespace, bool asMap) const
 {
     frm << "class " << m_desc->name() << ": public pack::Node"
@@ -192,7 +381,8 @@ void ClassGenerator::generateHeader(Formatter& frm, const std::string& descNames
     }
 
     frm << "\n";
-    frm << "META(" << m_desc->name();
+    // Messages usually have only a few of their fields set
+    frm << "META_WITH_PRESENCE(" << m_desc->name();
     for (int i = 0; i < m_desc->field_count(); ++i) {
         const auto& fld = m_desc->field(i);
         frm << ", " << fld->camelcase_name();
@@ -218,6 +408,10 @@ void ClassGenerator::generateHeader(Formatter& frm, const std::string& descNames
     frm << "}\n\n";
     frm.outdent();
 
+    if (hasCodec(m_desc)) {
+        generateCodec(frm);
+    }
+
     if (m_desc->oneof_decl_count()) {
         frm << "private:\n";
         frm.indent();
@@ -239,6 +433,139 @@ void ClassGenerator::generateHeader(Formatter& frm, const std::string& descNames
     frm << "\n";
 }
 
+void ClassGenerator::generateCodec(Formatter& frm) const
+{
+    // Members are reached through this, so the locals never hide the fields
+    std::vector<std::pair<const FieldDescriptor*, std::string>> fields;
+    for (int i = 0; i < m_desc->field_count(); ++i) {
+        fields.emplace_back(m_desc->field(i), "this->" + m_desc->field(i)->camelcase_name());
+    }
+
+    frm << "public:\n";
+    frm.indent();
+
+    frm << "/// Writes the fields in protobuf wire format\n";
+    frm << "template <typename Out>\n";
+    frm << "void serializeTo(pack::protobuf::WireWriter<Out>& out) const\n";
+    frm << "{\n";
+    frm.indent();
+    if (fields.empty()) {
+        frm << "(void)out;\n";
+    }
+    for (const auto& [fld, name] : fields) {
+        frm << "if (" << name << ".hasValue()) {\n";
+        frm.indent();
+        frm << protoWrite(fld, name) << "\n";
+        frm.outdent();
+        frm << "}\n";
+    }
+    std::string required;
+    for (const auto& [fld, name] : fields) {
+        if (fld->is_required()) {
+            required += (required.empty() ? "" : ", ") + std::string("{\"") + fld->name() + "\", " + name + ".hasValue()}";
+        }
+    }
+    if (!required.empty()) {
+        frm << "pack::protobuf::checkRequired(\"" << m_desc->full_name() << "\", {" << required << "});\n";
+    }
+    frm.outdent();
+    frm << "}\n\n";
+
+    frm << "/// Merges the fields read from protobuf wire format, unknown fields are skipped. Depth is the nesting of the message.\n";
+    frm << "void parseFrom(std::string_view bytes, int depth = 0)\n";
+    frm << "{\n";
+    frm.indent();
+    frm << "pack::protobuf::WireReader in(bytes, depth);\n";
+    frm << "uint32_t number;\n";
+    frm << "pack::protobuf::WireType type;\n";
+    frm << "while (in.next(number, type)) {\n";
+    frm.indent();
+    frm << "switch (number) {\n";
+    for (const auto& [fld, name] : fields) {
+        frm << "case " << std::to_string(fld->number()) << ":\n";
+        frm.indent();
+        frm << "if (" << protoRead(fld, name) << ") {\n";
+        frm.indent();
+        frm << "continue;\n";
+        frm.outdent();
+        frm << "}\n";
+        frm << "break;\n";
+        frm.outdent();
+    }
+    frm << "default:\n";
+    frm.indent();
+    frm << "break;\n";
+    frm.outdent();
+    frm << "}\n";
+    frm << "in.skip(number, type);\n";
+    frm.outdent();
+    frm << "}\n";
+    frm.outdent();
+    frm << "}\n\n";
+
+    frm << "/// Sets the fields to the protobuf defaults, as they are for the message without them. Repeated fields are kept.\n";
+    frm << "void resetProto()\n";
+    frm << "{\n";
+    frm.indent();
+    for (const auto& [fld, name] : fields) {
+        if (!fld->is_repeated()) {
+            frm << resetStatement(fld, name) << "\n";
+        }
+    }
+    frm.outdent();
+    frm << "}\n\n";
+
+    frm << "/// Writes the fields as json object\n";
+    frm << "template <typename Out>\n";
+    frm << "void serializeTo(pack::json::JsonWriter<Out>& out, pack::Option opt) const\n";
+    frm << "{\n";
+    frm.indent();
+    if (!fields.empty()) {
+        frm << "const bool withDefaults = pack::isSet(opt, pack::Option::WithDefaults);\n";
+    }
+    frm << "out.beginObject();\n";
+    for (const auto& [fld, name] : fields) {
+        frm << "if (withDefaults || " << name << ".hasValue()) {\n";
+        frm.indent();
+        frm << "out.key(\"" << fld->name() << "\");\n";
+        frm << jsonWrite(fld, name) << "\n";
+        frm.outdent();
+        frm << "}\n";
+    }
+    frm << "out.endObject();\n";
+    frm.outdent();
+    frm << "}\n\n";
+
+    frm << "bool encodeProto(std::string& out) const override\n";
+    frm << "{\n";
+    frm.indent();
+    frm << "pack::protobuf::WireWriter<std::string> writer(out);\n";
+    frm << "serializeTo(writer);\n";
+    frm << "return true;\n";
+    frm.outdent();
+    frm << "}\n\n";
+
+    frm << "bool decodeProto(std::string_view data) override\n";
+    frm << "{\n";
+    frm.indent();
+    frm << "resetProto();\n";
+    frm << "parseFrom(data);\n";
+    frm << "return true;\n";
+    frm.outdent();
+    frm << "}\n\n";
+
+    frm << "bool encodeJson(std::string& out, pack::Option opt) const override\n";
+    frm << "{\n";
+    frm.indent();
+    frm << "pack::json::JsonWriter<std::string> writer(out, pack::isSet(opt, pack::Option::PrettyPrint));\n";
+    frm << "serializeTo(writer, opt);\n";
+    frm << "return true;\n";
+    frm.outdent();
+    frm << "}\n\n";
+
+    frm.outdent();
+}
+
 std::string ClassGenerator::cppType(const FieldDescriptor* fld) const
 {
     using namespace std::string_literals;
@@ -251,7 +578,7 @@ std::string ClassGenerator::cppType(const FieldDescriptor* fld) const
                 return "pack::String"s + (isList ? "List" : "");
             }
         case FieldDescriptor::CPPTYPE_BOOL:
-            return "pack::Bool"s + (isList ? "List>" : "");
+            return "pack::Bool"s + (isList ? "List" : "");
         case FieldDescriptor::CPPTYPE_INT64:
             return "pack::Int64"s + (isList ? "List" : "");
         case FieldDescriptor::CPPTYPE_INT32:
@@ -274,9 +601,10 @@ std::string ClassGenerator::cppType(const FieldDescriptor* fld) const
                 ++n;
             }
             if (fld->is_map()) {
-                return "pack::ProtoMap<" + name + ">";
+                // Keys of pack maps are strings, protobuf providers convert the typed keys
+                return "pack::Map<" + cppType(fld->message_type()->map_value()) + ">";
             } else {
-                return isList ? "pack::ObjectList<" + name + ">" : name;
+                return isList ? "pack::List<" + name + ">" : name;
             }
         }
     }
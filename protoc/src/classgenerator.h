@@ -34,6 +34,7 @@ public:
 
 private:
     std::string cppType(const FieldDescriptor* fld) const;
+    void        generateCodec(Formatter& frm) const;
 
 private:
     const Descriptor* m_desc;
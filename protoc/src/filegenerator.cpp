@@ -63,6 +63,7 @@ void FileGenerator::generateHeader(io::Printer& printer) const
         auto dep = m_file->dependency(i);
         frm << "#include \"" << genFileName(dep) << "\"\n";
     }
+    frm << "#include <pack/generated.h>\n";
     frm << "#include <pack/pack.h>\n";
     frm << "\n";
 
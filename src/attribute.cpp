@@ -18,19 +18,92 @@
 ========================================================================================================================================= */
 #include "pack/attribute.h"
 
+static const pack::string_t& emptyKey()
+{
+    static const pack::string_t empty;
+    return empty;
+}
+
 pack::Attribute::Attribute(NodeType type, const pack::string_t& key)
-    : m_key(key)
+    : m_key(&emptyKey())
     , m_type(type)
 {
+    setKey(key);
+}
+
+pack::Attribute::Attribute(const Attribute& other)
+    : m_key(other.m_key)
+    , m_type(other.m_type)
+{
+    if (other.m_ownKey) {
+        setKey(*other.m_ownKey);
+    }
+}
+
+pack::Attribute::Attribute(Attribute&& other) noexcept
+    : m_key(other.m_key)
+    , m_type(other.m_type)
+    , m_ownKey(std::move(other.m_ownKey))
+{
+    if (m_ownKey) {
+        other.m_key = &emptyKey();
+    }
 }
 
 pack::Attribute::~Attribute()
 {
 }
 
+pack::Attribute& pack::Attribute::operator=(const Attribute& other)
+{
+    // Owner and slot belong to the place of the attribute, not to its content
+    if (this != &other) {
+        m_ownKey.reset();
+        m_key = other.m_key;
+        if (other.m_ownKey) {
+            setKey(*other.m_ownKey);
+        }
+    }
+    m_type = other.m_type;
+    return *this;
+}
+
+pack::Attribute& pack::Attribute::operator=(Attribute&& other) noexcept
+{
+    if (this != &other) {
+        m_key    = other.m_key;
+        m_ownKey = std::move(other.m_ownKey);
+        if (m_ownKey) {
+            other.m_key = &emptyKey();
+        }
+    }
+    m_type = other.m_type;
+    return *this;
+}
+
+void pack::Attribute::setKey(const string_t& key)
+{
+    if (isEmpty(key)) {
+        m_ownKey.reset();
+        m_key = &emptyKey();
+    } else {
+        m_ownKey = std::make_unique<const string_t>(key);
+        m_key    = m_ownKey.get();
+    }
+}
+
+void pack::Attribute::adoptChildren() const
+{
+}
+
+void pack::Attribute::childChanged(uint32_t /*slot*/, bool /*present*/)
+{
+    changed(hasValue());
+}
+
 const pack::string_t& pack::Attribute::key() const
 {
-    return m_key;
+    return *m_key;
 }
 
 bool pack::Attribute::operator==(const pack::Attribute& other) const
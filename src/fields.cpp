@@ -0,0 +1,166 @@
+/* =========================================================================================================================================
+    ____ __ _ ____ __  __
+   |    |  ` |    |  /  /
+   | |  | |  | |__|    /
+   | ___| |  | |  |    \
+   |_|  |__,_|____|__\__\ DSO library
+
+   Copyright (C) 2020 Eaton
+   Copyright (C) 2020-2022 zJes
+
+   This program is free software; you can redistribute it and/or modify it under the terms of the GNU Lesser General Public License as
+   published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+========================================================================================================================================= */
+#include "pack/fields.h"
+#include "pack/types/node.h"
+
+namespace pack {
+
+// =========================================================================================================================================
+
+static uint32_t hash(std::string_view str, uint32_t seed)
+{
+    uint32_t h = 2166136261u ^ seed;
+    for (char ch : str) {
+        h ^= uint32_t(uint8_t(ch));
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// =========================================================================================================================================
+
+void FieldIndex::Table::build(const std::vector<std::string_view>& list)
+{
+    items = list;
+
+    size_t capacity = 1;
+    while (capacity < items.size() * 2) {
+        capacity <<= 1;
+    }
+    mask = uint32_t(capacity - 1);
+
+    // Try to find the seed without collisions, in this case lookup is a single probe
+    for (seed = 0; seed < 64; ++seed) {
+        slots.assign(capacity, -1);
+
+        bool collision = false;
+        for (size_t i = 0; i < items.size() && !collision; ++i) {
+            auto& slot = slots[hash(items[i], seed) & mask];
+            collision  = slot != -1;
+            slot       = int(i);
+        }
+        if (!collision) {
+            return;
+        }
+    }
+
+    // Fallback to the linear probing
+    seed = 0;
+    slots.assign(capacity, -1);
+    for (size_t i = 0; i < items.size(); ++i) {
+        uint32_t pos = hash(items[i], seed) & mask;
+        while (slots[pos] != -1) {
+            pos = (pos + 1) & mask;
+        }
+        slots[pos] = int(i);
+    }
+}
+
+int FieldIndex::Table::find(std::string_view item) const
+{
+    if (slots.empty()) {
+        return -1;
+    }
+
+    for (uint32_t pos = hash(item, seed) & mask; slots[pos] != -1; pos = (pos + 1) & mask) {
+        if (items[size_t(slots[pos])] == item) {
+            return slots[pos];
+        }
+    }
+    return -1;
+}
+
+// =========================================================================================================================================
+
+int FieldIndex::byName(const FieldInfo* fields, size_t size, std::string_view name) const
+{
+    std::call_once(m_namesOnce, [&]() {
+        std::vector<std::string_view> names;
+        names.reserve(size);
+        for (size_t i = 0; i < size; ++i) {
+            names.push_back(fields[i].name);
+        }
+        m_names.build(names);
+    });
+    return m_names.find(name);
+}
+
+int FieldIndex::byKey(const FieldInfo* fields, size_t size, std::string_view key, const INode& node) const
+{
+    std::call_once(m_keysOnce, [&]() {
+        std::vector<std::string_view> keys;
+        keys.reserve(size);
+#ifdef WITH_QTSTRING
+        m_keysStorage.reserve(size);
+        for (size_t i = 0; i < size; ++i) {
+            m_keysStorage.push_back(toStdString(fields[i].access(const_cast<INode&>(node)).key()));
+        }
+        keys.assign(m_keysStorage.begin(), m_keysStorage.end());
+#else
+        // Keys are interned, so it's safe to keep views
+        for (size_t i = 0; i < size; ++i) {
+            keys.push_back(fields[i].access(const_cast<INode&>(node)).key());
+        }
+#endif
+        m_keys.build(keys);
+    });
+    return m_keys.find(key);
+}
+
+// =========================================================================================================================================
+
+std::vector<string_t> FieldTable::names() const
+{
+    std::vector<string_t> ret;
+    ret.reserve(m_size);
+    for (const auto& it : *this) {
+        ret.push_back(fromStdString(std::string(it.name)));
+    }
+    return ret;
+}
+
+int FieldTable::indexOfName(std::string_view name) const
+{
+    if (m_index) {
+        return m_index->byName(m_data, m_size, name);
+    }
+    for (size_t i = 0; i < m_size; ++i) {
+        if (m_data[i].name == name) {
+            return int(i);
+        }
+    }
+    return -1;
+}
+
+int FieldTable::indexOfKey(std::string_view key, const INode& node) const
+{
+    if (m_index) {
+        return m_index->byKey(m_data, m_size, key, node);
+    }
+    for (size_t i = 0; i < m_size; ++i) {
+        if (toStdString(m_data[i].access(const_cast<INode&>(node)).key()) == key) {
+            return int(i);
+        }
+    }
+    return -1;
+}
+
+// =========================================================================================================================================
+
+} // namespace pack
@@ -20,6 +20,7 @@
 #include "pack/formatter.h" // IWYU pragma: keep
 #include "pack/serialization.h"
 #include <algorithm>
+#include <atomic>
 #include <regex>
 
 // =========================================================================================================================================
@@ -29,6 +30,132 @@ pack::INode::INode()
 {
 }
 
+pack::INode::INode(const INode& other)
+    : pack::Attribute(other)
+{
+}
+
+pack::INode::INode(INode&& other) noexcept
+    : pack::Attribute(std::move(other))
+{
+}
+
+pack::INode& pack::INode::operator=(const INode& other)
+{
+    Attribute::operator=(other);
+    return *this;
+}
+
+pack::INode& pack::INode::operator=(INode&& other) noexcept
+{
+    Attribute::operator=(std::move(other));
+    return *this;
+}
+
+pack::Fields<pack::Attribute> pack::INode::fields()
+{
+    return Fields<Attribute>(*this, metaFields());
+}
+
+pack::Fields<const pack::Attribute> pack::INode::fields() const
+{
+    return Fields<const Attribute>(*this, metaFields());
+}
+
+std::vector<pack::string_t> pack::INode::fieldNames() const
+{
+    return metaFields().names();
+}
+
+pack::Fields<pack::Attribute> pack::INode::presentFields()
+{
+    return Fields<Attribute>(*this, metaFields(), &m_presence);
+}
+
+pack::Fields<const pack::Attribute> pack::INode::presentFields() const
+{
+    return Fields<const Attribute>(*this, metaFields(), &m_presence);
+}
+
+const pack::Presence& pack::INode::presence() const
+{
+    return m_presence;
+}
+
+void pack::INode::bindPresence(Presence presence)
+{
+    m_presence = presence;
+
+    uint32_t slot = 0;
+    for (auto& it : fields()) {
+        adopt(it, slot);
+        if (it.type() == NodeType::Node) {
+            static_cast<const INode&>(it).adoptChildren();
+        }
+        m_presence.set(slot, it.hasValue());
+        ++slot;
+    }
+}
+
+void pack::INode::adoptChildren() const
+{
+    // Fields of the node with presence bitmap are bound on construction, with the nested nodes
+    if (m_presence) {
+        return;
+    }
+    uint32_t slot = 0;
+    for (const auto& it : fields()) {
+        adopt(it, slot++);
+        if (it.type() == NodeType::Node) {
+            static_cast<const INode&>(it).adoptChildren();
+        }
+    }
+}
+
+bool pack::INode::isDirty() const
+{
+    return !m_cache;
+}
+
+static std::atomic<uint64_t> s_cacheEpoch{1};
+
+uint64_t pack::INode::cacheEpoch()
+{
+    return s_cacheEpoch.load(std::memory_order_relaxed);
+}
+
+void pack::INode::nextCacheEpoch()
+{
+    s_cacheEpoch.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool pack::INode::ownerTracksPresence() const
+{
+    auto parent = owner();
+    return parent && parent->type() == NodeType::Node && static_cast<const INode*>(parent)->m_presence;
+}
+
+void pack::INode::childChanged(uint32_t slot, bool present)
+{
+    m_cache.reset();
+
+    // An ancestor could be cached without visiting this node, so the change goes up once per cache epoch. In the same epoch the owners
+    // are dirty already, only the presence bit of the owner could need an update.
+    const bool notify = m_notified != cacheEpoch();
+    if (m_presence) {
+        const bool before = m_presence.any();
+        m_presence.set(slot, present);
+        if (!notify && (before == m_presence.any() || !ownerTracksPresence())) {
+            return;
+        }
+    } else if (!notify && !ownerTracksPresence()) {
+        return;
+    }
+
+    m_notified = cacheEpoch();
+    changed(m_presence ? m_presence.any() : hasValue());
+}
+
 // =========================================================================================================================================
 
 
@@ -41,41 +168,61 @@ pack::string_t pack::Node::dump() const
 }
 
 
-pack::Expected<std::reference_wrapper<const pack::Attribute>> pack::Node::fieldByKey(const string_t& key) const
+pack::Expected<std::reference_wrapper<const pack::Attribute>> pack::Node::fieldByKey(std::string_view key) const
 {
-    const auto flds = fields();
-
-    auto it = std::find_if(flds.begin(), flds.end(), [&](const auto& attr) {
-        return attr.get().key() == key;
-    });
-
-    if (it != flds.end()) {
-        return *it;
+    int index = metaFields().indexOfKey(key, *this);
+    if (index >= 0) {
+        return std::cref(fields()[size_t(index)]);
     }
-
     return unexpected("Field by key was {} not found"_s, key);
 }
 
-pack::Expected<std::reference_wrapper<const pack::Attribute>> pack::Node::fieldByName(const string_t& name) const
+pack::Expected<std::reference_wrapper<const pack::Attribute>> pack::Node::fieldByName(std::string_view name) const
 {
-    auto names = fieldNames();
-    auto it    = std::find(names.begin(), names.end(), name);
-    if (it != names.end()) {
-        return fields()[size_t(std::distance(names.begin(), it))];
+    int index = metaFields().indexOfName(name);
+    if (index >= 0) {
+        return std::cref(fields()[size_t(index)]);
     }
     return unexpected("Field by name was {} not found"_s, name);
 }
 
+#ifdef WITH_QTSTRING
+pack::Expected<std::reference_wrapper<const pack::Attribute>> pack::Node::fieldByKey(const string_t& key) const
+{
+    return fieldByKey(std::string_view(toStdString(key)));
+}
+
+pack::Expected<std::reference_wrapper<const pack::Attribute>> pack::Node::fieldByName(const string_t& name) const
+{
+    return fieldByName(std::string_view(toStdString(name)));
+}
+#endif
+
 bool pack::Node::compare(const pack::Attribute& other) const
 {
+    if (other.type() != NodeType::Node) {
+        return false;
+    }
+
+    // Same static type, fields are line up
+    const auto table = metaFields();
+    if (table.begin() == static_cast<const INode&>(other).metaFields().begin()) {
+        for (const auto& it : table) {
+            if (!it.equal(*this, static_cast<const INode&>(other))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     if (auto casted = dynamic_cast<const Node*>(&other)) {
         for (const auto& it : fields()) {
-            auto ofield = casted->fieldByKey(it.get().key());
+            auto ofield = casted->fieldByKey(it.key());
             if (!ofield) {
                 return false;
             }
 
-            if (!it.get().compare(*ofield)) {
+            if (!it.compare(*ofield)) {
                 return false;
             }
         }
@@ -86,11 +233,24 @@ bool pack::Node::compare(const pack::Attribute& other) const
 
 void pack::Node::set(const Attribute& other)
 {
+    if (other.type() != NodeType::Node) {
+        return;
+    }
+
+    // Same static type, fields are line up
+    const auto table = metaFields();
+    if (table.begin() == static_cast<const INode&>(other).metaFields().begin()) {
+        for (const auto& it : table) {
+            it.assign(*this, static_cast<const INode&>(other));
+        }
+        return;
+    }
+
     if (auto casted = dynamic_cast<const Node*>(&other)) {
-        for (const auto& it : fields()) {
-            auto ofield = casted->fieldByKey(it.get().key());
+        for (auto& it : fields()) {
+            auto ofield = casted->fieldByKey(it.key());
             if (ofield) {
-                it.get().set(*ofield);
+                it.set(*ofield);
             }
         }
     }
@@ -98,11 +258,24 @@ void pack::Node::set(const Attribute& other)
 
 void pack::Node::set(Attribute&& other)
 {
+    if (other.type() != NodeType::Node) {
+        return;
+    }
+
+    // Same static type, fields are line up
+    const auto table = metaFields();
+    if (table.begin() == static_cast<const INode&>(other).metaFields().begin()) {
+        for (const auto& it : table) {
+            it.move(*this, static_cast<INode&>(other));
+        }
+        return;
+    }
+
     if (auto casted = dynamic_cast<Node*>(&other)) {
-        for (const auto& it : fields()) {
-            auto ofield = casted->fieldByKey(it.get().key());
+        for (auto& it : fields()) {
+            auto ofield = casted->fieldByKey(it.key());
             if (ofield) {
-                it.get().set(std::move(*ofield));
+                it.set(std::move(*ofield));
             }
         }
     }
@@ -110,8 +283,11 @@ void pack::Node::set(Attribute&& other)
 
 bool pack::Node::hasValue() const
 {
-    for (const auto& it : fields()) {
-        if (it.get().hasValue()) {
+    if (presence() && !presence().any()) {
+        return false;
+    }
+    for (const auto& it : presentFields()) {
+        if (it.hasValue()) {
             return true;
         }
     }
@@ -129,10 +305,25 @@ std::string pack::Node::protoName() const
     return toStdString(typeName());
 }
 
+bool pack::Node::encodeProto(std::string& /*out*/) const
+{
+    return false;
+}
+
+bool pack::Node::decodeProto(std::string_view /*data*/)
+{
+    return false;
+}
+
+bool pack::Node::encodeJson(std::string& /*out*/, Option /*opt*/) const
+{
+    return false;
+}
+
 void pack::Node::clear()
 {
-    for (auto& it : fields()) {
-        it.get().clear();
+    for (auto& it : presentFields()) {
+        it.clear();
     }
 }
 
@@ -0,0 +1,454 @@
+/* =========================================================================================================================================
+    ____ __ _ ____ __  __
+   |    |  ` |    |  /  /
+   | |  | |  | |__|    /
+   | ___| |  | |  |    \
+   |_|  |__,_|____|__\__\ DSO library
+
+   Copyright (C) 2020 Eaton
+   Copyright (C) 2020-2022 zJes
+
+   This program is free software; you can redistribute it and/or modify it under the terms of the GNU Lesser General Public License as
+   published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+========================================================================================================================================= */
+#include "pack/patch.h"
+#include <algorithm>
+#include <charconv>
+
+namespace pack {
+
+// =========================================================================================================================================
+
+/// Serialized FileDescriptorSet of the patch.proto:
+///
+///     syntax = "proto3";
+///     package pack;
+///     message Change {
+///         enum Operation { Set = 0; Insert = 1; Remove = 2; }
+///         Operation op = 1;
+///         repeated string path = 2;
+///         string value = 3;
+///     }
+///     message Patch { repeated Change changes = 1; }
+static const std::string& descriptor()
+{
+    static std::string desc(
+        "\x0a\xd7\x01\x0a\x0b\x70\x61\x74\x63\x68\x2e\x70\x72\x6f\x74\x6f\x12\x04\x70\x61\x63\x6b\x22\x88\x01\x0a\x06\x43\x68\x61\x6e\x67"
+        "\x65\x12\x26\x0a\x02\x6f\x70\x18\x01\x20\x01\x28\x0e\x32\x16\x2e\x70\x61\x63\x6b\x2e\x43\x68\x61\x6e\x67\x65\x2e\x4f\x70\x65\x72"
+        "\x61\x74\x69\x6f\x6e\x52\x02\x6f\x70\x12\x12\x0a\x04\x70\x61\x74\x68\x18\x02\x20\x03\x28\x09\x52\x04\x70\x61\x74\x68\x12\x14\x0a"
+        "\x05\x76\x61\x6c\x75\x65\x18\x03\x20\x01\x28\x09\x52\x05\x76\x61\x6c\x75\x65\x22\x2c\x0a\x09\x4f\x70\x65\x72\x61\x74\x69\x6f\x6e"
+        "\x12\x07\x0a\x03\x53\x65\x74\x10\x00\x12\x0a\x0a\x06\x49\x6e\x73\x65\x72\x74\x10\x01\x12\x0a\x0a\x06\x52\x65\x6d\x6f\x76\x65\x10"
+        "\x02\x22\x2f\x0a\x05\x50\x61\x74\x63\x68\x12\x26\x0a\x07\x63\x68\x61\x6e\x67\x65\x73\x18\x01\x20\x03\x28\x0b\x32\x0c\x2e\x70\x61"
+        "\x63\x6b\x2e\x43\x68\x61\x6e\x67\x65\x52\x07\x63\x68\x61\x6e\x67\x65\x73\x62\x06\x70\x72\x6f\x74\x6f\x33",
+        218);
+    return desc;
+}
+
+const std::string& Change::fileDescriptor() const
+{
+    return descriptor();
+}
+
+std::string Change::protoName() const
+{
+    return "pack.Change";
+}
+
+const std::string& Patch::fileDescriptor() const
+{
+    return descriptor();
+}
+
+std::string Patch::protoName() const
+{
+    return "pack.Patch";
+}
+
+// =========================================================================================================================================
+
+namespace {
+
+    using Path = std::vector<string_t>;
+
+    string_t indexKey(int index)
+    {
+        return fromStdString(std::to_string(index));
+    }
+
+    Expected<int> keyIndex(const string_t& key)
+    {
+        std::string str = toStdString(key);
+        int         index;
+        auto [ptr, ec]  = std::from_chars(str.data(), str.data() + str.size(), index);
+        if (ec != std::errc() || ptr != str.data() + str.size()) {
+            return unexpected("Wrong list index '{}'"_s, key);
+        }
+        return index;
+    }
+
+    Expected<void> addChange(Patch& patch, Change::Operation op, const Path& path, const Attribute* value = nullptr)
+    {
+        auto& change     = patch.changes.append();
+        change.operation = op;
+        change.path.setVector(path);
+        if (value) {
+            auto cnt = json::serialize(*value);
+            if (!cnt) {
+                return unexpected(cnt.error());
+            }
+            change.value = *cnt;
+        }
+        return {};
+    }
+
+    Expected<void> diffAttr(Patch& patch, Path& path, const Attribute& from, const Attribute& to);
+
+    Expected<void> diffItem(Patch& patch, Path& path, const string_t& key, const Attribute& from, const Attribute& to)
+    {
+        path.push_back(key);
+        auto ret = diffAttr(patch, path, from, to);
+        path.pop_back();
+        if (!ret) {
+            return unexpected(ret.error());
+        }
+        return {};
+    }
+
+    Expected<void> diffNode(Patch& patch, Path& path, const INode& from, const INode& to)
+    {
+        auto fromFields = from.fields();
+        auto toFields   = to.fields();
+        for (size_t i = 0; i < fromFields.size(); ++i) {
+            if (auto ret = diffItem(patch, path, fromFields[i].key(), fromFields[i], toFields[i]); !ret) {
+                return unexpected(ret.error());
+            }
+        }
+        return {};
+    }
+
+    /// Common head and tail of the lists are skipped, the rest is changed pairwise, then the tail of the longer one is inserted or
+    /// removed. Removals go from the end, so the indexes in the patch stay valid while it's applied.
+    Expected<void> diffList(Patch& patch, Path& path, const IList& from, const IList& to)
+    {
+        int fromSize = from.size();
+        int toSize   = to.size();
+
+        int head = 0;
+        while (head < fromSize && head < toSize && from.get(head).compare(to.get(head))) {
+            ++head;
+        }
+
+        int tail = 0;
+        while (tail < fromSize - head && tail < toSize - head && from.get(fromSize - tail - 1).compare(to.get(toSize - tail - 1))) {
+            ++tail;
+        }
+
+        int fromCount = fromSize - head - tail;
+        int toCount   = toSize - head - tail;
+
+        for (int i = head; i < head + std::min(fromCount, toCount); ++i) {
+            if (auto ret = diffItem(patch, path, indexKey(i), from.get(i), to.get(i)); !ret) {
+                return unexpected(ret.error());
+            }
+        }
+
+        for (int i = head + fromCount; i < head + toCount; ++i) {
+            path.push_back(indexKey(i));
+            auto ret = addChange(patch, Change::Operation::Insert, path, &to.get(i));
+            path.pop_back();
+            if (!ret) {
+                return unexpected(ret.error());
+            }
+        }
+
+        for (int i = head + fromCount - 1; i >= head + toCount; --i) {
+            path.push_back(indexKey(i));
+            auto ret = addChange(patch, Change::Operation::Remove, path);
+            path.pop_back();
+            if (!ret) {
+                return unexpected(ret.error());
+            }
+        }
+        return {};
+    }
+
+    Expected<void> diffMap(Patch& patch, Path& path, const IMap& from, const IMap& to)
+    {
+        std::vector<string_t> fromKeys = from.keys();
+        std::vector<string_t> toKeys   = to.keys();
+
+        auto contains = [](const std::vector<string_t>& keys, const string_t& key) {
+            return std::find(keys.begin(), keys.end(), key) != keys.end();
+        };
+
+        for (const auto& key : fromKeys) {
+            if (!contains(toKeys, key)) {
+                path.push_back(key);
+                auto ret = addChange(patch, Change::Operation::Remove, path);
+                path.pop_back();
+                if (!ret) {
+                    return unexpected(ret.error());
+                }
+            } else if (auto ret = diffItem(patch, path, key, from.get(key), to.get(key)); !ret) {
+                return unexpected(ret.error());
+            }
+        }
+
+        for (const auto& key : toKeys) {
+            if (!contains(fromKeys, key)) {
+                path.push_back(key);
+                auto ret = addChange(patch, Change::Operation::Insert, path, &to.get(key));
+                path.pop_back();
+                if (!ret) {
+                    return unexpected(ret.error());
+                }
+            }
+        }
+        return {};
+    }
+
+    Expected<void> diffAttr(Patch& patch, Path& path, const Attribute& from, const Attribute& to)
+    {
+        if (from.type() != to.type() || from.typeName() != to.typeName()) {
+            return addChange(patch, Change::Operation::Set, path, &to);
+        }
+
+        switch (from.type()) {
+        case Attribute::NodeType::Node:
+            return diffNode(patch, path, static_cast<const INode&>(from), static_cast<const INode&>(to));
+        case Attribute::NodeType::List:
+            return diffList(patch, path, static_cast<const IList&>(from), static_cast<const IList&>(to));
+        case Attribute::NodeType::Map:
+            return diffMap(patch, path, static_cast<const IMap&>(from), static_cast<const IMap&>(to));
+        case Attribute::NodeType::Variant: {
+            const Attribute* fromVal = static_cast<const IVariant&>(from).get();
+            const Attribute* toVal   = static_cast<const IVariant&>(to).get();
+            if (fromVal && toVal && fromVal->typeName() == toVal->typeName()) {
+                return diffAttr(patch, path, *fromVal, *toVal);
+            }
+            if (fromVal || toVal) {
+                return addChange(patch, Change::Operation::Set, path, &to);
+            }
+            return {};
+        }
+        case Attribute::NodeType::Value:
+        case Attribute::NodeType::Enum:
+            if (!from.compare(to)) {
+                return addChange(patch, Change::Operation::Set, path, &to);
+            }
+            return {};
+        }
+        return {};
+    }
+
+    // =====================================================================================================================================
+
+    /// Variants are transparent for the path, so they are stepped through till the held value
+    Expected<std::reference_wrapper<Attribute>> unwrap(Attribute& attr)
+    {
+        Attribute* cur = &attr;
+        while (cur->type() == Attribute::NodeType::Variant) {
+            cur->adoptChildren();
+            cur = static_cast<IVariant*>(cur)->get();
+            if (!cur) {
+                return unexpected("Variant '{}' has no value"_s, attr.key());
+            }
+        }
+        return std::ref(*cur);
+    }
+
+    Expected<std::reference_wrapper<Attribute>> child(Attribute& parent, const string_t& key)
+    {
+        auto found = unwrap(parent);
+        if (!found) {
+            return unexpected(found.error());
+        }
+
+        Attribute& attr = *found;
+        attr.adoptChildren();
+        switch (attr.type()) {
+        case Attribute::NodeType::Node: {
+            // Hashed lookup, the same as Node::fieldByKey does
+            auto& node  = static_cast<INode&>(attr);
+            int   index = node.metaFields().indexOfKey(toStdString(key), node);
+            if (index < 0) {
+                return unexpected("Field '{}' was not found"_s, key);
+            }
+            return std::ref(node.fields()[size_t(index)]);
+        }
+        case Attribute::NodeType::List: {
+            auto& list  = static_cast<IList&>(attr);
+            auto  index = keyIndex(key);
+            if (!index) {
+                return unexpected(index.error());
+            }
+            if (*index < 0 || *index >= list.size()) {
+                return unexpected("Index '{}' is out of range"_s, key);
+            }
+            return std::ref(list.get(*index));
+        }
+        case Attribute::NodeType::Map: {
+            auto& map  = static_cast<IMap&>(attr);
+            auto  keys = map.keys();
+            if (std::find(keys.begin(), keys.end(), key) == keys.end()) {
+                return unexpected("Key '{}' was not found"_s, key);
+            }
+            return std::ref(map.get(key));
+        }
+        case Attribute::NodeType::Value:
+        case Attribute::NodeType::Enum:
+        case Attribute::NodeType::Variant:
+            break;
+        }
+        return unexpected("Attribute '{}' has no children"_s, attr.key());
+    }
+
+    Expected<std::reference_wrapper<Attribute>> resolve(Attribute& root, const StringList& path, int count)
+    {
+        std::reference_wrapper<Attribute> cur = root;
+        for (int i = 0; i < count; ++i) {
+            auto found = child(cur, path[i]);
+            if (!found) {
+                return unexpected(found.error());
+            }
+            cur = *found;
+        }
+        return cur;
+    }
+
+    Expected<void> setValue(const Change& change, Attribute& attr)
+    {
+        if (change.value == "null"_s) {
+            return {};
+        }
+        return json::deserialize(change.value, attr);
+    }
+
+    Expected<void> applySet(const Change& change, Attribute& root)
+    {
+        auto target = resolve(root, change.path, change.path.size());
+        if (!target) {
+            return unexpected(target.error());
+        }
+        target->get().clear();
+        return setValue(change, *target);
+    }
+
+    Expected<void> applyInsert(const Change& change, Attribute& root)
+    {
+        if (change.path.empty()) {
+            return unexpected("Insert requires not empty path"_s);
+        }
+
+        auto parent = resolve(root, change.path, change.path.size() - 1);
+        if (!parent) {
+            return unexpected(parent.error());
+        }
+        auto container = unwrap(*parent);
+        if (!container) {
+            return unexpected(container.error());
+        }
+
+        const string_t& key = change.path[change.path.size() - 1];
+        if (container->get().type() == Attribute::NodeType::List) {
+            auto& list  = static_cast<IList&>(container->get());
+            auto  index = keyIndex(key);
+            if (!index) {
+                return unexpected(index.error());
+            }
+            if (*index < 0 || *index > list.size()) {
+                return unexpected("Index '{}' is out of range"_s, key);
+            }
+            return setValue(change, list.insert(*index));
+        } else if (container->get().type() == Attribute::NodeType::Map) {
+            auto& map  = static_cast<IMap&>(container->get());
+            auto  keys = map.keys();
+            if (std::find(keys.begin(), keys.end(), key) != keys.end()) {
+                return unexpected("Key '{}' already exists"_s, key);
+            }
+            return setValue(change, map.create(key));
+        }
+        return unexpected("Insert is supported only for lists and maps"_s);
+    }
+
+    Expected<void> applyRemove(const Change& change, Attribute& root)
+    {
+        if (change.path.empty()) {
+            return unexpected("Remove requires not empty path"_s);
+        }
+
+        auto parent = resolve(root, change.path, change.path.size() - 1);
+        if (!parent) {
+            return unexpected(parent.error());
+        }
+        auto container = unwrap(*parent);
+        if (!container) {
+            return unexpected(container.error());
+        }
+
+        const string_t& key = change.path[change.path.size() - 1];
+        if (container->get().type() == Attribute::NodeType::List) {
+            auto& list  = static_cast<IList&>(container->get());
+            auto  index = keyIndex(key);
+            if (!index) {
+                return unexpected(index.error());
+            }
+            if (*index < 0 || *index >= list.size()) {
+                return unexpected("Index '{}' is out of range"_s, key);
+            }
+            list.removeAt(*index);
+            return {};
+        } else if (container->get().type() == Attribute::NodeType::Map) {
+            if (!static_cast<IMap&>(container->get()).remove(key)) {
+                return unexpected("Key '{}' was not found"_s, key);
+            }
+            return {};
+        }
+        return unexpected("Remove is supported only for lists and maps"_s);
+    }
+
+    Expected<void> applyChange(const Change& change, Attribute& root)
+    {
+        switch (change.operation.value()) {
+        case Change::Operation::Set:
+            return applySet(change, root);
+        case Change::Operation::Insert:
+            return applyInsert(change, root);
+        case Change::Operation::Remove:
+            return applyRemove(change, root);
+        }
+        return unexpected("Unsupported operation {}"_s, change.operation.asString());
+    }
+
+} // namespace
+
+// =========================================================================================================================================
+
+Expected<Patch> diff(const Attribute& from, const Attribute& to)
+{
+    Patch patch;
+    Path  path;
+    if (auto ret = diffAttr(patch, path, from, to); !ret) {
+        return unexpected(ret.error());
+    }
+    return patch;
+}
+
+Expected<void> apply(const Patch& patch, Attribute& attr)
+{
+    for (const auto& change : patch.changes) {
+        if (auto ret = applyChange(change, attr); !ret) {
+            return unexpected(ret.error());
+        }
+    }
+    return {};
+}
+
+// =========================================================================================================================================
+
+} // namespace pack
@@ -0,0 +1,320 @@
+/* =========================================================================================================================================
+    ____ __ _ ____ __  __
+   |    |  ` |    |  /  /
+   | |  | |  | |__|    /
+   | ___| |  | |  |    \
+   |_|  |__,_|____|__\__\ DSO library
+
+   Copyright (C) 2020 Eaton
+   Copyright (C) 2020-2022 zJes
+
+   This program is free software; you can redistribute it and/or modify it under the terms of the GNU Lesser General Public License as
+   published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+========================================================================================================================================= */
+#include "json-structural.h"
+#include <array>
+#include <cstring>
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define PACK_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace pack::json {
+
+// =========================================================================================================================================
+
+namespace {
+
+    /// Bitmasks of one 64 bytes block, bit N is set if N-th character of the block is of the class
+    struct BlockMasks
+    {
+        uint64_t quote;
+        uint64_t backslash;
+        uint64_t op;
+        uint64_t space;
+    };
+
+    using KernelFunc = void (*)(const char* data, size_t blocks, BlockMasks* out);
+
+    enum CharClass : uint8_t
+    {
+        Quote     = 1,
+        Backslash = 2,
+        Op        = 4,
+        Space     = 8
+    };
+
+    constexpr std::array<uint8_t, 256> makeClasses()
+    {
+        std::array<uint8_t, 256> table{};
+        table[uint8_t('"')]  = Quote;
+        table[uint8_t('\\')] = Backslash;
+        for (char ch : {'{', '}', '[', ']', ':', ','}) {
+            table[uint8_t(ch)] = Op;
+        }
+        for (char ch : {' ', '\t', '\n', '\r'}) {
+            table[uint8_t(ch)] = Space;
+        }
+        return table;
+    }
+
+    constexpr std::array<uint8_t, 256> classes = makeClasses();
+
+    // =====================================================================================================================================
+
+    void scalarKernel(const char* data, size_t blocks, BlockMasks* out)
+    {
+        for (size_t block = 0; block < blocks; ++block, data += 64) {
+            BlockMasks masks{};
+            for (int i = 0; i < 64; ++i) {
+                uint8_t  cls = classes[uint8_t(data[i])];
+                uint64_t bit = uint64_t(1) << i;
+                masks.quote |= cls & Quote ? bit : 0;
+                masks.backslash |= cls & Backslash ? bit : 0;
+                masks.op |= cls & Op ? bit : 0;
+                masks.space |= cls & Space ? bit : 0;
+            }
+            out[block] = masks;
+        }
+    }
+
+#ifdef PACK_X86_KERNELS
+    __attribute__((target("sse4.2"))) uint64_t sseMask(const __m128i (&chunks)[4], char ch)
+    {
+        const __m128i pattern = _mm_set1_epi8(ch);
+
+        uint64_t mask = 0;
+        for (int i = 0; i < 4; ++i) {
+            mask |= uint64_t(uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(chunks[i], pattern)))) << (i * 16);
+        }
+        return mask;
+    }
+
+    __attribute__((target("sse4.2"))) void sse42Kernel(const char* data, size_t blocks, BlockMasks* out)
+    {
+        for (size_t block = 0; block < blocks; ++block, data += 64) {
+            const __m128i chunks[4] = {
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(data)),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16)),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 32)),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 48)),
+            };
+
+            out[block].quote     = sseMask(chunks, '"');
+            out[block].backslash = sseMask(chunks, '\\');
+            out[block].op = sseMask(chunks, '{') | sseMask(chunks, '}') | sseMask(chunks, '[') | sseMask(chunks, ']') |
+                            sseMask(chunks, ':') | sseMask(chunks, ',');
+            out[block].space = sseMask(chunks, ' ') | sseMask(chunks, '\t') | sseMask(chunks, '\n') | sseMask(chunks, '\r');
+        }
+    }
+
+    __attribute__((target("avx2"))) uint64_t avxMask(const __m256i (&chunks)[2], char ch)
+    {
+        const __m256i pattern = _mm256_set1_epi8(ch);
+
+        uint64_t lo = uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunks[0], pattern)));
+        uint64_t hi = uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunks[1], pattern)));
+        return lo | hi << 32;
+    }
+
+    __attribute__((target("avx2"))) void avx2Kernel(const char* data, size_t blocks, BlockMasks* out)
+    {
+        for (size_t block = 0; block < blocks; ++block, data += 64) {
+            const __m256i chunks[2] = {
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data)),
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + 32)),
+            };
+
+            out[block].quote     = avxMask(chunks, '"');
+            out[block].backslash = avxMask(chunks, '\\');
+            out[block].op = avxMask(chunks, '{') | avxMask(chunks, '}') | avxMask(chunks, '[') | avxMask(chunks, ']') |
+                            avxMask(chunks, ':') | avxMask(chunks, ',');
+            out[block].space = avxMask(chunks, ' ') | avxMask(chunks, '\t') | avxMask(chunks, '\n') | avxMask(chunks, '\r');
+        }
+    }
+#endif
+
+    KernelFunc kernelFunc(Kernel kernel)
+    {
+        switch (kernel) {
+#ifdef PACK_X86_KERNELS
+        case Kernel::Avx2:
+            return avx2Kernel;
+        case Kernel::Sse42:
+            return sse42Kernel;
+#else
+        case Kernel::Avx2:
+        case Kernel::Sse42:
+#endif
+        case Kernel::Scalar:
+            break;
+        }
+        return scalarKernel;
+    }
+
+    // =====================================================================================================================================
+
+    /// Turns the character masks into the index. Keeps the state between the blocks: if the block ends inside the string, after an
+    /// escaping backslash or inside a scalar.
+    class Indexer
+    {
+    public:
+        explicit Indexer(StructuralIndex& index)
+            : m_index(index)
+        {
+        }
+
+        void add(const BlockMasks& masks, uint32_t base)
+        {
+            uint64_t escaped = escapedChars(masks.backslash);
+            uint64_t quote   = masks.quote & ~escaped;
+
+            // Prefix xor of the quotes gives the string interiors, including opening quotes and excluding closing ones
+            uint64_t inString = prefixXor(quote) ^ m_inString;
+            m_inString        = uint64_t(int64_t(inString) >> 63);
+
+            uint64_t op     = masks.op & ~inString;
+            uint64_t scalar = ~(masks.op | masks.space | quote) & ~inString;
+            uint64_t starts = scalar & ~(scalar << 1 | m_inScalar);
+            m_inScalar      = scalar >> 63;
+
+            uint64_t bits = op | (quote & inString) | starts;
+            while (bits) {
+                m_index.push_back(base + uint32_t(__builtin_ctzll(bits)));
+                bits &= bits - 1;
+            }
+        }
+
+        bool inString() const
+        {
+            return m_inString != 0;
+        }
+
+    private:
+        /// Returns the characters escaped by backslash. Backslashes are rare, so they are walked one by one.
+        uint64_t escapedChars(uint64_t backslash)
+        {
+            uint64_t escaped = m_escapeNext;
+            m_escapeNext     = 0;
+
+            backslash &= ~escaped;
+            while (backslash) {
+                int pos = __builtin_ctzll(backslash);
+                if (pos == 63) {
+                    m_escapeNext = 1;
+                    break;
+                }
+                escaped |= uint64_t(1) << (pos + 1);
+                backslash &= ~(uint64_t(3) << pos);
+            }
+            return escaped;
+        }
+
+        static uint64_t prefixXor(uint64_t bits)
+        {
+            bits ^= bits << 1;
+            bits ^= bits << 2;
+            bits ^= bits << 4;
+            bits ^= bits << 8;
+            bits ^= bits << 16;
+            bits ^= bits << 32;
+            return bits;
+        }
+
+    private:
+        StructuralIndex& m_index;
+        uint64_t         m_inString   = 0;
+        uint64_t         m_inScalar   = 0;
+        uint64_t         m_escapeNext = 0;
+    };
+
+} // namespace
+
+// =========================================================================================================================================
+
+bool isSupported(Kernel kernel)
+{
+    switch (kernel) {
+    case Kernel::Scalar:
+        return true;
+#ifdef PACK_X86_KERNELS
+    case Kernel::Sse42:
+        return __builtin_cpu_supports("sse4.2");
+    case Kernel::Avx2:
+        return __builtin_cpu_supports("avx2");
+#else
+    case Kernel::Sse42:
+    case Kernel::Avx2:
+        return false;
+#endif
+    }
+    return false;
+}
+
+Kernel bestKernel()
+{
+    static const Kernel kernel = []() {
+        for (auto kernel : {Kernel::Avx2, Kernel::Sse42}) {
+            if (isSupported(kernel)) {
+                return kernel;
+            }
+        }
+        return Kernel::Scalar;
+    }();
+    return kernel;
+}
+
+bool isDelimiter(char ch)
+{
+    return classes[uint8_t(ch)] & (Op | Space);
+}
+
+void buildIndex(std::string_view json, StructuralIndex& index, Kernel kernel)
+{
+    if (json.size() >= UINT32_MAX) {
+        throw std::runtime_error("json is too big");
+    }
+    if (!isSupported(kernel)) {
+        kernel = Kernel::Scalar;
+    }
+
+    // Masks are made for a batch of blocks at once, to not pay for the indirect call for every 64 bytes
+    static constexpr size_t batch = 64;
+
+    KernelFunc func = kernelFunc(kernel);
+    Indexer    indexer(index);
+    BlockMasks masks[batch];
+
+    index.clear();
+    index.reserve(json.size() / 8);
+
+    size_t full = json.size() / 64;
+    for (size_t block = 0; block < full; block += batch) {
+        size_t count = std::min(batch, full - block);
+        func(json.data() + block * 64, count, masks);
+        for (size_t i = 0; i < count; ++i) {
+            indexer.add(masks[i], uint32_t((block + i) * 64));
+        }
+    }
+
+    if (size_t rest = json.size() % 64) {
+        char tail[64];
+        std::memset(tail, ' ', sizeof(tail));
+        std::memcpy(tail, json.data() + full * 64, rest);
+        func(tail, 1, masks);
+        indexer.add(masks[0], uint32_t(full * 64));
+    }
+
+    if (indexer.inString()) {
+        throw std::runtime_error("syntax error: unterminated string");
+    }
+}
+
+// =========================================================================================================================================
+
+} // namespace pack::json
@@ -0,0 +1,375 @@
+/* =========================================================================================================================================
+    ____ __ _ ____ __  __
+   |    |  ` |    |  /  /
+   | |  | |  | |__|    /
+   | ___| |  | |  |    \
+   |_|  |__,_|____|__\__\ DSO library
+
+   Copyright (C) 2020 Eaton
+   Copyright (C) 2020-2022 zJes
+
+   This program is free software; you can redistribute it and/or modify it under the terms of the GNU Lesser General Public License as
+   published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+========================================================================================================================================= */
+#pragma once
+#include <charconv>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pack::json {
+
+// =========================================================================================================================================
+
+/// Classifiers of the json characters, the best one supported by the cpu is selected at runtime
+enum class Kernel
+{
+    Scalar,
+    Sse42,
+    Avx2
+};
+
+/// Returns true if the kernel could be used on this cpu
+bool isSupported(Kernel kernel);
+
+/// Returns the kernel selected for this cpu
+Kernel bestKernel();
+
+/// Positions of the structural characters ({}[]:,), opening quotes of the strings and starts of the other scalars of the json text, in
+/// the order of appearance.
+using StructuralIndex = std::vector<uint32_t>;
+
+/// Builds structural index of the text, throws on unclosed string
+void buildIndex(std::string_view json, StructuralIndex& index, Kernel kernel = bestKernel());
+
+/// Returns true if the character ends a scalar token: whitespace or structural character
+bool isDelimiter(char ch);
+
+// =========================================================================================================================================
+
+/// Parses json text by its structural index and feeds SAX events to the handler (nlohmann SAX interface). Only the positions from the
+/// index are visited, characters are read only to decode the strings and scalars. Objects and arrays are parsed recursively, so the
+/// nesting is limited by MaxDepth.
+template <typename Handler>
+class StructuralParser
+{
+public:
+    static constexpr size_t MaxDepth = 1000;
+
+    /// Parser keeps decoding buffers, so it could be reused for many documents without allocations
+    explicit StructuralParser(Handler& handler)
+        : m_handler(handler)
+    {
+    }
+
+    void parse(std::string_view json, const StructuralIndex& index)
+    {
+        m_json  = json;
+        m_index = &index;
+        m_pos   = 0;
+        m_depth = 0;
+
+        if (m_index->empty()) {
+            error("unexpected end of input");
+        }
+        value(next());
+        if (m_pos != m_index->size()) {
+            error("unexpected content after the value");
+        }
+    }
+
+private:
+    uint32_t next()
+    {
+        if (m_pos >= m_index->size()) {
+            error("unexpected end of input");
+        }
+        return (*m_index)[m_pos++];
+    }
+
+    char peek() const
+    {
+        return m_pos < m_index->size() ? m_json[(*m_index)[m_pos]] : '\0';
+    }
+
+    void value(uint32_t at)
+    {
+        switch (m_json[at]) {
+        case '{':
+            enter(at);
+            object();
+            --m_depth;
+            break;
+        case '[':
+            enter(at);
+            array();
+            --m_depth;
+            break;
+        case '"':
+            string(at);
+            m_handler.string(m_string);
+            break;
+        case 't':
+            literal(at, "true");
+            m_handler.boolean(true);
+            break;
+        case 'f':
+            literal(at, "false");
+            m_handler.boolean(false);
+            break;
+        case 'n':
+            literal(at, "null");
+            m_handler.null();
+            break;
+        default:
+            number(at);
+        }
+    }
+
+    void object()
+    {
+        m_handler.start_object(size_t(-1));
+        if (peek() == '}') {
+            ++m_pos;
+            m_handler.end_object();
+            return;
+        }
+        while (true) {
+            uint32_t at = next();
+            if (m_json[at] != '"') {
+                error("object key expected", at);
+            }
+            string(at);
+            m_handler.key(m_string);
+
+            at = next();
+            if (m_json[at] != ':') {
+                error("':' expected", at);
+            }
+            value(next());
+
+            at = next();
+            if (m_json[at] == '}') {
+                break;
+            }
+            if (m_json[at] != ',') {
+                error("',' or '}' expected", at);
+            }
+        }
+        m_handler.end_object();
+    }
+
+    void array()
+    {
+        m_handler.start_array(size_t(-1));
+        if (peek() == ']') {
+            ++m_pos;
+            m_handler.end_array();
+            return;
+        }
+        while (true) {
+            value(next());
+
+            uint32_t at = next();
+            if (m_json[at] == ']') {
+                break;
+            }
+            if (m_json[at] != ',') {
+                error("',' or ']' expected", at);
+            }
+        }
+        m_handler.end_array();
+    }
+
+    void enter(uint32_t at)
+    {
+        if (++m_depth > MaxDepth) {
+            error("nesting is too deep", at);
+        }
+    }
+
+    void literal(uint32_t at, std::string_view lit)
+    {
+        if (m_json.substr(at, lit.size()) != lit || (at + lit.size() < m_json.size() && !isDelimiter(m_json[at + lit.size()]))) {
+            error("invalid literal", at);
+        }
+    }
+
+    /// Numbers are reported the same way as nlohmann does: negative integers as integer, others as unsigned, fractions and integers
+    /// out of range as float
+    void number(uint32_t at)
+    {
+        size_t end  = at;
+        bool   frac = false;
+        while (end < m_json.size() && !isDelimiter(m_json[end])) {
+            char ch = m_json[end++];
+            frac |= ch == '.' || ch == 'e' || ch == 'E';
+        }
+
+        const char* first = m_json.data() + at;
+        const char* last  = m_json.data() + end;
+        const char* digit = first[0] == '-' ? first + 1 : first;
+        if (digit == last || *digit < '0' || *digit > '9') {
+            error("invalid literal", at);
+        }
+
+        if (!frac) {
+            if (first[0] == '-') {
+                int64_t val;
+                if (auto res = std::from_chars(first, last, val); res.ec == std::errc() && res.ptr == last) {
+                    m_handler.number_integer(val);
+                    return;
+                }
+            } else {
+                uint64_t val;
+                if (auto res = std::from_chars(first, last, val); res.ec == std::errc() && res.ptr == last) {
+                    m_handler.number_unsigned(val);
+                    return;
+                }
+            }
+        }
+
+        double val;
+        if (auto res = std::from_chars(first, last, val); res.ec != std::errc() || res.ptr != last) {
+            error("invalid number", at);
+        }
+        m_number.assign(first, last);
+        m_handler.number_float(val, m_number);
+    }
+
+    /// Decodes the string starting at the opening quote into the buffer
+    void string(uint32_t at)
+    {
+        m_string.clear();
+        size_t pos = at + 1;
+        while (true) {
+            size_t from = pos;
+            while (pos < m_json.size() && m_json[pos] != '"' && m_json[pos] != '\\' && static_cast<unsigned char>(m_json[pos]) >= 0x20) {
+                ++pos;
+            }
+            m_string.append(m_json.data() + from, pos - from);
+            if (pos >= m_json.size()) {
+                error("unterminated string", at);
+            }
+
+            char ch = m_json[pos++];
+            if (ch == '"') {
+                return;
+            }
+            if (ch != '\\') {
+                error("control character in the string", pos - 1);
+            }
+            if (pos >= m_json.size()) {
+                error("unterminated string", at);
+            }
+
+            switch (m_json[pos++]) {
+            case '"':
+                m_string += '"';
+                break;
+            case '\\':
+                m_string += '\\';
+                break;
+            case '/':
+                m_string += '/';
+                break;
+            case 'b':
+                m_string += '\b';
+                break;
+            case 'f':
+                m_string += '\f';
+                break;
+            case 'n':
+                m_string += '\n';
+                break;
+            case 'r':
+                m_string += '\r';
+                break;
+            case 't':
+                m_string += '\t';
+                break;
+            case 'u':
+                unicode(pos);
+                break;
+            default:
+                error("invalid escape", pos - 1);
+            }
+        }
+    }
+
+    void unicode(size_t& pos)
+    {
+        uint32_t code = hex(pos);
+        if (code >= 0xD800 && code <= 0xDBFF) {
+            if (m_json.substr(pos, 2) != "\\u") {
+                error("missing low surrogate", pos);
+            }
+            pos += 2;
+            uint32_t low = hex(pos);
+            if (low < 0xDC00 || low > 0xDFFF) {
+                error("invalid low surrogate", pos);
+            }
+            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+        } else if (code >= 0xDC00 && code <= 0xDFFF) {
+            error("invalid surrogate", pos);
+        }
+
+        if (code < 0x80) {
+            m_string += char(code);
+        } else if (code < 0x800) {
+            m_string += char(0xC0 | (code >> 6));
+            m_string += char(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            m_string += char(0xE0 | (code >> 12));
+            m_string += char(0x80 | ((code >> 6) & 0x3F));
+            m_string += char(0x80 | (code & 0x3F));
+        } else {
+            m_string += char(0xF0 | (code >> 18));
+            m_string += char(0x80 | ((code >> 12) & 0x3F));
+            m_string += char(0x80 | ((code >> 6) & 0x3F));
+            m_string += char(0x80 | (code & 0x3F));
+        }
+    }
+
+    uint32_t hex(size_t& pos)
+    {
+        uint32_t code = 0;
+        if (pos + 4 > m_json.size()) {
+            error("unterminated string", pos);
+        }
+        auto res = std::from_chars(m_json.data() + pos, m_json.data() + pos + 4, code, 16);
+        if (res.ec != std::errc() || res.ptr != m_json.data() + pos + 4) {
+            error("invalid unicode escape", pos);
+        }
+        pos += 4;
+        return code;
+    }
+
+    [[noreturn]] void error(const char* what, size_t at = std::string_view::npos) const
+    {
+        if (at == std::string_view::npos) {
+            at = m_json.size();
+        }
+        throw std::runtime_error("syntax error at " + std::to_string(at) + ": " + what);
+    }
+
+private:
+    Handler&               m_handler;
+    std::string_view       m_json;
+    const StructuralIndex* m_index = nullptr;
+    size_t                 m_pos   = 0;
+    size_t                 m_depth = 0;
+    std::string            m_string;
+    std::string            m_number;
+};
+
+// =========================================================================================================================================
+
+} // namespace pack::json
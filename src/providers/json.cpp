@@ -16,11 +16,21 @@
    You should have received a copy of the GNU Lesser General Public License along with this program; if not, write to the Free Software
    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 ========================================================================================================================================= */
+#include "pack/json-lines.h"
+#include "pack/json-writer.h"
 #include "pack/serialization.h"
 #include "pack/visitor.h"
+#include "json-structural.h"
 #include "utils.h"
 #include "pack/utils.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <istream>
 #include <nlohmann/json.hpp>
+#include <ostream>
+#include <unistd.h>
+#include <variant>
 
 namespace pack::json {
 
@@ -42,41 +52,125 @@ Type get(const nlohmann::ordered_json& json)
 #endif
 }
 
-template<typename Type>
-void set(nlohmann::ordered_json& json, const Type& value)
-{
-#ifdef WITH_QTSTRING
-    if constexpr (std::is_same_v<Type, QString>) {
-        json = value.toStdString();
-    } else {
-        json = value;
-    }
-#else
-    json = value;
-#endif
-}
-
 template <Type ValType>
 struct Convert
 {
     using CppType = typename ResolveType<ValType>::type;
 
-    static void decode(Value<ValType>& node, const nlohmann::ordered_json& json)
+    /// Sets the value from the document, scalars are handled as tokens of the stream. Returns false if the value is skipped.
+    static Expected<bool> decode(Value<ValType>& node, const nlohmann::ordered_json& json, Coercion coercion)
     {
-        if (!json.is_null()) {
-            try {
-                node = get<CppType>(json);
-            } catch (const nlohmann::json::type_error& /*err*/) {
-                if constexpr (ValType != Type::Binary) {
-                    node = convert<CppType>(get<std::string>(json));
+        using JsonType = nlohmann::ordered_json::value_t;
+
+        switch (json.type()) {
+        case JsonType::null:
+            return true;
+        case JsonType::boolean:
+            return assign(node, json.get<bool>(), coercion);
+        case JsonType::number_integer:
+            return assign(node, json.get<int64_t>(), coercion);
+        case JsonType::number_unsigned:
+            return assign(node, json.get<uint64_t>(), coercion);
+        case JsonType::number_float:
+            return assign(node, json.get<double>(), coercion);
+        case JsonType::string:
+            return assign(node, std::string_view(json.get_ref<const std::string&>()), coercion);
+        case JsonType::array:
+            if constexpr (ValType == Type::Binary) {
+                std::vector<std::byte> bytes;
+                bytes.reserve(json.size());
+                for (const auto& byte : json) {
+                    if (!byte.is_number_integer()) {
+                        return mismatch(byte.type_name(), coercion);
+                    }
+                    bytes.push_back(std::byte(byte.get<int64_t>()));
                 }
+                node = std::move(bytes);
+                return true;
             }
+            break;
+        default:
+            break;
+        }
+        return mismatch(json.type_name(), coercion);
+    }
+
+    /// Sets the value from the scalar token. Token of the value type is set as is, other tokens are handled by the coercion mode: in
+    /// coerce mode strings are parsed into the numbers and numbers are casted, the types are checked up front, nothing is thrown.
+    /// Returns false if the value is skipped.
+    template <typename From>
+    static Expected<bool> assign(Value<ValType>& node, const From& value, Coercion coercion)
+    {
+        if constexpr (isExact<From>()) {
+            if constexpr (std::is_same_v<From, std::string_view>) {
+                node = fromStdString(std::string(value));
+            } else {
+                node = static_cast<CppType>(value);
+            }
+            return true;
+        } else {
+            if (coercion == Coercion::Coerce) {
+                if constexpr (std::is_same_v<From, std::string_view> && ValType == Type::Binary) {
+                    // Binary is always an array of bytes, string is skipped as it always was
+                    return false;
+                } else if constexpr (std::is_same_v<From, std::string_view>) {
+                    auto ret = tryConvert<CppType>(value);
+                    if (!ret) {
+                        return unexpected(ret.error());
+                    }
+                    node = std::move(*ret);
+                    return true;
+                } else if constexpr (std::is_arithmetic_v<CppType> && ValType != Type::Bool) {
+                    node = static_cast<CppType>(value);
+                    return true;
+                }
+            }
+            return mismatch(tokenName<From>(), coercion);
+        }
+    }
+
+    template <typename Writer>
+    static void encode(const Value<ValType>& node, Writer& writer)
+    {
+        writer.value(node.value());
+    }
+
+private:
+    /// Token of the json type which is set without coercion
+    template <typename From>
+    static constexpr bool isExact()
+    {
+        if constexpr (ValType == Type::String) {
+            return std::is_same_v<From, std::string_view>;
+        } else if constexpr (ValType == Type::Bool) {
+            return std::is_same_v<From, bool>;
+        } else if constexpr (std::is_integral_v<CppType>) {
+            return std::is_same_v<From, int64_t> || std::is_same_v<From, uint64_t>;
+        } else if constexpr (std::is_floating_point_v<CppType>) {
+            return std::is_same_v<From, int64_t> || std::is_same_v<From, uint64_t> || std::is_same_v<From, double>;
+        } else {
+            return false;
         }
     }
 
-    static void encode(const Value<ValType>& node, nlohmann::ordered_json& json)
+    template <typename From>
+    static constexpr const char* tokenName()
     {
-        set(json, node.value());
+        if constexpr (std::is_same_v<From, bool>) {
+            return "boolean";
+        } else if constexpr (std::is_same_v<From, std::string_view>) {
+            return "string";
+        } else {
+            return "number";
+        }
+    }
+
+    static Expected<bool> mismatch(const char* jsonType, Coercion coercion)
+    {
+        if (coercion == Coercion::Ignore) {
+            return false;
+        }
+        return unexpected("Cannot convert json {} to {}"_s, jsonType, valueTypeName(ValType));
     }
 };
 
@@ -85,172 +179,881 @@ struct Convert
 class JsonSerializer : public Serialize<JsonSerializer>
 {
 public:
-    template <typename T>
-    static void packValue(const T& val, nlohmann::ordered_json& json, Option opt)
+    template <typename T, typename Writer>
+    static void packValue(const T& val, Writer& writer, Option opt)
     {
         if (val.hasValue() || isSet(opt, Option::WithDefaults)) {
-            Convert<T::ThisType>::encode(val, json);
+            Convert<T::ThisType>::encode(val, writer);
+        } else {
+            writer.null();
         }
     }
 
-    static void packValue(const IMap& val, nlohmann::ordered_json& json, Option opt)
+    template <typename Writer>
+    static void packValue(const IMap& val, Writer& writer, Option opt)
     {
         if (val.size()) {
+            writer.beginObject();
             for (int i = 0; i < val.size(); ++i) {
-                const auto&            key  = val.keyByIndex(i);
-                const Attribute&       node = val.get(key);
-                nlohmann::ordered_json child;
-
-                visit(node, child, opt);
-                json[toStdString(key)] = child;
+                const auto& key = val.keyByIndex(i);
+                writer.key(toStdString(key));
+                visit(val.get(key), writer, opt);
             }
+            writer.endObject();
         } else if (isSet(opt, Option::WithDefaults)) {
-            json = nlohmann::json::object();
+            writer.beginObject();
+            writer.endObject();
+        } else {
+            writer.null();
         }
     }
 
-    static void packValue(const IList& val, nlohmann::ordered_json& json, Option opt)
+    template <typename Writer>
+    static void packValue(const IList& val, Writer& writer, Option opt)
     {
         if (val.size()) {
+            writer.beginArray();
             for (int i = 0; i < val.size(); ++i) {
-                const Attribute&       node = val.get(i);
-                nlohmann::ordered_json child;
-                visit(node, child, opt);
-                json.push_back(child);
+                writer.item();
+                visit(val.get(i), writer, opt);
             }
+            writer.endArray();
         } else if (isSet(opt, Option::WithDefaults)) {
-            json = nlohmann::json::array();
+            writer.beginArray();
+            writer.endArray();
+        } else {
+            writer.null();
         }
     }
 
-    static void packValue(const INode& node, nlohmann::ordered_json& json, Option opt)
+    template <typename Writer>
+    static void packValue(const INode& node, Writer& writer, Option opt)
     {
-        json = nlohmann::json::object();
-        for (auto& it : node.fields()) {
-            if (it.get().hasValue() || isSet(opt, Option::WithDefaults)) {
-                nlohmann::ordered_json& child = json[toStdString(it.get().key())];
-                visit(it.get(), child, opt);
+        writer.beginObject();
+
+        const bool withDefaults = isSet(opt, Option::WithDefaults);
+        for (auto& it : withDefaults ? node.fields() : node.presentFields()) {
+            if (withDefaults || it.hasValue()) {
+                writer.key(toStdString(it.key()));
+                visit(it, writer, opt);
             }
         }
+
+        writer.endObject();
     }
 
-    static void packValue(const IEnum& en, nlohmann::ordered_json& json, Option /*opt*/)
+    template <typename Writer>
+    static void packValue(const IEnum& en, Writer& writer, Option /*opt*/)
     {
-        json = toStdString(en.asString());
+        writer.string(toStdString(en.asString()));
     }
 
-    static void packValue(const IVariant& var, nlohmann::ordered_json& yaml, Option opt)
+    template <typename Writer>
+    static void packValue(const IVariant& var, Writer& writer, Option opt)
     {
         if (auto ptr = var.get()) {
-            packValue(static_cast<const INode&>(*ptr), yaml, opt);
+            packValue(static_cast<const INode&>(*ptr), writer, opt);
+        } else {
+            writer.null();
         }
     }
 };
 
 // =========================================================================================================================================
 
+/// Json document with the coercion mode to read it with
+struct Document
+{
+    const nlohmann::ordered_json& json;
+    Coercion                      coercion;
+    /// Set if the value was skipped in ignore mode
+    mutable bool skipped = false;
+};
+
 class JsonDeserializer : public Deserialize<JsonDeserializer>
 {
 public:
     template <typename T>
-    static void unpackValue(T& val, const nlohmann::ordered_json& json)
+    static void unpackValue(T& val, const Document& doc)
     {
-        Convert<T::ThisType>::decode(val, json);
+        auto ret = Convert<T::ThisType>::decode(val, doc.json, doc.coercion);
+        if (!ret) {
+            throw std::runtime_error(toStdString(ret.error()));
+        }
+        doc.skipped = !*ret;
     }
 
-    static void unpackValue(IEnum& en, const nlohmann::ordered_json& json)
+    static void unpackValue(IEnum& en, const Document& doc)
     {
-        en.fromString(get<string_t>(json));
+        if (doc.json.is_string()) {
+            en.fromString(get<string_t>(doc.json));
+        } else if (!doc.json.is_null()) {
+            mismatch("Enum value should be a string", doc);
+        }
     }
 
-    static void unpackValue(IMap& map, const nlohmann::ordered_json& json)
+    static void unpackValue(IMap& map, const Document& doc)
     {
-        for (const auto& [key, value] : json.items()) {
+        if (!doc.json.is_object() && !doc.json.is_null()) {
+            return mismatch("Unexpected " + std::string(doc.json.type_name()) + " for " + toStdString(map.typeName()), doc);
+        }
+        for (const auto& [key, value] : doc.json.items()) {
             auto& obj = map.create(fromStdString(key));
-            visit(obj, value);
+            visit(obj, Document{value, doc.coercion});
         }
     }
 
-    static void unpackValue(IList& list, const nlohmann::ordered_json& json)
+    static void unpackValue(IList& list, const Document& doc)
     {
-        for (const auto& child : json) {
-            auto& obj = list.create();
-            visit(obj, child);
+        for (const auto& child : doc.json) {
+            Document item{child, doc.coercion};
+            visit(list.create(), item);
+            if (item.skipped) {
+                list.removeAt(list.size() - 1);
+            }
         }
     }
 
-    static void unpackValue(INode& node, const nlohmann::ordered_json& json)
+    static void unpackValue(INode& node, const Document& doc)
     {
+        if (!doc.json.is_object() && !doc.json.is_null()) {
+            return mismatch("Unexpected " + std::string(doc.json.type_name()) + " for " + toStdString(node.typeName()), doc);
+        }
         for (auto& it : node.fields()) {
-            if (json.contains(toStdString(it.get().key()))) {
-                visit(it.get(), json[toStdString(it.get().key())]);
+            auto found = doc.json.find(toStdString(it.key()));
+            if (found != doc.json.end()) {
+                visit(it, Document{*found, doc.coercion});
             }
         }
     }
 
-    static void unpackValue(IVariant& var, const nlohmann::ordered_json& json)
+    static void unpackValue(IVariant& var, const Document& doc)
     {
         std::vector<string_t> keys;
-        for (const auto& it : json.items()) {
+        for (const auto& it : doc.json.items()) {
             keys.push_back(fromStdString(it.key()));
         }
         if (var.findBetter(keys)) {
             if (auto ptr = var.get()) {
-                unpackValue(static_cast<INode&>(*ptr), json);
+                unpackValue(static_cast<INode&>(*ptr), doc);
             }
         }
     }
+
+private:
+    /// Value of the document does not fit the attribute, it is skipped in ignore mode
+    static void mismatch(const std::string& error, const Document& doc)
+    {
+        if (doc.coercion != Coercion::Ignore) {
+            throw std::runtime_error(error);
+        }
+        doc.skipped = true;
+    }
 };
 
 
 // =========================================================================================================================================
 
-Expected<string_t> serialize(const Attribute& node, Option opt)
+/// Sets scalar tokens of the json stream into the attributes
+class JsonScalar : public Deserialize<JsonScalar>
 {
-    try {
-        nlohmann::ordered_json json;
-        JsonSerializer::visit(node, json, opt);
-        if(isSet(opt, Option::PrettyPrint)) {
-            return fromStdString(json.dump(4));
+public:
+    using Token = std::variant<bool, int64_t, uint64_t, double, std::string_view>;
+
+    struct Scalar
+    {
+        Token    token;
+        Coercion coercion;
+        /// Set if the token was skipped in ignore mode
+        mutable bool skipped = false;
+    };
+
+    template <typename T>
+    static void unpackValue(T& val, const Scalar& scalar)
+    {
+        auto ret = std::visit(
+            [&](const auto& value) {
+                return Convert<T::ThisType>::assign(val, value, scalar.coercion);
+            },
+            scalar.token);
+        if (!ret) {
+            throw std::runtime_error(toStdString(ret.error()));
+        }
+        scalar.skipped = !*ret;
+    }
+
+    static void unpackValue(IEnum& en, const Scalar& scalar)
+    {
+        if (auto str = std::get_if<std::string_view>(&scalar.token)) {
+            en.fromString(fromStdString(std::string(*str)));
+        } else if (scalar.coercion != Coercion::Ignore) {
+            throw std::runtime_error("Enum value should be a string");
+        } else {
+            scalar.skipped = true;
+        }
+    }
+
+    static void unpackValue(IList& list, const Scalar& scalar)
+    {
+        visit(list.create(), scalar);
+        if (scalar.skipped) {
+            list.removeAt(list.size() - 1);
+        }
+    }
+
+    static void unpackValue(IMap& map, const Scalar& scalar)
+    {
+        structure(map, scalar);
+    }
+
+    static void unpackValue(INode& node, const Scalar& scalar)
+    {
+        structure(node, scalar);
+    }
+
+    static void unpackValue(IVariant& var, const Scalar& scalar)
+    {
+        structure(var, scalar);
+    }
+
+private:
+    /// Scalar in place of the structure is skipped, in reject mode it is an error
+    static void structure(const Attribute& attr, const Scalar& scalar)
+    {
+        if (scalar.coercion == Coercion::Reject) {
+            throw std::runtime_error("Unexpected scalar for " + toStdString(attr.typeName()));
+        }
+        scalar.skipped = true;
+    }
+};
+
+// =========================================================================================================================================
+
+/// SAX handler which fills the attribute while json is parsed, without building of the document. Every value token is routed to the
+/// attribute it belongs to: node members are looked up in the field index by the key, unknown members are skipped. Variants need all
+/// the member keys to choose the alternative, so their subtree only is collected into the document and deserialized from it.
+class JsonReader
+{
+public:
+    explicit JsonReader(Attribute& root, Coercion coercion = Coercion::Coerce)
+        : m_root(&root)
+        , m_coercion(coercion)
+    {
+    }
+
+    /// Starts reading of the next document into the root, keeps allocated buffers
+    void reset(Attribute& root)
+    {
+        m_root    = &root;
+        m_pending = nullptr;
+        m_stack.clear();
+        m_dom.reset();
+        m_domDepth = 0;
+    }
+
+public:
+    bool null()
+    {
+        if (m_dom) {
+            return m_dom->null();
+        }
+        if (!m_stack.empty() && m_stack.back().kind == Kind::Binary) {
+            mismatch("Binary value should be an array of bytes");
+            return true;
+        }
+        next();
+        return true;
+    }
+
+    bool boolean(bool val)
+    {
+        if (m_dom) {
+            return m_dom->boolean(val);
+        }
+        return scalar(val);
+    }
+
+    bool number_integer(int64_t val)
+    {
+        if (m_dom) {
+            return m_dom->number_integer(val);
+        }
+        return scalar(val);
+    }
+
+    bool number_unsigned(uint64_t val)
+    {
+        if (m_dom) {
+            return m_dom->number_unsigned(val);
+        }
+        return scalar(val);
+    }
+
+    bool number_float(double val, const std::string& str)
+    {
+        if (m_dom) {
+            return m_dom->number_float(val, str);
+        }
+        return scalar(val);
+    }
+
+    bool string(std::string& val)
+    {
+        if (m_dom) {
+            return m_dom->string(val);
+        }
+        return scalar(std::string_view(val));
+    }
+
+    bool binary(nlohmann::ordered_json::binary_t& /*val*/)
+    {
+        return true;
+    }
+
+    bool start_object(size_t size)
+    {
+        if (m_dom) {
+            ++m_domDepth;
+            return m_dom->start_object(size);
+        }
+
+        Attribute* target = next();
+        if (!target) {
+            m_stack.push_back({Kind::Skip, nullptr});
+        } else if (target->type() == Attribute::NodeType::Node) {
+            m_stack.push_back({Kind::Node, target});
+        } else if (target->type() == Attribute::NodeType::Map) {
+            m_stack.push_back({Kind::Map, target});
+        } else if (target->type() == Attribute::NodeType::Variant) {
+            startDom(static_cast<IVariant&>(*target));
+            return m_dom->start_object(size);
+        } else {
+            mismatch("Unexpected object for " + toStdString(target->typeName()));
+            m_stack.push_back({Kind::Skip, nullptr});
+        }
+        return true;
+    }
+
+    bool key(std::string& val)
+    {
+        if (m_dom) {
+            return m_dom->key(val);
+        }
+
+        Frame& top = m_stack.back();
+        if (top.kind == Kind::Node) {
+            auto& node  = static_cast<INode&>(*top.attr);
+            int   index = node.metaFields().indexOfKey(val, node);
+            m_pending   = index >= 0 ? &node.fields()[size_t(index)] : nullptr;
+        } else if (top.kind == Kind::Map) {
+            m_pending = &static_cast<IMap&>(*top.attr).create(fromStdString(val));
+        }
+        return true;
+    }
+
+    bool end_object()
+    {
+        if (m_dom) {
+            return endDom(m_dom->end_object());
+        }
+        m_stack.pop_back();
+        return true;
+    }
+
+    bool start_array(size_t size)
+    {
+        if (m_dom) {
+            ++m_domDepth;
+            return m_dom->start_array(size);
+        }
+
+        Attribute* target = next();
+        if (!target || target->type() == Attribute::NodeType::Node || target->type() == Attribute::NodeType::Map) {
+            m_stack.push_back({Kind::Skip, nullptr});
+        } else if (target->type() == Attribute::NodeType::List) {
+            m_stack.push_back({Kind::List, target});
+        } else if (target->type() == Attribute::NodeType::Variant) {
+            startDom(static_cast<IVariant&>(*target));
+            return m_dom->start_array(size);
+        } else if (target->type() == Attribute::NodeType::Value && static_cast<IValue*>(target)->valueType() == Type::Binary) {
+            m_bytes.clear();
+            m_stack.push_back({Kind::Binary, target});
         } else {
-            return fromStdString(json.dump());
+            mismatch("Unexpected array for " + toStdString(target->typeName()));
+            m_stack.push_back({Kind::Skip, nullptr});
+        }
+        return true;
+    }
+
+    bool end_array()
+    {
+        if (m_dom) {
+            return endDom(m_dom->end_array());
+        }
+        if (m_stack.back().kind == Kind::Binary) {
+            static_cast<Binary&>(*m_stack.back().attr) = m_bytes;
+        }
+        m_stack.pop_back();
+        return true;
+    }
+
+    bool parse_error(size_t /*pos*/, const std::string& /*token*/, const nlohmann::detail::exception& ex)
+    {
+        throw std::runtime_error(ex.what());
+    }
+
+private:
+    enum class Kind
+    {
+        Node,
+        Map,
+        List,
+        Binary,
+        Skip
+    };
+
+    struct Frame
+    {
+        Kind       kind;
+        Attribute* attr;
+    };
+
+    using DomParser = nlohmann::detail::json_sax_dom_parser<nlohmann::ordered_json>;
+
+private:
+    /// Returns the attribute for the next value of the stream, nullptr if the value should be skipped
+    Attribute* next()
+    {
+        if (m_stack.empty()) {
+            return std::exchange(m_root, nullptr);
+        }
+
+        Frame& top = m_stack.back();
+        switch (top.kind) {
+        case Kind::Node:
+        case Kind::Map:
+            return std::exchange(m_pending, nullptr);
+        case Kind::List:
+            return &static_cast<IList&>(*top.attr).create();
+        case Kind::Binary:
+        case Kind::Skip:
+            break;
+        }
+        return nullptr;
+    }
+
+    template <typename T>
+    bool scalar(const T& val)
+    {
+        if (!m_stack.empty() && m_stack.back().kind == Kind::Binary) {
+            if constexpr (std::is_integral_v<T> && !std::is_same_v<T, bool>) {
+                m_bytes.push_back(std::byte(val));
+                return true;
+            } else {
+                mismatch("Binary value should be an array of bytes");
+                return true;
+            }
+        }
+
+        if (Attribute* target = next()) {
+            JsonScalar::Scalar token{val, m_coercion};
+            JsonScalar::visit(*target, token);
+            if (token.skipped && m_coercion == Coercion::Ignore && !m_stack.empty() && m_stack.back().kind == Kind::List) {
+                auto& list = static_cast<IList&>(*m_stack.back().attr);
+                list.removeAt(list.size() - 1);
+            }
+        }
+        return true;
+    }
+
+    /// Value of the stream does not fit the attribute, it is skipped in ignore mode
+    void mismatch(const std::string& error)
+    {
+        if (m_coercion != Coercion::Ignore) {
+            throw std::runtime_error(error);
+        }
+    }
+
+    void startDom(IVariant& var)
+    {
+        m_domTarget = &var;
+        m_domJson   = nlohmann::ordered_json();
+        m_dom       = std::make_unique<DomParser>(m_domJson);
+        m_domDepth  = 1;
+    }
+
+    bool endDom(bool ret)
+    {
+        if (--m_domDepth == 0) {
+            m_dom.reset();
+            JsonDeserializer::visit(*m_domTarget, Document{m_domJson, m_coercion});
+        }
+        return ret;
+    }
+
+private:
+    Attribute*                 m_root;
+    Coercion                   m_coercion;
+    Attribute*                 m_pending = nullptr;
+    std::vector<Frame>         m_stack;
+    std::vector<std::byte>     m_bytes;
+    std::unique_ptr<DomParser> m_dom;
+    nlohmann::ordered_json     m_domJson;
+    IVariant*                  m_domTarget = nullptr;
+    int                        m_domDepth  = 0;
+};
+
+// =========================================================================================================================================
+
+/// Writes the node with the code protoc-gen-pack generated for it, returns false if there is no one. Incremental serialization keeps the
+/// visitor as only it caches the nodes.
+template <typename Out>
+static bool encodeGenerated(const Attribute& node, Out& out, Option opt)
+{
+    if (node.type() != Attribute::NodeType::Node || isSet(opt, Option::Incremental)) {
+        return false;
+    }
+    const auto& obj = static_cast<const INode&>(node);
+    if constexpr (std::is_same_v<Out, std::string>) {
+        return obj.encodeJson(out, opt);
+    } else {
+        std::string buffer;
+        if (!obj.encodeJson(buffer, opt)) {
+            return false;
         }
-        
+        out.insert(out.end(), buffer.begin(), buffer.end());
+        return true;
+    }
+}
+
+template <typename Out>
+static Expected<void> serializeTo(const Attribute& node, Out& out, Option opt)
+{
+    size_t mark = out.size();
+    try {
+        if (encodeGenerated(node, out, opt)) {
+            return {};
+        }
+        JsonWriter writer(out, isSet(opt, Option::PrettyPrint));
+        JsonSerializer::visit(node, writer, opt);
+        return {};
     } catch (const std::exception& e) {
+        out.resize(mark);
         return unexpected(e.what());
     }
 }
 
+Expected<string_t> serialize(const Attribute& node, Option opt)
+{
+    std::string out;
+    if (auto ret = serializeTo(node, out, opt); !ret) {
+        return unexpected(ret.error());
+    }
+    return fromStdString(out);
+}
+
+Expected<void> serialize(const Attribute& node, std::string& out, Option opt)
+{
+    return serializeTo(node, out, opt);
+}
+
+Expected<void> serialize(const Attribute& node, std::vector<char>& out, Option opt)
+{
+    return serializeTo(node, out, opt);
+}
+
+Expected<void> serialize(const Attribute& node, Sink& sink, Option opt)
+{
+    return staged(
+        [&](std::string& buffer) {
+            return serializeTo(node, buffer, opt);
+        },
+        [&](std::string_view buffer) {
+            return sink.write(buffer.data(), buffer.size());
+        });
+}
+
 Expected<void> deserialize(const string_t& content, Attribute& node)
+{
+    return deserialize(content, node, Parser::Sax);
+}
+
+Expected<void> deserialize(const string_t& content, Attribute& node, Parser parser)
+{
+    return deserialize(content, node, parser, Coercion::Coerce);
+}
+
+Expected<void> deserialize(const string_t& content, Attribute& node, Parser parser, Coercion coercion)
+{
+#ifdef WITH_QTSTRING
+    return deserialize(std::string_view(content.toStdString()), node, parser, coercion);
+#else
+    return deserialize(std::string_view(content), node, parser, coercion);
+#endif
+}
+
+Expected<void> deserialize(std::string_view content, Attribute& node)
+{
+    return deserialize(content, node, Parser::Sax);
+}
+
+Expected<void> deserialize(std::string_view content, Attribute& node, Parser parser)
+{
+    return deserialize(content, node, parser, Coercion::Coerce);
+}
+
+Expected<void> deserialize(std::string_view content, Attribute& node, Parser parser, Coercion coercion)
 {
     try {
-        nlohmann::ordered_json json = nlohmann::ordered_json::parse(toStdString(content));
-        JsonDeserializer::visit(node, json);
+        JsonReader reader(node, coercion);
+        if (parser == Parser::Structural) {
+            StructuralIndex index;
+            buildIndex(content, index);
+            StructuralParser<JsonReader>(reader).parse(content, index);
+        } else {
+            nlohmann::ordered_json::sax_parse(content, &reader);
+        }
         return {};
     } catch (const std::exception& e) {
         return unexpected(e.what());
     }
 }
 
+Expected<void> deserialize(const std::byte* data, size_t size, Attribute& node, Parser parser, Coercion coercion)
+{
+    return deserialize(std::string_view(reinterpret_cast<const char*>(data), size), node, parser, coercion);
+}
+
+Expected<void> deserialize(const char* content, Attribute& node, Parser parser, Coercion coercion)
+{
+    return deserialize(std::string_view(content), node, parser, coercion);
+}
+
 Expected<void> deserializeFile(const string_t& fileName, Attribute& node)
 {
-    if (auto cnt = read(fileName)) {
-        return deserialize(*cnt, node);
-    } else {
-        return unexpected(cnt.error());
+    std::string content;
+    if (auto ret = read(fileName, content); !ret) {
+        return unexpected(ret.error());
     }
+    return deserialize(std::string_view(content), node);
 }
 
 Expected<void> serializeFile(const string_t& fileName, const Attribute& node, Option opt)
 {
-    if (auto ret = serialize(node, opt)) {
-        if (auto res = write(fileName, *ret); !res) {
-            return unexpected(res.error());
+    return staged(
+        [&](std::string& buffer) {
+            return serializeTo(node, buffer, opt);
+        },
+        [&](std::string_view buffer) {
+            return write(fileName, buffer);
+        });
+}
+
+// =========================================================================================================================================
+
+struct BasicLinesReader::State
+{
+    explicit State(Attribute& record)
+        : reader(record)
+        , parser(reader)
+    {
+    }
+
+    JsonReader                   reader;
+    StructuralIndex              index;
+    StructuralParser<JsonReader> parser;
+};
+
+BasicLinesReader::BasicLinesReader(std::istream& stream, Parser parser, size_t bufferSize)
+    : m_stream(&stream)
+    , m_parser(parser)
+    , m_buffer(std::max<size_t>(bufferSize, 1))
+{
+}
+
+BasicLinesReader::BasicLinesReader(int fd, Parser parser, size_t bufferSize)
+    : m_fd(fd)
+    , m_parser(parser)
+    , m_buffer(std::max<size_t>(bufferSize, 1))
+{
+}
+
+BasicLinesReader::~BasicLinesReader() = default;
+
+Expected<bool> BasicLinesReader::read(Attribute& record)
+{
+    std::string_view line;
+    if (auto ret = nextLine(line); !ret) {
+        return unexpected(ret.error());
+    } else if (!*ret) {
+        return false;
+    }
+
+    record.clear();
+    try {
+        if (m_state) {
+            m_state->reader.reset(record);
+        } else {
+            m_state = std::make_unique<State>(record);
+        }
+        if (m_parser == Parser::Structural) {
+            buildIndex(line, m_state->index);
+            m_state->parser.parse(line, m_state->index);
+        } else {
+            nlohmann::ordered_json::sax_parse(line, &m_state->reader);
+        }
+        return true;
+    } catch (const std::exception& e) {
+        return unexpected("Line {}: {}"_s, m_line, e.what());
+    }
+}
+
+size_t BasicLinesReader::line() const
+{
+    return m_line;
+}
+
+Expected<bool> BasicLinesReader::nextLine(std::string_view& line)
+{
+    auto isBlank = [](std::string_view str) {
+        return str.find_first_not_of(" \t\r") == std::string_view::npos;
+    };
+
+    while (true) {
+        const char* begin = m_buffer.data() + m_begin;
+        if (auto found = static_cast<const char*>(std::memchr(begin, '\n', m_end - m_begin))) {
+            line = std::string_view(begin, size_t(found - begin));
+            m_begin += line.size() + 1;
+        } else if (m_eof && m_begin < m_end) {
+            line    = std::string_view(begin, m_end - m_begin);
+            m_begin = m_end;
+        } else if (m_eof) {
+            return false;
+        } else {
+            if (auto ret = fill(); !ret) {
+                return unexpected(ret.error());
+            }
+            continue;
+        }
+
+        ++m_line;
+        if (!isBlank(line)) {
+            return true;
+        }
+    }
+}
+
+Expected<void> BasicLinesReader::fill()
+{
+    if (m_begin > 0) {
+        std::memmove(m_buffer.data(), m_buffer.data() + m_begin, m_end - m_begin);
+        m_end -= m_begin;
+        m_begin = 0;
+    }
+    if (m_end == m_buffer.size()) {
+        m_buffer.resize(m_buffer.size() * 2);
+    }
+
+    if (m_stream) {
+        // Stream which cannot be read from (not opened file, for instance) would never reach eof
+        if (!*m_stream) {
+            return unexpected("Cannot read json lines: stream is in failed state"_s);
+        }
+        m_stream->read(m_buffer.data() + m_end, std::streamsize(m_buffer.size() - m_end));
+        m_end += size_t(m_stream->gcount());
+        m_eof = m_stream->eof();
+        if (m_stream->bad() || (m_stream->fail() && !m_eof)) {
+            return unexpected("Cannot read json lines"_s);
+        }
+        return {};
+    }
+
+    while (true) {
+        auto size = ::read(m_fd, m_buffer.data() + m_end, m_buffer.size() - m_end);
+        if (size < 0 && errno == EINTR) {
+            continue;
+        }
+        if (size < 0) {
+            return unexpected("Cannot read json lines: {}"_s, std::strerror(errno));
+        }
+        m_end += size_t(size);
+        m_eof = size == 0;
+        return {};
+    }
+}
+
+// =========================================================================================================================================
+
+LinesWriter::LinesWriter(std::ostream& stream, Option opt, size_t bufferSize)
+    : m_stream(&stream)
+    , m_opt(opt & ~Option::PrettyPrint)
+    , m_bufferSize(bufferSize)
+{
+    m_buffer.reserve(bufferSize);
+}
+
+LinesWriter::LinesWriter(int fd, Option opt, size_t bufferSize)
+    : m_fd(fd)
+    , m_opt(opt & ~Option::PrettyPrint)
+    , m_bufferSize(bufferSize)
+{
+    m_buffer.reserve(bufferSize);
+}
+
+LinesWriter::~LinesWriter()
+{
+    flush();
+}
+
+Expected<void> LinesWriter::write(const Attribute& record)
+{
+    size_t mark = m_buffer.size();
+    try {
+        JsonWriter writer(m_buffer, false);
+        JsonSerializer::visit(record, writer, m_opt);
+        m_buffer += '\n';
+    } catch (const std::exception& e) {
+        m_buffer.resize(mark);
+        return unexpected(e.what());
+    }
+
+    if (m_buffer.size() >= m_bufferSize) {
+        return flush();
+    }
+    return {};
+}
+
+Expected<void> LinesWriter::flush()
+{
+    if (m_buffer.empty()) {
+        return {};
+    }
+
+    if (m_stream) {
+        m_stream->write(m_buffer.data(), std::streamsize(m_buffer.size()));
+        m_buffer.clear();
+        if (!*m_stream) {
+            return unexpected("Cannot write json lines"_s);
         }
         return {};
-    } else {
-        return unexpected(ret.error());
     }
+
+    size_t written = 0;
+    while (written < m_buffer.size()) {
+        auto size = ::write(m_fd, m_buffer.data() + written, m_buffer.size() - written);
+        if (size < 0 && errno == EINTR) {
+            continue;
+        }
+        if (size < 0) {
+            m_buffer.clear();
+            return unexpected("Cannot write json lines: {}"_s, std::strerror(errno));
+        }
+        written += size_t(size);
+    }
+    m_buffer.clear();
+    return {};
 }
 
+// =========================================================================================================================================
+
 } // namespace pack::json
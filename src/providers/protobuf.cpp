@@ -16,182 +16,613 @@
    You should have received a copy of the GNU Lesser General Public License along with this program; if not, write to the Free Software
    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 ========================================================================================================================================= */
+#include "pack/generated.h"
+#include "pack/protobuf-wire.h"
 #include "pack/visitor.h"
+#include "utils.h"
 #include <google/protobuf/descriptor.h>
 #include <google/protobuf/descriptor.pb.h>
 #include <google/protobuf/descriptor_database.h>
-#include <google/protobuf/dynamic_message.h>
-#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <typeinfo>
+#include <unordered_map>
 
 namespace pack {
 
 namespace pb = google::protobuf;
 
+using protobuf::Encoding;
+using protobuf::WireReader;
+using protobuf::WireType;
+
+// =========================================================================================================================================
+
+/// Checks that the protobuf field keeps values of the given C++ type
+static void expectType(const pb::FieldDescriptor* field, pb::FieldDescriptor::CppType type)
+{
+    if (field->cpp_type() != type) {
+        throw std::runtime_error(fmt::format(
+            "Field {} of type {} cannot keep {}", field->full_name(), field->cpp_type_name(), pb::FieldDescriptor::CppTypeName(type)));
+    }
+}
+
+/// Returns wire type of the single value of the field
+static WireType wireType(const pb::FieldDescriptor* field)
+{
+    switch (field->type()) {
+    case pb::FieldDescriptor::TYPE_FIXED64:
+    case pb::FieldDescriptor::TYPE_SFIXED64:
+    case pb::FieldDescriptor::TYPE_DOUBLE:
+        return WireType::Fixed64;
+    case pb::FieldDescriptor::TYPE_FIXED32:
+    case pb::FieldDescriptor::TYPE_SFIXED32:
+    case pb::FieldDescriptor::TYPE_FLOAT:
+        return WireType::Fixed32;
+    case pb::FieldDescriptor::TYPE_STRING:
+    case pb::FieldDescriptor::TYPE_BYTES:
+    case pb::FieldDescriptor::TYPE_MESSAGE:
+        return WireType::Length;
+    case pb::FieldDescriptor::TYPE_GROUP:
+        return WireType::StartGroup;
+    default:
+        return WireType::Varint;
+    }
+}
+
+/// Calls the function with the encoding of the numeric field as std::integral_constant, so the packed codec of the generated code is
+/// used for the field known at runtime only
+template <typename Func>
+static void withEncoding(const pb::FieldDescriptor* field, Func&& func)
+{
+    switch (field->type()) {
+    case pb::FieldDescriptor::TYPE_BOOL:
+        return func(std::integral_constant<Encoding, Encoding::Bool>());
+    case pb::FieldDescriptor::TYPE_SINT32:
+        return func(std::integral_constant<Encoding, Encoding::ZigZag32>());
+    case pb::FieldDescriptor::TYPE_SINT64:
+        return func(std::integral_constant<Encoding, Encoding::ZigZag64>());
+    case pb::FieldDescriptor::TYPE_FIXED32:
+    case pb::FieldDescriptor::TYPE_SFIXED32:
+        return func(std::integral_constant<Encoding, Encoding::Fixed32>());
+    case pb::FieldDescriptor::TYPE_FIXED64:
+    case pb::FieldDescriptor::TYPE_SFIXED64:
+        return func(std::integral_constant<Encoding, Encoding::Fixed64>());
+    case pb::FieldDescriptor::TYPE_FLOAT:
+        return func(std::integral_constant<Encoding, Encoding::Float>());
+    case pb::FieldDescriptor::TYPE_DOUBLE:
+        return func(std::integral_constant<Encoding, Encoding::Double>());
+    default:
+        return func(std::integral_constant<Encoding, Encoding::Varint>());
+    }
+}
+
+/// Returns true if the value of the field may be encoded with the wire type, repeated numbers are accepted both packed and not
+static bool accepts(const pb::FieldDescriptor* field, WireType type)
+{
+    return type == wireType(field) || (type == WireType::Length && field->is_packable());
+}
+
+// =========================================================================================================================================
+
+/// Protobuf fields of the node fields by slot, nullptr for the fields which are not in the message
+using FieldMap = std::vector<const pb::FieldDescriptor*>;
+
+/// Binding of the node type to the protobuf message, computed once per pair of them. Variant field of the node is bound to the oneof of
+/// the same name, each field of the oneof is then bound to the slot of the variant.
+struct MessageInfo
+{
+    /// Field of the message with its node slot
+    struct Bound
+    {
+        const pb::FieldDescriptor* field = nullptr;
+        int                        slot  = -1;
+    };
+
+    /// Numbers of the fields up to this one are looked up directly, sparse numbers above go through the descriptor
+    static constexpr uint32_t MaxDirect = 1024;
+
+    const pb::Descriptor*                   descriptor;
+    FieldMap                                fields;
+    std::vector<const pb::OneofDescriptor*> oneofs;
+    std::vector<int>                        slots;
+    std::vector<Bound>                      numbers;
+
+    /// Returns the field of the given number with its node slot, slot is -1 if the node has no such field
+    Bound field(uint32_t number) const
+    {
+        if (number < numbers.size()) {
+            return numbers[number];
+        }
+        Bound bound;
+        if (number > MaxDirect && (bound.field = descriptor->FindFieldByNumber(int(number)))) {
+            bound.slot = slots[size_t(bound.field->index())];
+        }
+        return bound;
+    }
+};
+
+/// Resolves protobuf descriptions of the node types: file descriptor is parsed into the pool once and the fields of each pair of node type
+/// and message are bound by their keys, also once. Resolving is done under the lock, lookups go without it into the immutable snapshot of
+/// the table. Each resolved pair publishes a new snapshot, old ones are kept alive as the readers may still look into them, count of the
+/// pairs is small, so are copies.
+class Registry
+{
+public:
+    static Registry& instance()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    /// Returns description of the node type, protoName() and fileDescriptor() of the type should not change from node to node
+    const MessageInfo& message(const INode& node)
+    {
+        return message(node, nullptr);
+    }
+
+    /// Returns binding of the node type to the message, the node of embedded message is bound to the message type of its field
+    const MessageInfo& message(const INode& node, const pb::Descriptor* descriptor)
+    {
+        if (const Table* table = m_table.load(std::memory_order_acquire)) {
+            auto it = table->find(Key{&typeid(node), descriptor});
+            if (it != table->end()) {
+                return *it->second;
+            }
+        }
+        return resolve(node, descriptor);
+    }
+
+private:
+    struct Key
+    {
+        const std::type_info* type;
+        const pb::Descriptor* descriptor;
+
+        bool operator==(const Key& other) const
+        {
+            return *type == *other.type && descriptor == other.descriptor;
+        }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const
+        {
+            return key.type->hash_code() ^ (std::hash<const void*>()(key.descriptor) << 1);
+        }
+    };
+
+    using Table = std::unordered_map<Key, const MessageInfo*, KeyHash>;
+
+    Registry() = default;
+
+    const MessageInfo& resolve(const INode& node, const pb::Descriptor* descriptor)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        const Table* current = m_table.load(std::memory_order_relaxed);
+        if (current) {
+            auto it = current->find(Key{&typeid(node), descriptor});
+            if (it != current->end()) {
+                return *it->second;
+            }
+        }
+
+        const pb::Descriptor* descr = descriptor ? descriptor : find(node);
+
+        auto info        = std::make_unique<MessageInfo>();
+        info->descriptor = descr;
+        info->slots.assign(size_t(descr->field_count()), -1);
+
+        uint32_t direct = 0;
+        auto     bind   = [&](const pb::FieldDescriptor* field, int slot) {
+            info->slots[size_t(field->index())] = slot;
+            if (uint32_t(field->number()) <= MessageInfo::MaxDirect) {
+                direct = std::max(direct, uint32_t(field->number()) + 1);
+            }
+        };
+
+        for (const auto& it : node.fields()) {
+            const std::string          key   = toStdString(it.key());
+            const pb::FieldDescriptor* field = descr->FindFieldByName(key);
+            const pb::OneofDescriptor* oneof = nullptr;
+            if (field) {
+                bind(field, int(info->fields.size()));
+            } else if (it.type() == Attribute::NodeType::Variant && (oneof = descr->FindOneofByName(key))) {
+                for (int i = 0; i < oneof->field_count(); ++i) {
+                    bind(oneof->field(i), int(info->fields.size()));
+                }
+            }
+            info->fields.push_back(field);
+            info->oneofs.push_back(oneof);
+        }
+
+        info->numbers.resize(direct);
+        for (int i = 0; i < descr->field_count(); ++i) {
+            const pb::FieldDescriptor* field = descr->field(i);
+            if (uint32_t(field->number()) < direct) {
+                info->numbers[size_t(field->number())] = {field, info->slots[size_t(i)]};
+            }
+        }
+
+        auto table = current ? std::make_unique<Table>(*current) : std::make_unique<Table>();
+        table->emplace(Key{&typeid(node), descriptor}, info.get());
+        m_table.store(table.get(), std::memory_order_release);
+
+        m_tables.push_back(std::move(table));
+        m_messages.push_back(std::move(info));
+        return *m_messages.back();
+    }
+
+    /// Finds the message by the name the node gives, file descriptor of the node is added to the pool on the first call
+    const pb::Descriptor* find(const INode& node)
+    {
+        const std::string     name  = node.protoName();
+        const pb::Descriptor* descr = m_pool.FindMessageTypeByName(name);
+        if (!descr) {
+            pb::FileDescriptorSet fs;
+            fs.ParseFromString(node.fileDescriptor());
+            for (int i = 0; i < fs.file().size(); ++i) {
+                if (!m_pool.FindFileByName(fs.file(i).name())) {
+                    m_db.Add(fs.file(i));
+                }
+            }
+            descr = m_pool.FindMessageTypeByName(name);
+        }
+        if (!descr) {
+            throw std::runtime_error("Cannot find description for " + name);
+        }
+        return descr;
+    }
+
+private:
+    std::atomic<const Table*>                 m_table = {nullptr};
+    std::mutex                                m_mutex;
+    std::vector<std::unique_ptr<Table>>       m_tables;
+    std::vector<std::unique_ptr<MessageInfo>> m_messages;
+    pb::SimpleDescriptorDatabase              m_db;
+    pb::DescriptorPool                        m_pool = pb::DescriptorPool(&m_db);
+};
+
+// =========================================================================================================================================
+
+/// Context of the serialization: binding of the node which is written and its current field
+template <typename Out>
+struct ProtoWriter : public protobuf::WireWriter<Out>
+{
+    using protobuf::WireWriter<Out>::WireWriter;
+
+    const MessageInfo*         message = nullptr;
+    const pb::FieldDescriptor* field   = nullptr;
+};
+
+/// Field value read from the wire: varint or fixed value in the number, content of length delimited value in the bytes
+struct WireValue
+{
+    const pb::FieldDescriptor* field;
+    const pb::Descriptor*      message;
+    WireType                   type   = WireType::Length;
+    uint64_t                   number = 0;
+    std::string_view           bytes  = {};
+    int                        depth  = 0;
+};
+
+// =========================================================================================================================================
+
 template <Type ValType>
 struct Convert
 {
-    using CppType       = typename ResolveType<ValType>::type;
-    using WalkType      = std::tuple<pb::Message*, const pb::FieldDescriptor*>;
-    using ConstWalkType = std::tuple<const pb::Message*, const pb::FieldDescriptor*>;
+    using CppType = typename ResolveType<ValType>::type;
 
-    static void decode(Value<ValType>& node, const ConstWalkType& proto)
+    static constexpr bool IsNumber = std::is_arithmetic_v<CppType>;
+
+    static constexpr pb::FieldDescriptor::CppType protoType()
     {
-        auto refl = std::get<0>(proto)->GetReflection();
+        switch (ValType) {
+        case Type::Bool:
+            return pb::FieldDescriptor::CPPTYPE_BOOL;
+        case Type::Double:
+            return pb::FieldDescriptor::CPPTYPE_DOUBLE;
+        case Type::Float:
+            return pb::FieldDescriptor::CPPTYPE_FLOAT;
+        case Type::Int32:
+            return pb::FieldDescriptor::CPPTYPE_INT32;
+        case Type::Int64:
+            return pb::FieldDescriptor::CPPTYPE_INT64;
+        case Type::UInt32:
+        case Type::UChar:
+            return pb::FieldDescriptor::CPPTYPE_UINT32;
+        case Type::UInt64:
+            return pb::FieldDescriptor::CPPTYPE_UINT64;
+        default:
+            return pb::FieldDescriptor::CPPTYPE_STRING;
+        }
+    }
 
-        if constexpr (ValType == Type::Bool) {
-            node = refl->GetBool(*std::get<0>(proto), std::get<1>(proto));
-        } else if constexpr (ValType == Type::Double) {
-            node = refl->GetDouble(*std::get<0>(proto), std::get<1>(proto));
-        } else if constexpr (ValType == Type::Float) {
-            node = refl->GetFloat(*std::get<0>(proto), std::get<1>(proto));
-        } else if constexpr (ValType == Type::Int32) {
-            node = refl->GetInt32(*std::get<0>(proto), std::get<1>(proto));
-        } else if constexpr (ValType == Type::Int64) {
-            node = refl->GetInt64(*std::get<0>(proto), std::get<1>(proto));
-        } else if constexpr (ValType == Type::String) {
-            node = fromStdString(refl->GetString(*std::get<0>(proto), std::get<1>(proto)));
-        } else if constexpr (ValType == Type::UInt32) {
-            node = refl->GetUInt32(*std::get<0>(proto), std::get<1>(proto));
-        } else if constexpr (ValType == Type::UInt64) {
-            node = refl->GetUInt64(*std::get<0>(proto), std::get<1>(proto));
-        } else if constexpr (ValType == Type::UChar) {
-            node = static_cast<unsigned char>(refl->GetUInt32(*std::get<0>(proto), std::get<1>(proto)));
-        } else if constexpr (ValType == Type::Binary) {
-            static_cast<Binary&>(node).setString(fromStdString(refl->GetString(*std::get<0>(proto), std::get<1>(proto))));
+    /// Returns the number as it is kept on the wire, by the type of the field
+    static uint64_t toWire(const pb::FieldDescriptor* field, CppType value)
+    {
+        switch (field->type()) {
+        case pb::FieldDescriptor::TYPE_SINT32:
+            return protobuf::zigzag(int32_t(value));
+        case pb::FieldDescriptor::TYPE_SINT64:
+            return protobuf::zigzag(int64_t(value));
+        case pb::FieldDescriptor::TYPE_FLOAT:
+            return protobuf::bitCast<uint32_t>(float(value));
+        case pb::FieldDescriptor::TYPE_DOUBLE:
+            return protobuf::bitCast<uint64_t>(double(value));
+        default:
+            if constexpr (std::is_signed_v<CppType>) {
+                return uint64_t(int64_t(value));
+            } else {
+                return uint64_t(value);
+            }
+        }
+    }
+
+    static CppType fromWire(const pb::FieldDescriptor* field, uint64_t value)
+    {
+        switch (field->type()) {
+        case pb::FieldDescriptor::TYPE_SINT32:
+            return CppType(protobuf::unzigzag(uint32_t(value)));
+        case pb::FieldDescriptor::TYPE_SINT64:
+            return CppType(protobuf::unzigzag(value));
+        case pb::FieldDescriptor::TYPE_FLOAT:
+            return CppType(protobuf::bitCast<float>(uint32_t(value)));
+        case pb::FieldDescriptor::TYPE_DOUBLE:
+            return CppType(protobuf::bitCast<double>(value));
+        case pb::FieldDescriptor::TYPE_BOOL:
+            return CppType(value != 0);
+        default:
+            return CppType(value);
         }
     }
 
-    template<typename ListType>
-    static void decode(List<ListType>& node, const ConstWalkType& proto)
+    template <typename Out>
+    static void write(ProtoWriter<Out>& proto, WireType type, uint64_t value)
     {
-        auto refl = std::get<0>(proto)->GetReflection();
+        switch (type) {
+        case WireType::Fixed32:
+            proto.fixed32(uint32_t(value));
+            break;
+        case WireType::Fixed64:
+            proto.fixed64(value);
+            break;
+        default:
+            proto.varint(value);
+            break;
+        }
+    }
 
-        if constexpr (ValType == Type::UChar) {
-            std::string str = refl->GetString(*std::get<0>(proto), std::get<1>(proto));
-            node.setValue(typename List<Value<ValType>>::ListType(str.begin(), str.end()));
+    static std::string_view bytes(const Value<ValType>& node, std::string& buffer)
+    {
+        if constexpr (ValType == Type::Binary) {
+            const auto& value = node.value();
+            return std::string_view(reinterpret_cast<const char*>(value.data()), value.size());
         } else {
-            for (int i = 0; i < refl->FieldSize(*std::get<0>(proto), std::get<1>(proto)); ++i) {
-                if constexpr (ValType == Type::Bool) {
-                    node.append(refl->GetRepeatedBool(*std::get<0>(proto), std::get<1>(proto), i));
-                } else if constexpr (ValType == Type::Double) {
-                    node.append(refl->GetRepeatedDouble(*std::get<0>(proto), std::get<1>(proto), i));
-                } else if constexpr (ValType == Type::Float) {
-                    node.append(refl->GetRepeatedFloat(*std::get<0>(proto), std::get<1>(proto), i));
-                } else if constexpr (ValType == Type::Int32) {
-                    node.append(refl->GetRepeatedInt32(*std::get<0>(proto), std::get<1>(proto), i));
-                } else if constexpr (ValType == Type::Int64) {
-                    node.append(refl->GetRepeatedInt64(*std::get<0>(proto), std::get<1>(proto), i));
-                } else if constexpr (ValType == Type::String) {
-                    node.append(fromStdString(refl->GetRepeatedString(*std::get<0>(proto), std::get<1>(proto), i)));
-                } else if constexpr (ValType == Type::UInt32) {
-                    node.append(refl->GetRepeatedUInt32(*std::get<0>(proto), std::get<1>(proto), i));
-                } else if constexpr (ValType == Type::UInt64) {
-                    node.append(refl->GetRepeatedUInt64(*std::get<0>(proto), std::get<1>(proto), i));
-                } else if constexpr (ValType == Type::Binary) {
-                    node.append(Binary::fromString(fromStdString(refl->GetRepeatedString(*std::get<0>(proto), std::get<1>(proto), i))));
-                }
+#ifdef WITH_QTSTRING
+            buffer = toStdString(node.value());
+            return buffer;
+#else
+            (void)buffer;
+            return node.value();
+#endif
+        }
+    }
+
+    static void setBytes(Value<ValType>& node, std::string_view bytes)
+    {
+        if constexpr (ValType == Type::Binary) {
+            static_cast<Binary&>(node).setString(bytes.data(), bytes.size());
+        } else {
+            node = fromStdString(std::string(bytes));
+        }
+    }
+
+    /// Writes the key of the map entry, pack keeps the keys as strings while protobuf ones may be numbers
+    template <typename Out>
+    static void encodeKey(const string_t& key, ProtoWriter<Out>& proto)
+    {
+        if constexpr (IsNumber) {
+            encode(Value<ValType>(convert<CppType>(toStdString(key))), proto);
+        } else {
+            encode(Value<ValType>(key), proto);
+        }
+    }
+
+    static string_t decodeKey(const WireValue& wire)
+    {
+        if constexpr (IsNumber) {
+            return fromStdString(convert<std::string>(fromWire(wire.field, wire.number)));
+        } else {
+            return fromStdString(std::string(wire.bytes));
+        }
+    }
+
+    /// Writes the value, zero value is written only if the field tracks presence
+    template <typename Out>
+    static void encode(const Value<ValType>& node, ProtoWriter<Out>& proto)
+    {
+        const pb::FieldDescriptor* field = proto.field;
+        expectType(field, protoType());
+
+        if constexpr (IsNumber) {
+            uint64_t value = toWire(field, node.value());
+            if (value || field->has_presence()) {
+                WireType type = wireType(field);
+                proto.tag(uint32_t(field->number()), type);
+                write(proto, type, value);
+            }
+        } else {
+            std::string      buffer;
+            std::string_view value = bytes(node, buffer);
+            if (!value.empty() || field->has_presence()) {
+                proto.tag(uint32_t(field->number()), WireType::Length);
+                proto.bytes(value.data(), value.size());
             }
         }
     }
 
-    static void decode(Map<Value<ValType>>& /*node*/, const ConstWalkType& /*proto*/)
+    /// Writes the items, numbers are packed if the field is
+    template <typename ListType, typename Out>
+    static void encode(const List<ListType>& node, ProtoWriter<Out>& proto)
     {
+        const pb::FieldDescriptor* field = proto.field;
+        expectType(field, protoType());
+
+        if constexpr (IsNumber) {
+            withEncoding(field, [&](auto enc) {
+                protobuf::writeNumbers<decltype(enc)::value>(proto, uint32_t(field->number()), node, field->is_packed());
+            });
+        } else {
+            std::string buffer;
+            for (const auto& it : node) {
+                std::string_view value = bytes(it, buffer);
+                proto.tag(uint32_t(field->number()), WireType::Length);
+                proto.bytes(value.data(), value.size());
+            }
+        }
+    }
+
+    static void decode(Value<ValType>& node, const WireValue& wire)
+    {
+        expectType(wire.field, protoType());
+
+        if constexpr (IsNumber) {
+            node = fromWire(wire.field, wire.number);
+        } else {
+            setBytes(node, wire.bytes);
+        }
     }
 
-    static void encode(const Value<ValType>& node, WalkType& proto)
+    /// Appends the items, packed numbers are accepted for any repeated numeric field
+    template <typename ListType>
+    static void decode(List<ListType>& node, const WireValue& wire)
     {
-        auto refl = std::get<0>(proto)->GetReflection();
+        expectType(wire.field, protoType());
+
+        if constexpr (IsNumber) {
+            withEncoding(wire.field, [&](auto enc) {
+                if (wire.type == WireType::Length) {
+                    protobuf::appendPacked<decltype(enc)::value>(wire.bytes, node);
+                } else {
+                    node.append(protobuf::fromWire<decltype(enc)::value, CppType>(wire.number));
+                }
+            });
+        } else {
+            setBytes(node.append(), wire.bytes);
+        }
+    }
+
+    /// Sets the value reflection gives for the field which is not in the message
+    static void reset(Value<ValType>& node, const pb::FieldDescriptor* field)
+    {
+        expectType(field, protoType());
 
         if constexpr (ValType == Type::Bool) {
-            refl->SetBool(std::get<0>(proto), std::get<1>(proto), node.value());
+            node = field->default_value_bool();
         } else if constexpr (ValType == Type::Double) {
-            refl->SetDouble(std::get<0>(proto), std::get<1>(proto), node.value());
+            node = field->default_value_double();
         } else if constexpr (ValType == Type::Float) {
-            refl->SetFloat(std::get<0>(proto), std::get<1>(proto), node.value());
+            node = field->default_value_float();
         } else if constexpr (ValType == Type::Int32) {
-            refl->SetInt32(std::get<0>(proto), std::get<1>(proto), node.value());
+            node = field->default_value_int32();
         } else if constexpr (ValType == Type::Int64) {
-            refl->SetInt64(std::get<0>(proto), std::get<1>(proto), node.value());
-        } else if constexpr (ValType == Type::String) {
-            refl->SetString(std::get<0>(proto), std::get<1>(proto), toStdString(node.value()));
+            node = field->default_value_int64();
         } else if constexpr (ValType == Type::UInt32) {
-            refl->SetUInt32(std::get<0>(proto), std::get<1>(proto), node.value());
-        } else if constexpr (ValType == Type::UInt64) {
-            refl->SetUInt64(std::get<0>(proto), std::get<1>(proto), node.value());
+            node = field->default_value_uint32();
         } else if constexpr (ValType == Type::UChar) {
-            refl->SetUInt32(std::get<0>(proto), std::get<1>(proto), node.value());
-        } else if constexpr (ValType == Type::Binary) {
-            refl->SetString(std::get<0>(proto), std::get<1>(proto), toStdString(static_cast<const Binary&>(node).asString()));
+            node = static_cast<unsigned char>(field->default_value_uint32());
+        } else if constexpr (ValType == Type::UInt64) {
+            node = field->default_value_uint64();
+        } else {
+            setBytes(node, field->default_value_string());
         }
     }
+};
 
-    template<typename ListType>
-    static void encode(const List<ListType>& node, WalkType& proto)
-    {
-        auto refl = std::get<0>(proto)->GetReflection();
-
-        if constexpr (ValType == Type::UChar) {
-            std::string str(node.value().begin(), node.value().end());
-            refl->SetString(std::get<0>(proto), std::get<1>(proto), str);
-        } else {
-            auto setFunc = [&](const auto& val) {
-                if constexpr (ValType == Type::Bool) {
-                    refl->AddBool(std::get<0>(proto), std::get<1>(proto), val);
-                } else if constexpr (ValType == Type::Double) {
-                    refl->AddDouble(std::get<0>(proto), std::get<1>(proto), val);
-                } else if constexpr (ValType == Type::Float) {
-                    refl->AddFloat(std::get<0>(proto), std::get<1>(proto), val);
-                } else if constexpr (ValType == Type::Int32) {
-                    refl->AddInt32(std::get<0>(proto), std::get<1>(proto), val);
-                } else if constexpr (ValType == Type::Int64) {
-                    refl->AddInt64(std::get<0>(proto), std::get<1>(proto), val);
-                } else if constexpr (ValType == Type::String) {
-                    refl->AddString(std::get<0>(proto), std::get<1>(proto), toStdString(val));
-                } else if constexpr (ValType == Type::UInt32) {
-                    refl->AddUInt32(std::get<0>(proto), std::get<1>(proto), val);
-                } else if constexpr (ValType == Type::UInt64) {
-                    refl->AddUInt64(std::get<0>(proto), std::get<1>(proto), val);
-                } else if constexpr (ValType == Type::Binary) {
-                    refl->AddString(std::get<0>(proto), std::get<1>(proto), toStdString(static_cast<const Binary&>(val).asString()));
-                }
-            };
+// =========================================================================================================================================
 
-            if constexpr (ValType == Type::Bool) {
-                for (auto it : node) {
-                    setFunc(it);
-                }
-            } else {
-                for (const auto& it : node) {
-                    setFunc(it);
-                }
-            }
-        }
+/// Writes the key of the map entry by the type of the key field
+template <typename Out>
+static void encodeKey(const string_t& key, ProtoWriter<Out>& proto)
+{
+    switch (proto.field->cpp_type()) {
+    case pb::FieldDescriptor::CPPTYPE_BOOL:
+        return Convert<Type::Bool>::encodeKey(key, proto);
+    case pb::FieldDescriptor::CPPTYPE_INT32:
+        return Convert<Type::Int32>::encodeKey(key, proto);
+    case pb::FieldDescriptor::CPPTYPE_INT64:
+        return Convert<Type::Int64>::encodeKey(key, proto);
+    case pb::FieldDescriptor::CPPTYPE_UINT32:
+        return Convert<Type::UInt32>::encodeKey(key, proto);
+    case pb::FieldDescriptor::CPPTYPE_UINT64:
+        return Convert<Type::UInt64>::encodeKey(key, proto);
+    default:
+        return Convert<Type::String>::encodeKey(key, proto);
     }
+}
 
-    static void encode(const Map<Value<ValType>>& /*node*/, WalkType& /*proto*/)
-    {
+/// Returns the key of the map entry as pack keeps it
+static string_t decodeKey(const WireValue& wire)
+{
+    switch (wire.field->cpp_type()) {
+    case pb::FieldDescriptor::CPPTYPE_BOOL:
+        return Convert<Type::Bool>::decodeKey(wire);
+    case pb::FieldDescriptor::CPPTYPE_INT32:
+        return Convert<Type::Int32>::decodeKey(wire);
+    case pb::FieldDescriptor::CPPTYPE_INT64:
+        return Convert<Type::Int64>::decodeKey(wire);
+    case pb::FieldDescriptor::CPPTYPE_UINT32:
+        return Convert<Type::UInt32>::decodeKey(wire);
+    case pb::FieldDescriptor::CPPTYPE_UINT64:
+        return Convert<Type::UInt64>::decodeKey(wire);
+    default:
+        return Convert<Type::String>::decodeKey(wire);
     }
-};
+}
 
+// =========================================================================================================================================
 
 class ProtoSerializer : public Serialize<ProtoSerializer>
 {
 public:
-    using WalkType = std::tuple<pb::Message*, const pb::FieldDescriptor*>;
-
-    template <typename T>
-    static void packValue(const T& val, WalkType& proto, Option opt)
+    template <typename T, typename Out>
+    static void packValue(const T& val, ProtoWriter<Out>& proto, Option opt)
     {
         if (val.hasValue() || isSet(opt, Option::WithDefaults)) {
             Convert<T::ThisType>::encode(val, proto);
         }
     }
 
-    static void packValue(const IMap& /*val*/, WalkType& /*proto*/, Option /*opt*/)
+    /// Writes the entries of the map, each one is an embedded message of the key and the value
+    template <typename Out>
+    static void packValue(const IMap& val, ProtoWriter<Out>& proto, Option opt)
     {
+        const pb::FieldDescriptor* field = proto.field;
+        if (!field->is_map()) {
+            throw std::runtime_error(fmt::format("Field {} is not a map", field->full_name()));
+        }
+
+        const pb::Descriptor* entry = field->message_type();
+        for (int i = 0; i < val.size(); ++i) {
+            proto.tag(uint32_t(field->number()), WireType::Length);
+            size_t start = proto.beginLength();
+            proto.field  = entry->map_key();
+            encodeKey(val.keyByIndex(i), proto);
+            proto.field = entry->map_value();
+            packField(val.valueByIndex(i), proto, opt);
+            proto.field = field;
+            proto.endLength(start);
+        }
     }
 
-    static void packValue(const IList& val, WalkType& proto, Option opt)
+    template <typename Out>
+    static void packValue(const IList& val, ProtoWriter<Out>& proto, Option opt)
     {
         if (val.isValueList()) {
             switch (val.valueType()) {
@@ -227,164 +658,423 @@ public:
                 break;
             }
         } else {
-            auto refl = std::get<0>(proto)->GetReflection();
+            expectType(proto.field, pb::FieldDescriptor::CPPTYPE_MESSAGE);
             for (int i = 0; i < val.size(); ++i) {
-                const Attribute& node       = val.get(i);
-                pb::Message*     child      = refl->AddMessage(std::get<0>(proto), std::get<1>(proto));
-                auto             childProto = std::make_tuple(child, std::get<1>(proto));
-                visit(node, childProto, opt);
+                message(val.get(i), proto, opt);
             }
         }
     }
 
-    static void packValue(const INode& node, WalkType& proto, Option opt)
+    template <typename Out>
+    static void packValue(const INode& node, ProtoWriter<Out>& proto, Option opt)
     {
-        for (auto& it : node.fields()) {
-            if (it.get().hasValue()) {
-                auto fdesc = std::get<0>(proto)->GetDescriptor()->FindFieldByName(toStdString(it.get().key()));
-                if (fdesc && fdesc->cpp_type() == pb::FieldDescriptor::CPPTYPE_MESSAGE && !fdesc->is_repeated()) {
-                    auto refl  = std::get<0>(proto)->GetReflection();
-                    auto child = WalkType(refl->MutableMessage(std::get<0>(proto), fdesc), fdesc);
-                    visit(it.get(), child, opt);
-                } else if (fdesc) {
-                    auto child = WalkType(std::get<0>(proto), fdesc);
-                    visit(it.get(), child, opt);
-                } else {
-                    throw std::runtime_error("Cannot find " + toStdString(it.get().key()));
+        const MessageInfo& info = *proto.message;
+
+        auto fields = node.presentFields();
+        for (auto it = fields.begin(); it != fields.end(); ++it) {
+            const Attribute& attr = *it;
+            if (attr.hasValue()) {
+                size_t slot = size_t(&it.info() - fields.table().begin());
+                if (auto oneof = info.oneofs[slot]) {
+                    packOneof(static_cast<const IVariant&>(attr), oneof, proto, opt);
+                    continue;
+                }
+                auto fdesc = info.fields[slot];
+                if (!fdesc) {
+                    throw std::runtime_error("Cannot find " + toStdString(attr.key()));
                 }
+                proto.field = fdesc;
+                packField(attr, proto, opt);
             }
         }
+        checkRequired(node, info);
+    }
+
+    template <typename Out>
+    static void packValue(const IEnum& en, ProtoWriter<Out>& proto, Option /*opt*/)
+    {
+        expectType(proto.field, pb::FieldDescriptor::CPPTYPE_ENUM);
+        int value = en.asInt();
+        if (value || proto.field->has_presence()) {
+            proto.tag(uint32_t(proto.field->number()), WireType::Varint);
+            proto.varint(uint64_t(int64_t(value)));
+        }
+    }
+
+    template <typename Out>
+    static void packValue(const IVariant& var, ProtoWriter<Out>& /*proto*/, Option /*opt*/)
+    {
+        throw std::runtime_error(fmt::format("Variant {} can be written only as oneof of the message", toStdString(var.key())));
+    }
+
+    /// Writes the held alternative of the variant as the field of the oneof at the same index
+    template <typename Out>
+    static void packOneof(const IVariant& var, const pb::OneofDescriptor* oneof, ProtoWriter<Out>& proto, Option opt)
+    {
+        int              index = var.index();
+        const Attribute* value = var.get();
+        if (!value || index >= oneof->field_count()) {
+            throw std::runtime_error(fmt::format("Variant {} has no field in oneof {}", toStdString(var.key()), oneof->full_name()));
+        }
+        proto.field = oneof->field(index);
+        packField(*value, proto, opt);
     }
 
-    static void packValue(const IEnum& en, WalkType& proto, Option /*opt*/)
+    /// Writes the attribute as the current field, embedded messages are length delimited
+    template <typename Out>
+    static void packField(const Attribute& attr, ProtoWriter<Out>& proto, Option opt)
     {
-        auto refl = std::get<0>(proto)->GetReflection();
-        refl->SetEnumValue(std::get<0>(proto), std::get<1>(proto), en.asInt());
+        if (proto.field->cpp_type() == pb::FieldDescriptor::CPPTYPE_MESSAGE && !proto.field->is_repeated()) {
+            message(attr, proto, opt);
+        } else {
+            visit(attr, proto, opt);
+        }
     }
 
-    static void packValue(const IVariant& /*var*/, WalkType& /*proto*/, Option /*opt*/)
+    /// Proto2 required fields should have a value, as protobuf refuses to serialize the message without them
+    static void checkRequired(const INode& node, const MessageInfo& info)
     {
+        std::string missing;
+        for (int i = 0; i < info.descriptor->field_count(); ++i) {
+            const pb::FieldDescriptor* fdesc = info.descriptor->field(i);
+            if (fdesc->is_required()) {
+                int slot = info.slots[size_t(i)];
+                if (slot < 0 || !node.fields()[size_t(slot)].hasValue()) {
+                    missing += (missing.empty() ? "" : ", ") + fdesc->name();
+                }
+            }
+        }
+        if (!missing.empty()) {
+            throw std::runtime_error(fmt::format("Message {} is missing required fields: {}", info.descriptor->full_name(), missing));
+        }
+    }
+
+    /// Writes the attribute as embedded message of the current field
+    template <typename Out>
+    static void message(const Attribute& attr, ProtoWriter<Out>& proto, Option opt)
+    {
+        const pb::FieldDescriptor* field  = proto.field;
+        const MessageInfo*         parent = proto.message;
+
+        proto.tag(uint32_t(field->number()), WireType::Length);
+        size_t start = proto.beginLength();
+        if (attr.type() == Attribute::NodeType::Node) {
+            proto.message = &Registry::instance().message(static_cast<const INode&>(attr), field->message_type());
+        }
+        visit(attr, proto, opt);
+        proto.message = parent;
+        proto.field   = field;
+        proto.endLength(start);
     }
 };
 
-class ProtoDeserializer : public Deserialize<ProtoDeserializer>
+// =========================================================================================================================================
+
+/// Sets the fields to the values reflection gives for the message without them: the defaults of the protobuf fields
+class ProtoDefaults : public Deserialize<ProtoDefaults>
 {
 public:
-    using WalkType = std::tuple<const pb::Message*, const pb::FieldDescriptor*>;
+    template <typename T>
+    static void unpackValue(T& val, const pb::FieldDescriptor* const& field)
+    {
+        Convert<T::ThisType>::reset(val, field);
+    }
+
+    static void unpackValue(IEnum& en, const pb::FieldDescriptor* const& field)
+    {
+        expectType(field, pb::FieldDescriptor::CPPTYPE_ENUM);
+        en.fromInt(field->default_value_enum()->number());
+    }
+
+    static void unpackValue(IMap& /*map*/, const pb::FieldDescriptor* const& /*field*/)
+    {
+    }
+
+    static void unpackValue(IList& /*list*/, const pb::FieldDescriptor* const& /*field*/)
+    {
+    }
+
+    static void unpackValue(INode& node, const pb::FieldDescriptor* const& field)
+    {
+        expectType(field, pb::FieldDescriptor::CPPTYPE_MESSAGE);
+        reset(node, Registry::instance().message(node, field->message_type()));
+    }
+
+    static void unpackValue(IVariant& /*var*/, const pb::FieldDescriptor* const& /*field*/)
+    {
+    }
+
+    /// Resets the fields of the node bound to the message, variants of the oneofs are cleared
+    static void reset(INode& node, const MessageInfo& info)
+    {
+        auto fields = node.fields();
+        for (size_t i = 0; i < fields.size(); ++i) {
+            auto fdesc = info.fields[i];
+            if (fdesc && !fdesc->is_repeated()) {
+                visit(fields[i], fdesc);
+            } else if (info.oneofs[i]) {
+                fields[i].clear();
+            }
+        }
+    }
+};
 
+// =========================================================================================================================================
+
+class ProtoDeserializer : public Deserialize<ProtoDeserializer>
+{
+public:
     template <typename T>
-    static void unpackValue(T& val, const WalkType& proto)
+    static void unpackValue(T& val, const WireValue& wire)
     {
-        Convert<T::ThisType>::decode(val, proto);
+        Convert<T::ThisType>::decode(val, wire);
     }
 
-    static void unpackValue(IEnum& en, const WalkType& proto)
+    static void unpackValue(IEnum& en, const WireValue& wire)
     {
-        auto refl = std::get<0>(proto)->GetReflection();
-        int  val  = refl->GetEnumValue(*std::get<0>(proto), std::get<1>(proto));
-        en.fromInt(val);
+        expectType(wire.field, pb::FieldDescriptor::CPPTYPE_ENUM);
+        if (wire.type == WireType::Varint) {
+            en.fromInt(int32_t(wire.number));
+        }
     }
 
-    static void unpackValue(IMap& /*list*/, const WalkType& /*proto*/)
+    /// Adds the entry to the map, key or value which is not in the entry gets the default. Entries are added as they come, as for the
+    /// other providers the repeated keys are kept.
+    static void unpackValue(IMap& map, const WireValue& wire)
     {
+        if (!wire.field->is_map()) {
+            throw std::runtime_error(fmt::format("Field {} is not a map", wire.field->full_name()));
+        }
+
+        const pb::FieldDescriptor* keyField = wire.message->map_key();
+        const pb::FieldDescriptor* valField = wire.message->map_value();
+
+        WireValue  key{keyField, nullptr, wireType(keyField)};
+        WireValue  value{valField, valField->message_type(), wireType(valField)};
+        bool       hasValue = false;
+        WireReader reader(wire.bytes, wire.depth);
+        uint32_t   number;
+        WireType   type;
+        while (reader.next(number, type)) {
+            if (number == 1 && type == key.type) {
+                read(reader, number, key);
+            } else if (number == 2 && accepts(valField, type)) {
+                value.type = type;
+                hasValue   = read(reader, number, value);
+            } else {
+                reader.skip(number, type);
+            }
+        }
+
+        auto& obj = map.create(decodeKey(key));
+        ProtoDefaults::visit(obj, valField);
+        if (hasValue) {
+            visit(obj, value);
+        }
     }
 
-    static void unpackValue(IList& list, const WalkType& proto)
+    static void unpackValue(IList& list, const WireValue& wire)
     {
         if (list.isValueList()) {
             switch (list.valueType()) {
             case Type::Bool:
-                Convert<Type::Bool>::decode(static_cast<BoolList&>(list), proto);
+                Convert<Type::Bool>::decode(static_cast<BoolList&>(list), wire);
                 break;
             case Type::Double:
-                Convert<Type::Double>::decode(static_cast<DoubleList&>(list), proto);
+                Convert<Type::Double>::decode(static_cast<DoubleList&>(list), wire);
                 break;
             case Type::Float:
-                Convert<Type::Float>::decode(static_cast<FloatList&>(list), proto);
+                Convert<Type::Float>::decode(static_cast<FloatList&>(list), wire);
                 break;
             case Type::Int32:
-                Convert<Type::Int32>::decode(static_cast<Int32List&>(list), proto);
+                Convert<Type::Int32>::decode(static_cast<Int32List&>(list), wire);
                 break;
             case Type::Int64:
-                Convert<Type::Int64>::decode(static_cast<Int64List&>(list), proto);
+                Convert<Type::Int64>::decode(static_cast<Int64List&>(list), wire);
                 break;
             case Type::UInt32:
-                Convert<Type::UInt32>::decode(static_cast<UInt32List&>(list), proto);
+                Convert<Type::UInt32>::decode(static_cast<UInt32List&>(list), wire);
                 break;
             case Type::UInt64:
-                Convert<Type::UInt64>::decode(static_cast<UInt64List&>(list), proto);
+                Convert<Type::UInt64>::decode(static_cast<UInt64List&>(list), wire);
                 break;
             case Type::String:
-                Convert<Type::String>::decode(static_cast<StringList&>(list), proto);
+                Convert<Type::String>::decode(static_cast<StringList&>(list), wire);
                 break;
             case Type::Binary:
-                Convert<Type::Binary>::decode(static_cast<BinaryList&>(list), proto);
+                Convert<Type::Binary>::decode(static_cast<BinaryList&>(list), wire);
                 break;
             case Type::UChar:
             case Type::Unknown:
                 break;
             }
         } else {
-            auto refl = std::get<0>(proto)->GetReflection();
-            for (int i = 0; i < refl->FieldSize(*std::get<0>(proto), std::get<1>(proto)); ++i) {
-                const pb::Message& msg   = refl->GetRepeatedMessage(*std::get<0>(proto), std::get<1>(proto), i);
-                auto&              obj   = list.create();
-                auto               child = WalkType(&msg, nullptr);
-                visit(obj, child);
+            expectType(wire.field, pb::FieldDescriptor::CPPTYPE_MESSAGE);
+            auto& obj = list.create();
+            if (obj.type() == Attribute::NodeType::Node) {
+                auto& item = static_cast<INode&>(obj);
+                ProtoDefaults::reset(item, Registry::instance().message(item, wire.message));
             }
+            visit(obj, wire);
         }
     }
 
-    static void unpackValue(INode& node, const WalkType& proto)
+    /// Reads the fields of the message, unknown fields are skipped. Values of the repeated embedded messages are merged as protobuf does.
+    static void unpackValue(INode& node, const WireValue& wire)
     {
-        for (auto& it : node.fields()) {
-            auto fdesc = std::get<0>(proto)->GetDescriptor()->FindFieldByName(toStdString(it.get().key()));
-            if (fdesc && fdesc->cpp_type() == pb::FieldDescriptor::CPPTYPE_MESSAGE && !fdesc->is_repeated()) {
-                auto refl  = std::get<0>(proto)->GetReflection();
-                auto child = WalkType(&refl->GetMessage(*std::get<0>(proto), fdesc), fdesc);
-                visit(it.get(), child);
-            } else if (fdesc) {
-                auto child = WalkType(std::get<0>(proto), fdesc);
-                visit(it.get(), child);
+        if (wire.field) {
+            expectType(wire.field, pb::FieldDescriptor::CPPTYPE_MESSAGE);
+        }
+
+        const MessageInfo& info = Registry::instance().message(node, wire.message);
+
+        auto       fields = node.fields();
+        WireReader reader(wire.bytes, wire.depth);
+        uint32_t   number;
+        WireType   type;
+        while (reader.next(number, type)) {
+            auto bound = info.field(number);
+            if (bound.slot < 0 || !accepts(bound.field, type)) {
+                reader.skip(number, type);
+                continue;
+            }
+
+            WireValue value{bound.field, bound.field->message_type(), type};
+            if (!read(reader, number, value)) {
+                continue;
             }
+            visit(fields[size_t(bound.slot)], value);
+
+            // Fields of the oneof which are not bound to a variant are plain fields of the node, only the last one read is kept
+            auto oneof = bound.field->real_containing_oneof();
+            if (oneof && !info.oneofs[size_t(bound.slot)]) {
+                for (int i = 0; i < oneof->field_count(); ++i) {
+                    int slot = info.slots[size_t(oneof->field(i)->index())];
+                    if (slot >= 0 && slot != bound.slot) {
+                        fields[size_t(slot)].clear();
+                    }
+                }
+            }
+        }
+    }
+
+    /// Holds the alternative at the index of the field in the oneof, message of the same alternative is merged as protobuf does
+    static void unpackValue(IVariant& var, const WireValue& wire)
+    {
+        if (!wire.field->real_containing_oneof()) {
+            throw std::runtime_error(
+                fmt::format("Field {} is not a oneof for variant {}", wire.field->full_name(), toStdString(var.key())));
+        }
+
+        int        index = wire.field->index_in_oneof();
+        Attribute* value = var.index() == index ? var.get() : nullptr;
+        if (!value) {
+            if (!(value = var.emplace(index))) {
+                throw std::runtime_error(
+                    fmt::format("Variant {} has no alternative for {}", toStdString(var.key()), wire.field->full_name()));
+            }
+            ProtoDefaults::visit(*value, wire.field);
         }
+        visit(*value, wire);
     }
 
-    static void unpackValue(IVariant& /*var*/, const WalkType& /*proto*/)
+    /// Reads the value of the wire type from the reader, groups are skipped
+    static bool read(WireReader& reader, uint32_t number, WireValue& value)
     {
+        switch (value.type) {
+        case WireType::Varint:
+            value.number = reader.varint();
+            return true;
+        case WireType::Fixed32:
+            value.number = reader.fixed32();
+            return true;
+        case WireType::Fixed64:
+            value.number = reader.fixed64();
+            return true;
+        case WireType::Length:
+            value.bytes = reader.bytes();
+            value.depth = reader.nestedDepth();
+            return true;
+        default:
+            reader.skip(number, value.type);
+            return false;
+        }
     }
 };
 
+// =========================================================================================================================================
 
 namespace protobuf {
 
-    static pb::Message* getMessage(const Attribute& attr)
+    /// Returns protobuf description of the node type
+    static const MessageInfo& messageInfo(const Attribute& attr)
     {
-        if (const INode* node = dynamic_cast<const INode*>(&attr)) {
-            static pb::SimpleDescriptorDatabase db;
-            static pb::DescriptorPool           pool(&db);
+        if (attr.type() != Attribute::NodeType::Node) {
+            throw std::runtime_error("Only nodes can be protobuf messages");
+        }
+        return Registry::instance().message(static_cast<const INode&>(attr));
+    }
 
-            auto descr = pool.FindMessageTypeByName(node->protoName());
-            if (!descr) {
-                pb::FileDescriptorSet fs;
-                fs.ParseFromString(node->fileDescriptor());
-                for (int i = 0; i < fs.file().size(); ++i) {
-                    if (!pool.FindFileByName(fs.file(i).name())) {
-                        db.Add(fs.file(i));
-                    }
-                }
-                descr = pool.FindMessageTypeByName(node->protoName());
+    /// Writes the node with the code protoc-gen-pack generated for it, returns false if there is no one. Incremental serialization keeps
+    /// the visitor as only it caches the nodes.
+    template <typename Out>
+    static bool encodeGenerated(const Attribute& node, Out& out, Option opt)
+    {
+        if (node.type() != Attribute::NodeType::Node || isSet(opt, Option::Incremental)) {
+            return false;
+        }
+        const auto& obj = static_cast<const INode&>(node);
+        if constexpr (std::is_same_v<Out, std::string>) {
+            return obj.encodeProto(out);
+        } else {
+            std::string buffer;
+            if (!obj.encodeProto(buffer)) {
+                return false;
             }
+            out.insert(out.end(), buffer.begin(), buffer.end());
+            return true;
+        }
+    }
 
-            if (!descr) {
-                throw std::runtime_error("Cannot find description for " + node->protoName());
+    template <typename Out>
+    static Expected<void> serializeTo(const Attribute& node, Out& out, Option opt)
+    {
+        size_t mark = out.size();
+        try {
+            if (encodeGenerated(node, out, opt)) {
+                return {};
             }
+            const MessageInfo& info = messageInfo(node);
 
-            static pb::DynamicMessageFactory dmf(&pool);
-            const pb::Message*               protoMsg = dmf.GetPrototype(descr);
-            return protoMsg->New();
+            ProtoWriter<Out> proto(out);
+            proto.message = &info;
+            ProtoSerializer::visit(node, proto, opt);
+            return {};
+        } catch (std::exception& ex) {
+            out.resize(mark);
+            return unexpected(ex.what());
         }
-        return nullptr;
+    }
+
+    Expected<void> serialize(const Attribute& node, std::string& out, Option opt)
+    {
+        return serializeTo(node, out, opt);
+    }
+
+    Expected<void> serialize(const Attribute& node, std::vector<char>& out, Option opt)
+    {
+        return serializeTo(node, out, opt);
+    }
+
+    Expected<void> serialize(const Attribute& node, Sink& sink, Option opt)
+    {
+        return staged(
+            [&](std::string& buffer) {
+                return serializeTo(node, buffer, opt);
+            },
+            [&](std::string_view buffer) {
+                return sink.write(buffer.data(), buffer.size());
+            });
     }
 
 #ifdef WITH_QTSTRING
@@ -393,39 +1083,51 @@ namespace protobuf {
     Expected<std::string> serialize(const Attribute& node, Option opt)
 #endif
     {
-        try {
-            std::unique_ptr<pb::Message> msg(getMessage(node));
-
-            auto proto = ProtoSerializer::WalkType(msg.get(), nullptr);
-            ProtoSerializer::visit(node, proto, opt);
+        std::string out;
+        if (auto ret = serializeTo(node, out, opt); !ret) {
+            return unexpected(ret.error());
+        }
 #ifdef WITH_QTSTRING
-            std::string cn = msg->SerializeAsString();
-            return QByteArray(cn.data(), int(cn.size()));
+        return QByteArray(out.data(), int(out.size()));
 #else
-            return msg->SerializeAsString();
+        return out;
 #endif
-        } catch (google::protobuf::FatalException& ex) {
-            return unexpected(fromStdString(ex.message()));
-        } catch (std::exception& ex) {
-            return unexpected(ex.what());
-        }
     }
+
 #ifdef WITH_QTSTRING
     Expected<void> deserialize(const QByteArray& content, Attribute& node)
 #else
     Expected<void> deserialize(const std::string& content, Attribute& node)
 #endif
     {
+        return deserialize(std::string_view(content.data(), size_t(content.size())), node);
+    }
+
+    Expected<void> deserialize(const std::byte* data, size_t size, Attribute& node)
+    {
+        return deserialize(std::string_view(reinterpret_cast<const char*>(data), size), node);
+    }
+
+    Expected<void> deserialize(const char* content, Attribute& node)
+    {
+        return deserialize(std::string_view(content), node);
+    }
+
+    Expected<void> deserialize(std::string_view content, Attribute& node)
+    {
+        if (content.size() > size_t(std::numeric_limits<int>::max())) {
+            return unexpected("Message is too large"_s);
+        }
+
         try {
-            std::unique_ptr<pb::Message> msg(getMessage(node));
-            try {
-                msg->ParseFromString(toStdString(content));
-            } catch (google::protobuf::FatalException& ex) {
-                return unexpected(fromStdString(ex.message()));
+            if (node.type() == Attribute::NodeType::Node && static_cast<INode&>(node).decodeProto(content)) {
+                return {};
             }
 
-            auto proto = ProtoDeserializer::WalkType(msg.get(), nullptr);
-            ProtoDeserializer::visit(node, proto);
+            const MessageInfo& info = messageInfo(node);
+
+            ProtoDefaults::reset(static_cast<INode&>(node), info);
+            ProtoDeserializer::visit(node, WireValue{nullptr, info.descriptor, WireType::Length, 0, content});
             return {};
         } catch (const std::exception& e) {
             return unexpected(e.what());
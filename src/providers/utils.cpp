@@ -42,6 +42,32 @@ Expected<string_t> read(const string_t& filename)
     return unexpected("Cannot read file {}"_s, filename);
 }
 
+Expected<void> read(const string_t& filename, std::string& content)
+{
+#ifdef WITH_QTSTRING
+    std::ifstream st(filename.toStdString(), std::ios::binary);
+#else
+    std::ifstream st(filename, std::ios::binary);
+#endif
+    if (!st.is_open()) {
+        return unexpected("Cannot read file {}"_s, filename);
+    }
+    st.seekg(0, std::ios::end);
+    auto size = st.tellg();
+    if (size < 0) {
+        // Not seekable, like pipes
+        st.clear();
+        content.assign(std::istreambuf_iterator<char>(st), std::istreambuf_iterator<char>());
+        return {};
+    }
+    content.resize(size_t(size));
+    st.seekg(0, std::ios::beg);
+    if (!st.read(content.data(), std::streamsize(content.size()))) {
+        return unexpected("Cannot read file {}"_s, filename);
+    }
+    return {};
+}
+
 Expected<void> write(const string_t& filename, const string_t& content)
 {
 #ifdef WITH_QTSTRING
@@ -57,4 +83,19 @@ Expected<void> write(const string_t& filename, const string_t& content)
     return unexpected("Cannot read file {}"_s, filename);
 }
 
+Expected<void> write(const string_t& filename, std::string_view content)
+{
+#ifdef WITH_QTSTRING
+    std::ofstream st(filename.toStdString(), std::ios::binary);
+#else
+    std::ofstream st(filename, std::ios::binary);
+#endif
+    if (st.is_open()) {
+        st.write(content.data(), std::streamsize(content.size()));
+        st.close();
+        return {};
+    }
+    return unexpected("Cannot write file {}"_s, filename);
+}
+
 } // namespace pack
@@ -19,10 +19,38 @@
 #pragma once
 #include "pack/expected.h"
 #include "pack/types.h"
+#include <string>
+#include <string_view>
 
 namespace pack {
 
 Expected<string_t> read(const string_t& filename);
+Expected<void>     read(const string_t& filename, std::string& content);
 Expected<void>     write(const string_t& filename, const string_t& content);
+Expected<void>     write(const string_t& filename, std::string_view content);
+
+/// Serializes into the thread local buffer and hands it to the writer, the buffer keeps its capacity between the calls
+template <typename SerializeFunc, typename WriteFunc>
+Expected<void> staged(SerializeFunc&& serialize, WriteFunc&& write)
+{
+    static thread_local std::string staging;
+
+    // Buffer is taken out, so nested call gets its own
+    std::string buffer = std::move(staging);
+    buffer.clear();
+
+    auto done = [&](const Expected<void>& ret) -> Expected<void> {
+        staging = std::move(buffer);
+        if (!ret) {
+            return unexpected(ret.error());
+        }
+        return {};
+    };
+
+    if (auto ret = serialize(buffer); !ret) {
+        return done(ret);
+    }
+    return done(write(std::string_view(buffer)));
+}
 
 } // namespace pack
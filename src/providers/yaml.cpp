@@ -19,6 +19,14 @@
 #include "pack/serialization.h"
 #include "pack/visitor.h"
 #include "utils.h"
+#include <charconv>
+#include <cmath>
+#include <istream>
+#include <limits>
+#include <map>
+#include <ostream>
+#include <streambuf>
+#include <yaml-cpp/eventhandler.h>
 #include <yaml-cpp/yaml.h>
 
 #ifdef WITH_QTSTRING
@@ -93,9 +101,10 @@ struct Convert
 //        }
 //    }
 
-    static void encode(const Value<ValType>& node, YAML::Node& yaml, Option /*opt*/)
+    template <typename Writer>
+    static void encode(const Value<ValType>& node, Writer& writer, Option /*opt*/)
     {
-        yaml = YAML::convert<CppType>::encode(node.value());
+        writer.scalar(text(node.value()));
     }
 
 //    static void encode(const List<Value<ValType>>& node, YAML::Node& yaml, Option opt)
@@ -125,174 +134,1006 @@ struct Convert
 //            yaml = YAML::Node(YAML::NodeType::Map);
 //        }
 //    }
+
+private:
+    /// Scalar text of the value, the same as YAML::convert gives
+    static std::string text(const CppType& value)
+    {
+        if constexpr (std::is_same_v<CppType, bool>) {
+            return value ? "true" : "false";
+        } else if constexpr (std::is_same_v<CppType, std::string>) {
+            return value;
+#ifdef WITH_QTSTRING
+        } else if constexpr (std::is_same_v<CppType, QString>) {
+            return value.toStdString();
+#endif
+        } else if constexpr (std::is_same_v<CppType, std::vector<std::byte>>) {
+            return YAML::EncodeBase64(reinterpret_cast<const unsigned char*>(value.data()), value.size());
+        } else if constexpr (std::is_same_v<CppType, unsigned char>) {
+            // Streamed as a character by yaml-cpp
+            return std::string(1, char(value));
+        } else {
+            char buffer[64];
+            if constexpr (std::is_floating_point_v<CppType>) {
+                if (std::isnan(value)) {
+                    return ".nan";
+                } else if (std::isinf(value)) {
+                    return std::signbit(value) ? "-.inf" : ".inf";
+                }
+                // Same as the stream with max_digits10 precision
+                auto res = std::to_chars(
+                    buffer, buffer + sizeof(buffer), value, std::chars_format::general, std::numeric_limits<CppType>::max_digits10);
+                return std::string(buffer, res.ptr);
+            } else {
+                auto res = std::to_chars(buffer, buffer + sizeof(buffer), value);
+                return std::string(buffer, res.ptr);
+            }
+        }
+    }
+};
+
+// =========================================================================================================================================
+
+/// Event of the parser, kept to replay anchored and variant subtrees
+struct YamlEvent
+{
+    enum Kind
+    {
+        Null,
+        Alias,
+        Scalar,
+        SeqStart,
+        SeqEnd,
+        MapStart,
+        MapEnd
+    } kind;
+    YAML::Mark     mark;
+    YAML::anchor_t anchor = YAML::NullAnchor;
+    std::string    value;
+
+    int depth() const
+    {
+        return kind == SeqStart || kind == MapStart ? 1 : kind == SeqEnd || kind == MapEnd ? -1 : 0;
+    }
 };
 
+using YamlEvents = std::vector<YamlEvent>;
+using YamlAnchors = std::map<YAML::anchor_t, YamlEvents>;
+
 // =========================================================================================================================================
 
-class YamlDeserializer : public Deserialize<YamlDeserializer>
+/// Sets scalar events of the parser into the attributes, the values are converted the same way YAML::Node::as does
+class YamlScalar : public Deserialize<YamlScalar>
 {
 public:
+    struct Scalar
+    {
+        const YamlEvent& event;
+        YAML::Node&      scratch;
+    };
+
     template <typename T>
-    static void unpackValue(T& val, const YAML::Node& yaml)
+    static void unpackValue(T& val, const Scalar& scalar)
+    {
+        Convert<T::ThisType>::decode(val, node(scalar));
+    }
+
+    static void unpackValue(IEnum& en, const Scalar& scalar)
+    {
+        en.fromString(node(scalar).as<string_t>());
+    }
+
+    static void unpackValue(INode& node, const Scalar& scalar)
     {
-        Convert<T::ThisType>::decode(val, yaml);
+        if (scalar.event.kind == YamlEvent::Scalar && !node.fields().empty()) {
+            throw YAML::BadSubscript(scalar.event.mark, toStdString(node.fields()[0].key()));
+        }
     }
 
-    static void unpackValue(IEnum& en, const YAML::Node& yaml)
+    static void unpackValue(IMap& /*map*/, const Scalar& /*scalar*/)
     {
-        en.fromString(yaml.as<string_t>());
     }
 
-    static void unpackValue(IMap& map, const YAML::Node& yaml)
+    static void unpackValue(IList& /*list*/, const Scalar& /*scalar*/)
     {
-        for (const auto& child : yaml) {
-            string_t key = child.first.as<string_t>();
-            auto&    obj = map.create(key);
-            visit(obj, child.second);
+    }
+
+    static void unpackValue(IVariant& var, const Scalar& scalar)
+    {
+        if (var.findBetter({})) {
+            if (auto ptr = var.get()) {
+                unpackValue(static_cast<INode&>(*ptr), scalar);
+            }
         }
     }
 
-    static void unpackValue(IList& list, const YAML::Node& yaml)
+    /// Node of the scalar, scratch node is reused for all the scalars
+    static const YAML::Node& node(const Scalar& scalar)
     {
-        for (const auto& child : yaml) {
-            auto& obj = list.create();
-            visit(obj, child);
+        static const YAML::Node null(YAML::NodeType::Null);
+        if (scalar.event.kind == YamlEvent::Null) {
+            return null;
         }
+        scalar.scratch = scalar.event.value;
+        return scalar.scratch;
+    }
+};
+
+// =========================================================================================================================================
+
+/// Event handler which fills the attribute while yaml is parsed, without building of the document. Values are routed to the
+/// attributes they belong to: node members are looked up in the field index by the key, unknown members are skipped. Anchored
+/// subtrees are recorded to be replayed for the aliases. Variants need all the member keys to choose the alternative, so their events
+/// are recorded and replayed into the chosen one.
+class YamlReader : public YAML::EventHandler
+{
+public:
+    explicit YamlReader(Attribute& root)
+        : m_root(&root)
+        , m_anchors(&m_ownAnchors)
+    {
+    }
+
+    YamlReader(Attribute& root, YamlAnchors& anchors)
+        : m_root(&root)
+        , m_anchors(&anchors)
+    {
+    }
+
+    void OnDocumentStart(const YAML::Mark& /*mark*/) override
+    {
+    }
+
+    void OnDocumentEnd() override
+    {
+    }
+
+    void OnNull(const YAML::Mark& mark, YAML::anchor_t anchor) override
+    {
+        handle({YamlEvent::Null, mark, anchor, {}});
+    }
+
+    void OnAlias(const YAML::Mark& mark, YAML::anchor_t anchor) override
+    {
+        handle({YamlEvent::Alias, mark, anchor, {}});
+    }
+
+    void OnScalar(const YAML::Mark& mark, const std::string& /*tag*/, YAML::anchor_t anchor, const std::string& value) override
+    {
+        handle({YamlEvent::Scalar, mark, anchor, value});
+    }
+
+    void OnSequenceStart(const YAML::Mark& mark, const std::string& /*tag*/, YAML::anchor_t anchor, YAML::EmitterStyle::value) override
+    {
+        handle({YamlEvent::SeqStart, mark, anchor, {}});
     }
 
-    static void unpackValue(INode& node, const YAML::Node& yaml)
+    void OnSequenceEnd() override
     {
-        for (auto& it : node.fields()) {
-            auto found = yaml[it.get().key()];
-            if (found.IsDefined()) {
-                visit(it, found);
+        handle({YamlEvent::SeqEnd, {}, YAML::NullAnchor, {}});
+    }
+
+    void OnMapStart(const YAML::Mark& mark, const std::string& /*tag*/, YAML::anchor_t anchor, YAML::EmitterStyle::value) override
+    {
+        handle({YamlEvent::MapStart, mark, anchor, {}});
+    }
+
+    void OnMapEnd() override
+    {
+        handle({YamlEvent::MapEnd, {}, YAML::NullAnchor, {}});
+    }
+
+    /// Prepares the reader for the next document into the root, anchors are scoped to the document
+    void reset(Attribute& root)
+    {
+        m_root    = &root;
+        m_pending = nullptr;
+        m_variant = nullptr;
+        m_stack.clear();
+        m_captures.clear();
+        m_anchors->clear();
+    }
+
+    void handle(const YamlEvent& event)
+    {
+        if (event.kind == YamlEvent::Alias) {
+            auto found = m_anchors->find(event.anchor);
+            if (found == m_anchors->end()) {
+                throw YAML::ParserException(event.mark, YAML::ErrorMsg::UNKNOWN_ANCHOR);
+            }
+            YamlEvents events = found->second;
+            for (const auto& it : events) {
+                handle(it);
+            }
+            return;
+        }
+
+        record(event);
+
+        if (m_variant) {
+            m_variantEvents.push_back(event);
+            m_variantDepth += event.depth();
+            if (m_variantDepth == 0) {
+                endVariant();
             }
+            return;
         }
+
+        process(event);
     }
 
-    static void unpackValue(IVariant& var, const YAML::Node& yaml)
+private:
+    enum class Kind
+    {
+        Node,
+        Map,
+        List,
+        Skip,
+        Invalid
+    };
+
+    struct Frame
     {
+        Kind              kind;
+        Attribute*        attr;
+        bool              expectKey = true;
+        std::vector<bool> seen      = {};
+    };
+
+    struct Capture
+    {
+        YAML::anchor_t anchor;
+        int            depth;
+        YamlEvents     events;
+    };
+
+private:
+    void process(const YamlEvent& event)
+    {
+        if (event.kind == YamlEvent::SeqEnd || event.kind == YamlEvent::MapEnd) {
+            m_stack.pop_back();
+            completed();
+            return;
+        }
+
+        if (!m_stack.empty() && m_stack.back().kind == Kind::Invalid) {
+            // Mapping read as a list or sequence read as a map
+            throw YAML::InvalidNode(std::string());
+        }
+
+        if (!m_stack.empty() && m_stack.back().expectKey && (m_stack.back().kind == Kind::Node || m_stack.back().kind == Kind::Map)) {
+            key(m_stack.back(), event);
+            return;
+        }
+
+        Attribute* target = next();
+        switch (event.kind) {
+        case YamlEvent::Null:
+        case YamlEvent::Scalar:
+            if (target) {
+                scalar(*target, event);
+            }
+            completed();
+            break;
+        case YamlEvent::MapStart:
+            startMap(target, event);
+            break;
+        case YamlEvent::SeqStart:
+            startSeq(target, event);
+            break;
+        default:
+            break;
+        }
+    }
+
+    /// Conversions run on the scratch node which has no position, so their errors get the position of the event
+    void scalar(Attribute& target, const YamlEvent& event)
+    {
+        try {
+            YamlScalar::visit(target, YamlScalar::Scalar{event, m_scratch});
+        } catch (const YAML::Exception& e) {
+            if (!e.mark.is_null()) {
+                throw;
+            }
+            throw YAML::Exception(event.mark, e.msg);
+        }
+    }
+
+    void key(Frame& top, const YamlEvent& event)
+    {
+        m_pending = nullptr;
+        if (event.kind == YamlEvent::MapStart || event.kind == YamlEvent::SeqStart) {
+            if (top.kind == Kind::Map) {
+                throw YAML::BadConversion(event.mark);
+            }
+            // Complex key of the node, it and its value are skipped
+            m_stack.push_back({Kind::Skip, nullptr});
+            return;
+        }
+
+        top.expectKey = false;
+        if (top.kind == Kind::Node) {
+            if (event.kind == YamlEvent::Scalar) {
+                auto& node  = static_cast<INode&>(*top.attr);
+                int   index = node.metaFields().indexOfKey(event.value, node);
+                // The first of the duplicated keys wins
+                if (index >= 0 && !top.seen[size_t(index)]) {
+                    top.seen[size_t(index)] = true;
+                    m_pending               = &node.fields()[size_t(index)];
+                }
+            }
+        } else {
+            m_pending = &static_cast<IMap&>(*top.attr).create(YamlScalar::node({event, m_scratch}).as<string_t>());
+        }
+    }
+
+    /// Returns the attribute for the next value, nullptr if the value should be skipped
+    Attribute* next()
+    {
+        if (m_stack.empty()) {
+            return std::exchange(m_root, nullptr);
+        }
+
+        Frame& top = m_stack.back();
+        switch (top.kind) {
+        case Kind::Node:
+        case Kind::Map:
+            return std::exchange(m_pending, nullptr);
+        case Kind::List:
+            return &static_cast<IList&>(*top.attr).create();
+        case Kind::Skip:
+        case Kind::Invalid:
+            break;
+        }
+        return nullptr;
+    }
+
+    /// Key or value of the node or map is read
+    void completed()
+    {
+        if (!m_stack.empty()) {
+            m_stack.back().expectKey = !m_stack.back().expectKey;
+        }
+    }
+
+    void startMap(Attribute* target, const YamlEvent& event)
+    {
+        if (!target) {
+            m_stack.push_back({Kind::Skip, nullptr});
+            return;
+        }
+
+        switch (target->type()) {
+        case Attribute::NodeType::Node:
+            m_stack.push_back({Kind::Node, target, true, std::vector<bool>(static_cast<INode*>(target)->fields().size())});
+            break;
+        case Attribute::NodeType::Map:
+            m_stack.push_back({Kind::Map, target});
+            break;
+        case Attribute::NodeType::Variant:
+            startVariant(static_cast<IVariant*>(target), event);
+            break;
+        case Attribute::NodeType::List:
+            m_stack.push_back({Kind::Invalid, nullptr});
+            break;
+        default:
+            throw YAML::BadConversion(event.mark);
+        }
+    }
+
+    void startSeq(Attribute* target, const YamlEvent& event)
+    {
+        if (!target) {
+            m_stack.push_back({Kind::Skip, nullptr});
+            return;
+        }
+
+        switch (target->type()) {
+        case Attribute::NodeType::List:
+            m_stack.push_back({Kind::List, target});
+            break;
+        case Attribute::NodeType::Node:
+            m_stack.push_back({Kind::Skip, nullptr});
+            break;
+        case Attribute::NodeType::Map:
+            m_stack.push_back({Kind::Invalid, nullptr});
+            break;
+        case Attribute::NodeType::Variant:
+            startVariant(static_cast<IVariant*>(target), event);
+            break;
+        default:
+            throw YAML::BadConversion(event.mark);
+        }
+    }
+
+    void startVariant(IVariant* var, const YamlEvent& event)
+    {
+        m_variant      = var;
+        m_variantDepth = 1;
+        m_variantEvents.clear();
+        m_variantEvents.push_back(event);
+    }
+
+    void endVariant()
+    {
+        IVariant*  var    = std::exchange(m_variant, nullptr);
+        YamlEvents events = std::move(m_variantEvents);
+
+        if (events.front().kind == YamlEvent::SeqStart && events.size() > 2) {
+            throw YAML::InvalidNode(std::string());
+        }
+
+        // Keys of the top level mapping
         std::vector<string_t> keys;
-        for (const auto& it : yaml) {
-            keys.push_back(it.first.as<string_t>());
+        int                   depth = 0;
+        bool                  isKey = true;
+        for (const auto& event : events) {
+            if (depth == 1 && event.kind != YamlEvent::SeqEnd && event.kind != YamlEvent::MapEnd) {
+                if (isKey && event.depth() > 0) {
+                    throw YAML::BadConversion(event.mark);
+                }
+                if (isKey) {
+                    keys.push_back(YamlScalar::node({event, m_scratch}).as<string_t>());
+                }
+                if (event.depth() == 0) {
+                    isKey = !isKey;
+                }
+            } else if (depth == 2 && event.depth() < 0) {
+                isKey = !isKey;
+            }
+            depth += event.depth();
         }
-        if (var.findBetter(keys)) {
-            if (auto ptr = var.get()) {
-                unpackValue(static_cast<INode&>(*ptr), yaml);
+
+        if (var->findBetter(keys)) {
+            if (auto ptr = var->get()) {
+                YamlReader reader(*ptr, *m_anchors);
+                for (const auto& event : events) {
+                    reader.handle(event);
+                }
+            }
+        }
+        completed();
+    }
+
+    /// Keeps the events of the anchored subtrees
+    void record(const YamlEvent& event)
+    {
+        for (auto& capture : m_captures) {
+            capture.events.push_back(event);
+            capture.depth += event.depth();
+        }
+        if (event.anchor != YAML::NullAnchor) {
+            m_captures.push_back({event.anchor, event.depth(), {event}});
+        }
+        while (!m_captures.empty() && m_captures.back().depth == 0) {
+            (*m_anchors)[m_captures.back().anchor] = std::move(m_captures.back().events);
+            m_captures.pop_back();
+        }
+    }
+
+private:
+    Attribute*           m_root;
+    Attribute*           m_pending = nullptr;
+    std::vector<Frame>   m_stack;
+    YAML::Node           m_scratch;
+    YamlAnchors          m_ownAnchors;
+    YamlAnchors*         m_anchors;
+    std::vector<Capture> m_captures;
+    IVariant*            m_variant      = nullptr;
+    int                  m_variantDepth = 0;
+    YamlEvents           m_variantEvents;
+};
+
+// =========================================================================================================================================
+
+/// Feeds the emitter with the events. Mapping and its keys are emitted when the first value inside is, so the mappings and the fields
+/// without values are left out as the document does with undefined nodes. In incremental mode the calls are logged, fragments of the
+/// log are cached by the nodes and replayed later.
+class YamlWriter
+{
+public:
+    struct Event
+    {
+        enum Kind
+        {
+            BeginMap,
+            EndMap,
+            Key,
+            EndKey,
+            BeginSeq,
+            EndSeq,
+            EmptyMap,
+            EmptySeq,
+            Scalar,
+            Null
+        } kind;
+        std::string value;
+    };
+
+    using Fragment = std::vector<Event>;
+
+    YamlWriter(YAML::Emitter& emitter, bool incremental)
+        : m_emitter(emitter)
+        , m_incremental(incremental)
+    {
+    }
+
+    void beginMap()
+    {
+        log(Event::BeginMap);
+        m_pending.push_back({Pending::Map, {}});
+    }
+
+    void endMap()
+    {
+        log(Event::EndMap);
+        pop();
+    }
+
+    void key(std::string key)
+    {
+        log(Event::Key, key);
+        m_pending.push_back({Pending::Key, std::move(key)});
+    }
+
+    void endKey()
+    {
+        log(Event::EndKey);
+        pop();
+    }
+
+    void beginSeq()
+    {
+        log(Event::BeginSeq);
+        flush();
+        m_emitter << YAML::BeginSeq;
+    }
+
+    void endSeq()
+    {
+        log(Event::EndSeq);
+        m_emitter << YAML::EndSeq;
+    }
+
+    void emptyMap()
+    {
+        log(Event::EmptyMap);
+        flush();
+        m_emitter << YAML::BeginMap << YAML::EndMap;
+    }
+
+    void emptySeq()
+    {
+        log(Event::EmptySeq);
+        flush();
+        m_emitter << YAML::BeginSeq << YAML::EndSeq;
+    }
+
+    void scalar(const std::string& value)
+    {
+        log(Event::Scalar, value);
+        flush();
+        m_emitter << value;
+    }
+
+    void null()
+    {
+        log(Event::Null);
+        flush();
+        m_emitter << YAML::Null;
+    }
+
+    /// Returns count of the events written, to check if the value gave any
+    size_t written() const
+    {
+        return m_written;
+    }
+
+    size_t mark() const
+    {
+        return m_log.size();
+    }
+
+    Fragment fragment(size_t mark) const
+    {
+        return Fragment(m_log.begin() + std::ptrdiff_t(mark), m_log.end());
+    }
+
+    void append(const Fragment& fragment)
+    {
+        for (const auto& event : fragment) {
+            replay(event);
+        }
+    }
+
+    /// Events do not depend on the nesting level
+    uint32_t cacheKey(Option opt) const
+    {
+        return uint32_t(opt);
+    }
+
+private:
+    struct Pending
+    {
+        enum
+        {
+            Map,
+            Key
+        } kind;
+        std::string key;
+    };
+
+    void log(Event::Kind kind, const std::string& value = {})
+    {
+        if (m_incremental) {
+            m_log.push_back({kind, value});
+        }
+    }
+
+    void replay(const Event& event)
+    {
+        switch (event.kind) {
+        case Event::BeginMap:
+            return beginMap();
+        case Event::EndMap:
+            return endMap();
+        case Event::Key:
+            return key(event.value);
+        case Event::EndKey:
+            return endKey();
+        case Event::BeginSeq:
+            return beginSeq();
+        case Event::EndSeq:
+            return endSeq();
+        case Event::EmptyMap:
+            return emptyMap();
+        case Event::EmptySeq:
+            return emptySeq();
+        case Event::Scalar:
+            return scalar(event.value);
+        case Event::Null:
+            return null();
+        }
+    }
+
+    void flush()
+    {
+        for (; m_flushed < m_pending.size(); ++m_flushed) {
+            const auto& pending = m_pending[m_flushed];
+            if (pending.kind == Pending::Map) {
+                m_emitter << YAML::BeginMap;
+            } else {
+                m_emitter << YAML::Key << pending.key << YAML::Value;
+            }
+        }
+        ++m_written;
+    }
+
+    void pop()
+    {
+        if (m_flushed == m_pending.size()) {
+            if (m_pending.back().kind == Pending::Map) {
+                m_emitter << YAML::EndMap;
             }
+            --m_flushed;
         }
+        m_pending.pop_back();
     }
+
+private:
+    YAML::Emitter&       m_emitter;
+    bool                 m_incremental;
+    std::vector<Pending> m_pending;
+    size_t               m_flushed = 0;
+    size_t               m_written = 0;
+    Fragment             m_log;
 };
 
 // =========================================================================================================================================
 
+/// Serializes straight into the emitter. Items of lists and maps without value are written as nulls, fields are skipped.
 class YamlSerializer : public Serialize<YamlSerializer>
 {
 public:
     template <typename T>
-    static void packValue(const T& val, YAML::Node& yaml, Option opt)
+    static void packValue(const T& val, YamlWriter& yaml, Option opt)
     {
         if (val.hasValue() || isSet(opt, Option::WithDefaults)) {
             Convert<T::ThisType>::encode(val, yaml, opt);
         }
     }
 
-    static void packValue(const IMap& val, YAML::Node& yaml, Option opt)
+    static void packValue(const IMap& val, YamlWriter& yaml, Option opt)
     {
         if (val.size()) {
+            yaml.beginMap();
             for (int i = 0; i < val.size(); ++i) {
-                const auto&      key  = val.keyByIndex(i);
-                const Attribute& node = val.get(key);
-                YAML::Node       child;
-
-                visit(node, child, opt);
-                yaml[key] = child;
+                const auto& key = val.keyByIndex(i);
+                yaml.key(toStdString(key));
+                item(val.get(key), yaml, opt);
+                yaml.endKey();
             }
+            yaml.endMap();
         } else if (isSet(opt, Option::WithDefaults)) {
-            yaml = YAML::Node(YAML::NodeType::Map);
+            yaml.emptyMap();
         }
     }
 
-    static void packValue(const IList& val, YAML::Node& yaml, Option opt)
+    static void packValue(const IList& val, YamlWriter& yaml, Option opt)
     {
         if (val.size()) {
+            yaml.beginSeq();
             for (int i = 0; i < val.size(); ++i) {
-                const Attribute& node = val.get(i);
-                YAML::Node       child;
-                visit(node, child, opt);
-                yaml.push_back(child);
+                item(val.get(i), yaml, opt);
             }
+            yaml.endSeq();
         } else if (isSet(opt, Option::WithDefaults)) {
-            yaml = YAML::Node(YAML::NodeType::Sequence);
+            yaml.emptySeq();
         }
     }
 
-    static void packValue(const INode& node, YAML::Node& yaml, Option opt)
+    static void packValue(const INode& node, YamlWriter& yaml, Option opt)
     {
-        for (auto& it : node.fields()) {
-            if (node.hasValue() || isSet(opt, Option::WithDefaults)) {
-                YAML::Node child = yaml[it.get().key()];
-                visit(it.get(), child, opt);
+        const bool withDefaults = isSet(opt, Option::WithDefaults);
+
+        yaml.beginMap();
+        for (auto& it : withDefaults ? node.fields() : node.presentFields()) {
+            if (withDefaults || it.hasValue()) {
+                yaml.key(toStdString(it.key()));
+                visit(it, yaml, opt);
+                yaml.endKey();
             }
         }
+        yaml.endMap();
     }
 
-    static void packValue(const IEnum& en, YAML::Node& yaml, Option /*opt*/)
+    static void packValue(const IEnum& en, YamlWriter& yaml, Option /*opt*/)
     {
-        yaml = YAML::convert<string_t>::encode(en.asString());
+        yaml.scalar(toStdString(en.asString()));
     }
 
-    static void packValue(const IVariant& var, YAML::Node& yaml, Option opt)
+    static void packValue(const IVariant& var, YamlWriter& yaml, Option opt)
     {
         if (auto ptr = var.get()) {
             packValue(static_cast<const INode&>(*ptr), yaml, opt);
         }
     }
+
+    /// Writes the value which is always present in the document, list or map item, null if the value gives nothing
+    static void item(const Attribute& attr, YamlWriter& yaml, Option opt)
+    {
+        size_t written = yaml.written();
+        visit(attr, yaml, opt);
+        if (yaml.written() == written) {
+            yaml.null();
+        }
+    }
 };
 
 // =========================================================================================================================================
 
-Expected<string_t> serialize(const Attribute& node, Option opt)
+/// Stream buffer which appends to the container
+template <typename Out>
+class AppendBuffer : public std::streambuf
 {
+public:
+    explicit AppendBuffer(Out& out)
+        : m_out(out)
+    {
+    }
+
+protected:
+    int_type overflow(int_type ch) override
+    {
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            m_out.push_back(traits_type::to_char_type(ch));
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    std::streamsize xsputn(const char* data, std::streamsize size) override
+    {
+        m_out.insert(m_out.end(), data, data + size);
+        return size;
+    }
+
+private:
+    Out& m_out;
+};
+
+template <typename Out>
+static Expected<void> serializeTo(const Attribute& node, Out& out, Option opt)
+{
+    size_t mark = out.size();
     try {
-        YAML::Node yaml;
-        YamlSerializer::visit(node, yaml, opt);
-        return fromStdString(YAML::Dump(yaml));
+        AppendBuffer  buffer(out);
+        std::ostream  stream(&buffer);
+        YAML::Emitter emitter(stream);
+        YamlWriter    writer(emitter, isSet(opt, Option::Incremental));
+
+        YamlSerializer::visit(node, writer, opt);
+        if (!emitter.good()) {
+            out.resize(mark);
+            return unexpected(emitter.GetLastError());
+        }
+        return {};
     } catch (const std::exception& e) {
+        out.resize(mark);
         return unexpected(e.what());
     }
 }
 
+Expected<string_t> serialize(const Attribute& node, Option opt)
+{
+    std::string out;
+    if (auto ret = serializeTo(node, out, opt); !ret) {
+        return unexpected(ret.error());
+    }
+    return fromStdString(out);
+}
+
+Expected<void> serialize(const Attribute& node, std::string& out, Option opt)
+{
+    return serializeTo(node, out, opt);
+}
+
+Expected<void> serialize(const Attribute& node, std::vector<char>& out, Option opt)
+{
+    return serializeTo(node, out, opt);
+}
+
+Expected<void> serialize(const Attribute& node, Sink& sink, Option opt)
+{
+    return staged(
+        [&](std::string& buffer) {
+            return serializeTo(node, buffer, opt);
+        },
+        [&](std::string_view buffer) {
+            return sink.write(buffer.data(), buffer.size());
+        });
+}
+
+/// Read only stream buffer over the caller memory, lets yaml-cpp read the content without copying it
+class ViewBuffer : public std::streambuf
+{
+public:
+    explicit ViewBuffer(std::string_view content)
+    {
+        char* data = const_cast<char*>(content.data());
+        setg(data, data, data + content.size());
+    }
+};
+
 Expected<void> deserialize(const string_t& content, Attribute& node)
+{
+#ifdef WITH_QTSTRING
+    return deserialize(std::string_view(content.toStdString()), node);
+#else
+    return deserialize(std::string_view(content), node);
+#endif
+}
+
+Expected<void> deserialize(std::string_view content, Attribute& node)
 {
     try {
-        YAML::Node yaml = YAML::Load(toStdString(content));
-        YamlDeserializer::visit(node, yaml);
+        ViewBuffer   buffer(content);
+        std::istream stream(&buffer);
+        YAML::Parser parser(stream);
+        YamlReader   reader(node);
+
+        if (!parser.HandleNextDocument(reader)) {
+            // Empty content is read as null document
+            reader.OnNull(YAML::Mark::null_mark(), YAML::NullAnchor);
+        }
         return {};
     } catch (const std::exception& e) {
         return unexpected(e.what());
     }
 }
 
-Expected<void> deserializeFile(const string_t& fileName, Attribute& node)
+Expected<void> deserialize(const std::byte* data, size_t size, Attribute& node)
 {
-    if (auto cnt = read(fileName)) {
-        return deserialize(*cnt, node);
-    } else {
-        return unexpected(cnt.error());
+    return deserialize(std::string_view(reinterpret_cast<const char*>(data), size), node);
+}
+
+Expected<void> deserialize(const char* content, Attribute& node)
+{
+    return deserialize(std::string_view(content), node);
+}
+
+// =========================================================================================================================================
+
+/// Appends the document to the stream, documents without content are written as nulls to keep their count
+static Expected<void> appendDocument(const Attribute& node, std::string& out, bool first, Option opt)
+{
+    if (!first) {
+        out += "\n---\n";
+    }
+    size_t mark = out.size();
+    if (auto ret = serializeTo(node, out, opt); !ret) {
+        return unexpected(ret.error());
     }
+    if (out.size() == mark) {
+        out += "~";
+    }
+    return {};
 }
 
-Expected<void> serializeFile(const string_t& fileName, const Attribute& node, Option opt)
+Expected<void> details::serializeAll(const NextDocument& next, std::string& out, Option opt)
 {
-    if (auto ret = serialize(node, opt)) {
-        if (auto res = write(fileName, *ret); !res) {
-            return unexpected(res.error());
+    size_t mark = out.size();
+    for (bool first = true; const Attribute* node = next(); first = false) {
+        if (auto ret = appendDocument(*node, out, first, opt); !ret) {
+            out.resize(mark);
+            return unexpected(ret.error());
+        }
+    }
+    return {};
+}
+
+Expected<void> details::serializeAll(const NextDocument& next, Sink& sink, Option opt)
+{
+    std::string buffer;
+    for (bool first = true; const Attribute* node = next(); first = false) {
+        buffer.clear();
+        if (auto ret = appendDocument(*node, buffer, first, opt); !ret) {
+            return unexpected(ret.error());
+        }
+        if (auto ret = sink.write(buffer.data(), buffer.size()); !ret) {
+            return unexpected(ret.error());
+        }
+    }
+    return {};
+}
+
+Expected<void> details::deserializeAll(std::istream& stream, Attribute& node, const DocumentRead& read)
+{
+    size_t document = 0;
+    try {
+        YAML::Parser parser(stream);
+        YamlReader   reader(node);
+
+        while (true) {
+            node.clear();
+            reader.reset(node);
+            ++document;
+            if (!parser.HandleNextDocument(reader) || !read()) {
+                break;
+            }
         }
         return {};
-    } else {
+    } catch (const std::exception& e) {
+        return unexpected("Document {}: {}"_s, document, e.what());
+    }
+}
+
+Expected<void> details::deserializeAll(std::string_view content, Attribute& node, const DocumentRead& read)
+{
+    ViewBuffer   buffer(content);
+    std::istream stream(&buffer);
+    return deserializeAll(stream, node, read);
+}
+
+// =========================================================================================================================================
+
+Expected<void> deserializeFile(const string_t& fileName, Attribute& node)
+{
+    std::string content;
+    if (auto ret = read(fileName, content); !ret) {
         return unexpected(ret.error());
     }
+    return deserialize(std::string_view(content), node);
+}
+
+Expected<void> serializeFile(const string_t& fileName, const Attribute& node, Option opt)
+{
+    return staged(
+        [&](std::string& buffer) {
+            return serializeTo(node, buffer, opt);
+        },
+        [&](std::string_view buffer) {
+            return write(fileName, buffer);
+        });
 }
 
 // =========================================================================================================================================
@@ -0,0 +1,114 @@
+/* =========================================================================================================================================
+    ____ __ _ ____ __  __
+   |    |  ` |    |  /  /
+   | |  | |  | |__|    /
+   | ___| |  | |  |    \
+   |_|  |__,_|____|__\__\ DSO library
+
+   Copyright (C) 2020 Eaton
+   Copyright (C) 2020-2022 zJes
+
+   This program is free software; you can redistribute it and/or modify it under the terms of the GNU Lesser General Public License as
+   published by the Free Software Foundation; either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+========================================================================================================================================= */
+#include "pack/sink.h"
+#include "pack/formatter.h" // IWYU pragma: keep
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ostream>
+#include <unistd.h>
+
+namespace pack {
+
+// =========================================================================================================================================
+
+StreamSink::StreamSink(std::ostream& stream)
+    : m_stream(stream)
+{
+}
+
+Expected<void> StreamSink::write(const char* data, size_t size)
+{
+    if (!m_stream.write(data, std::streamsize(size))) {
+        return unexpected("Cannot write to the stream"_s);
+    }
+    return {};
+}
+
+// =========================================================================================================================================
+
+FdSink::FdSink(int fd)
+    : m_fd(fd)
+{
+}
+
+Expected<void> FdSink::write(const char* data, size_t size)
+{
+    while (size) {
+        auto written = ::write(m_fd, data, size);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written < 0) {
+            return unexpected("Cannot write to the file descriptor: {}"_s, std::strerror(errno));
+        }
+        data += written;
+        size -= size_t(written);
+    }
+    return {};
+}
+
+// =========================================================================================================================================
+
+BufferSink::BufferSink(char* buffer, size_t capacity, Overflow overflow)
+    : m_buffer(buffer)
+    , m_capacity(capacity)
+    , m_overflow(std::move(overflow))
+{
+}
+
+Expected<void> BufferSink::write(const char* data, size_t size)
+{
+    while (size) {
+        if (m_size == m_capacity) {
+            if (!m_overflow || !m_capacity) {
+                return unexpected("Buffer is full"_s);
+            }
+            if (auto ret = flush(); !ret) {
+                return unexpected(ret.error());
+            }
+        }
+        size_t chunk = std::min(size, m_capacity - m_size);
+        std::memcpy(m_buffer + m_size, data, chunk);
+        m_size += chunk;
+        data += chunk;
+        size -= chunk;
+    }
+    return {};
+}
+
+Expected<void> BufferSink::flush()
+{
+    if (m_size && m_overflow) {
+        if (auto ret = m_overflow(m_buffer, m_size); !ret) {
+            return unexpected(ret.error());
+        }
+        m_size = 0;
+    }
+    return {};
+}
+
+size_t BufferSink::size() const
+{
+    return m_size;
+}
+
+// =========================================================================================================================================
+
+} // namespace pack
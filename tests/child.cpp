@@ -101,3 +101,25 @@ TEST_CASE("Child copy/move")
         REQUIRE(other.child == "child"_s);
     }
 }
+
+TEST_CASE("Child fields table")
+{
+    child::Child origin;
+    origin.value = "value"_s;
+    origin.child = "child"_s;
+
+    auto table = child::Child::staticFields();
+    REQUIRE(table.size() == 3);
+    CHECK(table[0].name == "value");
+    CHECK(table[1].name == "field");
+    CHECK(table[2].name == "child");
+    CHECK(table[2].type == pack::Attribute::NodeType::Value);
+
+    std::vector<pack::string_t> keys;
+    for (const auto& it : origin.fields()) {
+        keys.push_back(it.key());
+    }
+    CHECK(keys == std::vector<pack::string_t>{"value"_s, "field"_s, "child"_s});
+    CHECK(&origin.fields()[2] == &origin.child);
+    CHECK(origin.fieldNames() == std::vector<pack::string_t>{"value"_s, "field"_s, "child"_s});
+}
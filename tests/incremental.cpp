@@ -0,0 +1,144 @@
+/*  ========================================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ========================================================================================================================================
+*/
+#include <catch2/catch.hpp>
+#include <pack/pack.h>
+
+namespace incremental {
+
+struct Leaf : public pack::Node
+{
+    pack::String name  = FIELD("name");
+    pack::Int32  value = FIELD("value");
+
+    using pack::Node::Node;
+    META(Leaf, name, value);
+};
+
+struct State : public pack::Node
+{
+    pack::String     title = FIELD("title");
+    Leaf             main  = FIELD("main");
+    pack::List<Leaf> items = FIELD("items");
+    pack::Map<Leaf>  named = FIELD("named");
+
+    using pack::Node::Node;
+    META(State, title, main, items, named);
+};
+
+static State makeState()
+{
+    State state;
+    state.title      = "state"_s;
+    state.main.name  = "main"_s;
+    state.main.value = 1;
+    for (int i = 0; i < 3; ++i) {
+        auto& item = state.items.append();
+        item.name  = pack::fromStdString("item" + std::to_string(i));
+        item.value = i;
+    }
+    state.named.append("first"_s).value = 42;
+    return state;
+}
+
+} // namespace incremental
+
+TEST_CASE("Incremental json serialization")
+{
+    auto state = incremental::makeState();
+    auto opt   = pack::Option::Incremental;
+
+    CHECK(state.isDirty());
+    auto first = pack::json::serialize(state, opt);
+    REQUIRE(first);
+    CHECK(*first == *pack::json::serialize(state));
+    CHECK(!state.isDirty());
+    CHECK(!state.main.isDirty());
+    CHECK(!state.items[1].isDirty());
+
+    CHECK(*pack::json::serialize(state, opt) == *first);
+
+    state.items[1].value = 100;
+    CHECK(state.items[1].isDirty());
+    CHECK(state.isDirty());
+    CHECK(!state.main.isDirty());
+    CHECK(!state.items[0].isDirty());
+
+    auto second = pack::json::serialize(state, opt);
+    REQUIRE(second);
+    CHECK(*second != *first);
+    CHECK(*second == *pack::json::serialize(state));
+
+    state.named["first"_s].name = "renamed"_s;
+    CHECK(state.isDirty());
+    CHECK(*pack::json::serialize(state, opt) == *pack::json::serialize(state));
+
+    state.items.append().name = "new"_s;
+    CHECK(state.isDirty());
+    CHECK(*pack::json::serialize(state, opt) == *pack::json::serialize(state));
+
+    auto pretty = pack::Option::Incremental | pack::Option::PrettyPrint;
+    CHECK(*pack::json::serialize(state, pretty) == *pack::json::serialize(state, pack::Option::PrettyPrint));
+    CHECK(*pack::json::serialize(state, opt) == *pack::json::serialize(state));
+}
+
+TEST_CASE("Incremental yaml serialization")
+{
+    auto state = incremental::makeState();
+    auto opt   = pack::Option::Incremental;
+
+    auto first = pack::yaml::serialize(state, opt);
+    REQUIRE(first);
+    CHECK(*first == *pack::yaml::serialize(state));
+    CHECK(!state.isDirty());
+
+    state.main.value = 2;
+    CHECK(state.isDirty());
+    CHECK(!state.items[0].isDirty());
+    CHECK(*pack::yaml::serialize(state, opt) == *pack::yaml::serialize(state));
+
+    state.items.clear();
+    CHECK(*pack::yaml::serialize(state, opt) == *pack::yaml::serialize(state));
+    CHECK(*pack::yaml::serialize(state, opt) == *pack::yaml::serialize(state));
+}
+
+TEST_CASE("Incremental serialization after reordering and unset fields")
+{
+    auto state = incremental::makeState();
+    auto opt   = pack::Option::Incremental;
+
+    auto first = pack::json::serialize(state, opt);
+    REQUIRE(first);
+
+    state.items.sort([](const incremental::Leaf& left, const incremental::Leaf& right) {
+        return left.value > right.value;
+    });
+    CHECK(state.isDirty());
+    auto sorted = pack::json::serialize(state, opt);
+    REQUIRE(sorted);
+    CHECK(*sorted != *first);
+    CHECK(*sorted == *pack::json::serialize(state));
+
+    // Node which was skipped as empty reports its changes after each serialization of the owner
+    incremental::State empty;
+    CHECK(*pack::json::serialize(empty, opt) == *pack::json::serialize(empty));
+    for (int i = 0; i < 3; ++i) {
+        empty.main.value = i + 1;
+        empty.main.value = i + 2;
+        CHECK(empty.isDirty());
+        CHECK(*pack::json::serialize(empty, opt) == *pack::json::serialize(empty));
+        CHECK(!empty.isDirty());
+    }
+}
@@ -0,0 +1,158 @@
+/*  ========================================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ========================================================================================================================================
+*/
+#include <catch2/catch.hpp>
+#include <pack/json-lines.h>
+#include <pack/pack.h>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+namespace lines {
+
+struct Record : public pack::Node
+{
+    pack::Int32      id   = FIELD("id");
+    pack::String     name = FIELD("name");
+    pack::StringList tags = FIELD("tags");
+
+    using pack::Node::Node;
+    META(Record, id, name, tags);
+};
+
+} // namespace lines
+
+TEST_CASE("Json lines")
+{
+    SECTION("stream")
+    {
+        std::stringstream ss;
+        {
+            pack::json::LinesWriter writer(ss, pack::Option::PrettyPrint, 64);
+            for (int i = 0; i < 100; ++i) {
+                lines::Record rec;
+                rec.id   = i;
+                rec.name = pack::fromStdString("record\n" + std::to_string(i));
+                if (i % 3 == 0) {
+                    rec.tags = {"a"_s, "b"_s};
+                }
+                REQUIRE(writer.write(rec));
+            }
+        }
+
+        pack::json::LinesReader<lines::Record> reader(ss, pack::json::Parser::Structural, 16);
+
+        int count = 0;
+        while (true) {
+            auto rec = reader.next();
+            REQUIRE(rec);
+            if (!*rec) {
+                break;
+            }
+            CHECK((*rec)->id == count);
+            CHECK((*rec)->name == pack::fromStdString("record\n" + std::to_string(count)));
+            CHECK((*rec)->tags.size() == (count % 3 == 0 ? 2 : 0));
+            ++count;
+        }
+        CHECK(count == 100);
+        CHECK(reader.line() == 100);
+    }
+
+    SECTION("blank lines and last line without newline")
+    {
+        std::stringstream ss("{\"id\":1}\n\n  \r\n{\"id\":2,\"name\":\"two\"}\r\n{\"id\":3}");
+
+        pack::json::LinesReader<lines::Record> reader(ss);
+        std::vector<int> ids;
+        while (auto rec = *reader.next()) {
+            ids.push_back(rec->id);
+            if (rec->id != 2) {
+                CHECK(!rec->name.hasValue());
+            }
+        }
+        CHECK(ids == std::vector<int>{1, 2, 3});
+    }
+
+    SECTION("zero buffer size")
+    {
+        std::stringstream ss("{\"id\":1}\n{\"id\":2}\n");
+
+        pack::json::LinesReader<lines::Record> reader(ss, pack::json::Parser::Sax, 0);
+        std::vector<int> ids;
+        while (auto rec = *reader.next()) {
+            ids.push_back(rec->id);
+        }
+        CHECK(ids == std::vector<int>{1, 2});
+
+        int fds[2];
+        REQUIRE(pipe(fds) == 0);
+        REQUIRE(write(fds[1], "{\"id\":3}\n", 9) == 9);
+        close(fds[1]);
+
+        pack::json::LinesReader<lines::Record> fdReader(fds[0], pack::json::Parser::Structural, 0);
+        auto rec = fdReader.next();
+        REQUIRE(rec);
+        REQUIRE(*rec);
+        CHECK((*rec)->id == 3);
+        CHECK(!*fdReader.next());
+        close(fds[0]);
+    }
+
+    SECTION("error reports the line")
+    {
+        for (auto parser : {pack::json::Parser::Sax, pack::json::Parser::Structural}) {
+            std::stringstream ss("{\"id\":1}\n{\"id\":\n");
+
+            pack::json::LinesReader<lines::Record> reader(ss, parser);
+            CHECK(*reader.next());
+            auto ret = reader.next();
+            REQUIRE(!ret);
+            CHECK(pack::toStdString(ret.error()).find("Line 2") == 0);
+        }
+    }
+
+    SECTION("failed stream")
+    {
+        std::ifstream file("/nonexistent/records.jsonl");
+
+        pack::json::LinesReader<lines::Record> reader(file);
+        CHECK(!reader.next());
+    }
+
+    SECTION("file descriptor")
+    {
+        int fds[2];
+        REQUIRE(pipe(fds) == 0);
+        {
+            pack::json::LinesWriter writer(fds[1]);
+            lines::Record           rec;
+            rec.id   = 42;
+            rec.name = "fd"_s;
+            REQUIRE(writer.write(rec));
+            REQUIRE(writer.write(rec));
+        }
+        close(fds[1]);
+
+        pack::json::LinesReader<lines::Record> reader(fds[0]);
+        int count = 0;
+        while (auto rec = *reader.next()) {
+            CHECK(rec->id == 42);
+            CHECK(rec->name == "fd"_s);
+            ++count;
+        }
+        CHECK(count == 2);
+        close(fds[0]);
+    }
+}
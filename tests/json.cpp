@@ -77,3 +77,257 @@ TEST_CASE("Orderding data in json")
     auto json = *pack::json::serialize(data);
     CHECK(json == R"({"c":"C","a":"A"})"_s); // Ordered as in pack structure and without default value
 }
+
+struct Numbers : public pack::Node
+{
+    pack::Binary     bin    = FIELD("bin");
+    pack::Float      flt    = FIELD("flt");
+    pack::String     str    = FIELD("str");
+    pack::DoubleList values = FIELD("values");
+    pack::StringMap  map    = FIELD("map");
+
+    using pack::Node::Node;
+    META(Numbers, bin, flt, str, values, map);
+};
+
+TEST_CASE("Json writer output")
+{
+    Numbers data;
+    data.bin.setString("ab\x01"_s);
+    data.flt    = 42.2f;
+    data.str    = "q\"\n\x01/\\"_s;
+    data.values = {1.0, 1e100, 1e-7, 0.1, 123456789012345678.0, 1e15, 1e14, 0.0001, -2.5};
+    data.map.append("a"_s);
+
+    CHECK(*pack::json::serialize(data) ==
+          R"({"bin":[97,98,1],"flt":42.20000076293945,"str":"q\"\n\u0001/\\",)"
+          R"("values":[1.0,1e+100,1e-07,0.1,1.2345678901234568e+17,1e+15,100000000000000.0,0.0001,-2.5],"map":{"a":null}})"_s);
+
+    CHECK(*pack::json::serialize(data.map, pack::Option::PrettyPrint) == "{\n    \"a\": null\n}"_s);
+    CHECK(*pack::json::serialize(data.map, pack::Option::PrettyPrint | pack::Option::WithDefaults) == "{\n    \"a\": \"\"\n}"_s);
+
+    Numbers restored;
+    REQUIRE(pack::json::deserialize(*pack::json::serialize(data), restored));
+    CHECK(restored == data);
+
+    // Multibyte UTF-8 is kept as is, invalid sequences are rejected as nlohmann does
+    pack::String text;
+    text = pack::fromStdString("\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80");
+    CHECK(*pack::json::serialize(text) == pack::fromStdString("\"\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80\""));
+    for (auto invalid : {"\xff", "a\xc3", "\xc0\xaf", "\xed\xa0\x80", "\xf4\x90\x80\x80", "\xe2\x82"}) {
+        text = pack::fromStdString(invalid);
+        auto ret = pack::json::serialize(text);
+        REQUIRE(!ret);
+        CHECK(pack::toStdString(ret.error()).find("invalid UTF-8") == 0);
+    }
+}
+
+struct Inner : public pack::Node
+{
+    pack::String    name   = FIELD("name");
+    pack::Int32List ids    = FIELD("ids");
+    pack::Int64Map  counts = FIELD("counts");
+
+    using pack::Node::Node;
+    META(Inner, name, ids, counts);
+};
+
+struct Outer : public pack::Node
+{
+    pack::Int32       num   = FIELD("num");
+    pack::Bool        flag  = FIELD("flag");
+    Inner             inner = FIELD("inner");
+    pack::List<Inner> items = FIELD("items");
+
+    using pack::Node::Node;
+    META(Outer, num, flag, inner, items);
+};
+
+TEST_CASE("Json reading")
+{
+    SECTION("skips unknown members")
+    {
+        auto  json = R"({"skip":{"a":[1,{"b":2}],"c":null},"num":"42","inner":{"name":"in","ids":[1,2],"counts":{"a":1,"b":2}},
+                        "other":[[1],[2]],"items":[{"name":"first"},{},{"ids":[3]}],"flag":true})"_s;
+        Outer data;
+        REQUIRE(pack::json::deserialize(json, data));
+
+        CHECK(data.num == 42);
+        CHECK(data.flag == true);
+        CHECK(data.inner.name == "in"_s);
+        CHECK(data.inner.ids == pack::Int32List({1, 2}));
+        CHECK(data.inner.counts.size() == 2);
+        CHECK(data.inner.counts["b"_s] == 2);
+        REQUIRE(data.items.size() == 3);
+        CHECK(data.items[0].name == "first"_s);
+        CHECK(!data.items[1].hasValue());
+        CHECK(data.items[2].ids == pack::Int32List({3}));
+    }
+
+    SECTION("wrong content")
+    {
+        Outer data;
+        CHECK(!pack::json::deserialize(R"({"num":1,)"_s, data));
+        CHECK(!pack::json::deserialize(R"({"num":{"a":1}})"_s, data));
+        CHECK(!pack::json::deserialize(R"({"flag":1})"_s, data));
+        CHECK(!pack::json::deserialize(R"({"inner":{"name":5}})"_s, data));
+    }
+
+    SECTION("from view")
+    {
+        // Parsed in place, the trailing part must not be touched
+        std::string buffer = R"({"num":42,"inner":{"name":"in"}}garbage)";
+        auto        view   = std::string_view(buffer).substr(0, buffer.find("garbage"));
+
+        Outer sax;
+        REQUIRE(pack::json::deserialize(view, sax));
+        CHECK(sax.num == 42);
+        CHECK(sax.inner.name == "in"_s);
+
+        Outer structural;
+        REQUIRE(pack::json::deserialize(view, structural, pack::json::Parser::Structural));
+        CHECK(structural == sax);
+
+        Outer bytes;
+        REQUIRE(pack::json::deserialize(reinterpret_cast<const std::byte*>(view.data()), view.size(), bytes));
+        CHECK(bytes == sax);
+
+        Outer wrong;
+        CHECK(!pack::json::deserialize(std::string_view(buffer), wrong));
+    }
+
+    SECTION("from string literal")
+    {
+        Outer data;
+        REQUIRE(pack::json::deserialize(R"({"num":42,"inner":{"name":"in"}})", data));
+        CHECK(data.num == 42);
+        CHECK(data.inner.name == "in"_s);
+
+        Outer structural;
+        REQUIRE(pack::json::deserialize(R"({"num":42,"inner":{"name":"in"}})", structural, pack::json::Parser::Structural));
+        CHECK(structural == data);
+    }
+}
+
+TEST_CASE("Structural json parser")
+{
+    using Parser = pack::json::Parser;
+
+    SECTION("same result as sax")
+    {
+        Numbers data;
+        data.bin.setString("bin"_s);
+        data.flt    = -1.5f;
+        data.str    = pack::fromStdString(std::string(60, 'x') + "\"{}[],:\\" + std::string(70, '\\') + "\" \t\n\x01 end");
+        data.values = {1.0, -2.0, 1e100, 0.1, 18446744073709551615.0};
+        data.map.append("key \"{\""_s) = "va,l:ue"_s;
+        data.map.append(pack::fromStdString(std::string(63, 'k') + "\\")) = pack::fromStdString(std::string(64, '"'));
+
+        auto json = pack::json::serialize(data, pack::Option::PrettyPrint);
+        REQUIRE(json);
+
+        Numbers sax;
+        REQUIRE(pack::json::deserialize(*json, sax, Parser::Sax));
+        Numbers structural;
+        REQUIRE(pack::json::deserialize(*json, structural, Parser::Structural));
+        CHECK(structural == sax);
+        CHECK(structural == data);
+    }
+
+    SECTION("scalars and escapes")
+    {
+        auto json = R"({"num":-17,"flag":false,"inner":{"name":"é😀\/\n","ids":[18446744073,0,-1],"counts":{}},"x":null})"_s;
+
+        Outer sax;
+        REQUIRE(pack::json::deserialize(json, sax, Parser::Sax));
+        Outer structural;
+        REQUIRE(pack::json::deserialize(json, structural, Parser::Structural));
+        CHECK(structural == sax);
+        CHECK(structural.num == -17);
+        CHECK(structural.inner.name == pack::fromStdString("\xc3\xa9\xf0\x9f\x98\x80/\n"));
+    }
+
+    SECTION("wrong content")
+    {
+        Outer data;
+        for (auto json : {R"({"num":1,)", R"({"num" 1})", R"({"num":1}})", R"({"num":tru})", R"({"num":"1)", R"(["a" "b"])", R"({"num":1x})", ""}) {
+            CHECK(!pack::json::deserialize(pack::fromStdString(json), data, Parser::Structural));
+        }
+    }
+
+    SECTION("deep nesting")
+    {
+        auto nested = [](size_t depth) {
+            return pack::fromStdString("{\"x\":" + std::string(depth, '[') + std::string(depth, ']') + "}");
+        };
+
+        Outer data;
+        CHECK(pack::json::deserialize(nested(999), data, Parser::Structural));
+        auto ret = pack::json::deserialize(nested(1000), data, Parser::Structural);
+        REQUIRE(!ret);
+        CHECK(pack::toStdString(ret.error()).find("nesting is too deep") != std::string::npos);
+        CHECK(!pack::json::deserialize(nested(1000000), data, Parser::Structural));
+    }
+}
+
+TEST_CASE("Json coercion")
+{
+    using pack::json::Coercion;
+    using Parser = pack::json::Parser;
+
+    auto strings  = R"({"num":"42","flag":"true","inner":{"ids":["1", 2]}})"_s;
+    auto mismatch = R"({"num":true,"flag":1,"inner":{"name":5,"ids":{"a":1}},"items":"x"})"_s;
+    auto bad      = R"({"num":"parrot"})"_s;
+
+    for (auto parser : {Parser::Sax, Parser::Structural}) {
+        // Plain SECTION in the loop would run only for the first parser
+        const char* name = parser == Parser::Sax ? "sax" : "structural";
+
+        DYNAMIC_SECTION("coerce, " << name)
+        {
+            Outer data;
+            REQUIRE(pack::json::deserialize(strings, data, parser, Coercion::Coerce));
+            CHECK(data.num == 42);
+            CHECK(data.flag == true);
+            CHECK(data.inner.ids == pack::Int32List({1, 2}));
+
+            Outer wrong;
+            auto  ret = pack::json::deserialize(bad, wrong, parser, Coercion::Coerce);
+            REQUIRE(!ret);
+            CHECK(ret.error() == "Cannot convert 'parrot' into the number"_s);
+            CHECK(!pack::json::deserialize(mismatch, wrong, parser, Coercion::Coerce));
+        }
+
+        DYNAMIC_SECTION("reject, " << name)
+        {
+            Outer data;
+            auto  ret = pack::json::deserialize(strings, data, parser, Coercion::Reject);
+            REQUIRE(!ret);
+            CHECK(ret.error() == "Cannot convert json string to Int32"_s);
+
+            Outer exact;
+            REQUIRE(pack::json::deserialize(R"({"num":42,"flag":false,"inner":{"name":"in","ids":[1]}})"_s, exact, parser, Coercion::Reject));
+            CHECK(exact.num == 42);
+            CHECK(exact.inner.ids == pack::Int32List({1}));
+
+            CHECK(!pack::json::deserialize(R"({"inner":1})"_s, exact, parser, Coercion::Reject));
+        }
+
+        DYNAMIC_SECTION("ignore, " << name)
+        {
+            Outer data;
+            data.num = 7;
+            REQUIRE(pack::json::deserialize(mismatch, data, parser, Coercion::Ignore));
+            CHECK(data.num == 7);
+            CHECK(!data.flag.hasValue());
+            CHECK(!data.inner.name.hasValue());
+            CHECK(data.inner.ids.empty());
+            CHECK(data.items.empty());
+
+            Outer strs;
+            REQUIRE(pack::json::deserialize(strings, strs, parser, Coercion::Ignore));
+            CHECK(!strs.num.hasValue());
+            CHECK(strs.inner.ids == pack::Int32List({2}));
+        }
+    }
+}
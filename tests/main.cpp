@@ -73,4 +73,53 @@ TEST_CASE("Convert")
         CHECK(false == pack::convert<bool>(false));
         CHECK(true == pack::convert<bool>(true));
     }
+
+    SECTION("numbers")
+    {
+        CHECK(int8_t(-128) == pack::convert<int8_t>(std::string("-128")));
+        CHECK(uint16_t(65535) == pack::convert<uint16_t>("65535"));
+        CHECK(int64_t(-9223372036854775807 - 1) == pack::convert<int64_t>(std::string_view("-9223372036854775808")));
+        CHECK(uint64_t(18446744073709551615ull) == pack::convert<uint64_t>("+18446744073709551615"));
+        CHECK(42 == pack::convert<int>(" 42\n"));
+        CHECK(0.1 == pack::convert<double>("0.1"));
+        CHECK(-1.5e300 == pack::convert<double>("-1.5e300"));
+        CHECK(42.1f == pack::convert<float>("42.1"));
+        CHECK_THROWS_AS(pack::convert<int>("parrot"), std::invalid_argument);
+        CHECK_THROWS_AS(pack::convert<uint8_t>("256"), std::invalid_argument);
+    }
+
+    SECTION("shortest round trip")
+    {
+        for (double value : {0.1, 1. / 3., 1e-300, 123456789.123456789, -2.5e22}) {
+            CHECK(value == pack::convert<double>(pack::convert<std::string>(value)));
+        }
+        CHECK("0.1" == pack::convert<std::string>(0.1));
+        CHECK("0.33333334" == pack::convert<std::string>(1.f / 3.f));
+        CHECK("1e+100" == pack::convert<std::string>(1e100));
+        CHECK("-128" == pack::convert<std::string>(int8_t(-128)));
+    }
+
+    SECTION("try convert")
+    {
+        auto num = pack::tryConvert<int32_t>("42");
+        REQUIRE(num);
+        CHECK(*num == 42);
+
+        CHECK(!pack::tryConvert<int32_t>(""));
+        CHECK(!pack::tryConvert<int32_t>("+"));
+        CHECK(!pack::tryConvert<int32_t>("+-1"));
+        CHECK(!pack::tryConvert<int32_t>("42parrot"));
+        CHECK(!pack::tryConvert<int32_t>("4 2"));
+        CHECK(!pack::tryConvert<uint32_t>("-1"));
+        CHECK(!pack::tryConvert<int8_t>("128"));
+        CHECK(!pack::tryConvert<double>("1e400"));
+
+        auto err = pack::tryConvert<int16_t>("100000");
+        REQUIRE(!err);
+        CHECK(err.error() == "Value '100000' is out of range"_s);
+
+        CHECK(*pack::tryConvert<float>("-0.5") == -0.5f);
+        CHECK(*pack::tryConvert<bool>(" On ") == true);
+        CHECK(*pack::tryConvert<std::string>(42) == "42");
+    }
 }
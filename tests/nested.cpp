@@ -39,6 +39,28 @@ public:
     META(Item, name, sub);
 };
 
+class Tracked : public pack::Node
+{
+public:
+    class SubItem : public pack::Node
+    {
+    public:
+        pack::Bool   exists = FIELD("exists");
+        pack::String name   = FIELD("name");
+
+        using pack::Node::Node;
+        META_WITH_PRESENCE(SubItem, exists, name);
+    };
+
+public:
+    pack::String name  = FIELD("name");
+    SubItem      sub   = FIELD("sub");
+    Item         plain = FIELD("plain");
+
+    using pack::Node::Node;
+    META_WITH_PRESENCE(Tracked, name, sub, plain);
+};
+
 }
 
 TEST_CASE("Nested serialization/deserialization")
@@ -80,3 +102,85 @@ TEST_CASE("Nested serialization/deserialization")
         check(restored);
     }
 }
+
+TEST_CASE("Nested copy/compare")
+{
+    nested::Item origin;
+    origin.name       = "Item"_s;
+    origin.sub.exists = true;
+    origin.sub.name   = "subname"_s;
+
+    nested::Item copy = origin;
+    CHECK(copy == origin);
+    CHECK(copy.sub.name == "subname"_s);
+    CHECK(copy.sub.key() == "sub"_s);
+
+    copy.sub.name = "other"_s;
+    CHECK(!(copy == origin));
+    CHECK(!copy.compare(origin));
+
+    pack::Attribute& attr = copy;
+    attr.set(origin);
+    CHECK(copy.compare(origin));
+
+    nested::Item::SubItem sub;
+    CHECK(!copy.compare(sub));
+
+    // Moves take the values over instead of copying them
+    copy.sub.name      = pack::fromStdString(std::string(100, 'x'));
+    const auto* buffer = copy.sub.name.value().data();
+
+    nested::Item moved = std::move(copy);
+    CHECK(moved.sub.name.value().data() == buffer);
+    CHECK(moved.sub.key() == "sub"_s);
+
+    nested::Item assigned;
+    assigned = std::move(moved);
+    CHECK(assigned.sub.name.value().data() == buffer);
+
+    attr.set(std::move(assigned));
+    CHECK(copy.sub.name.value().data() == buffer);
+}
+
+TEST_CASE("Nested presence")
+{
+    // Presence is tracked only on request
+    nested::Item plain;
+    CHECK(!plain.presence());
+
+    nested::Tracked item;
+    CHECK(item.presence().count() == 0);
+    CHECK(!item.hasValue());
+
+    item.sub.name = "subname"_s;
+    CHECK(item.sub.presence().count() == 1);
+    CHECK(item.presence().count() == 1);
+    CHECK(item.presence().test(1));
+    CHECK(item.hasValue());
+
+    size_t count = 0;
+    for (const auto& it : item.presentFields()) {
+        CHECK(it.key() == "sub"_s);
+        ++count;
+    }
+    CHECK(count == 1);
+
+    nested::Tracked copy = item;
+    CHECK(copy.presence().count() == 1);
+    CHECK(copy.sub.presence().test(1));
+
+    item.sub.name = ""_s;
+    CHECK(item.presence().count() == 0);
+    CHECK(!item.hasValue());
+    CHECK(copy.hasValue());
+
+    copy.clear();
+    CHECK(copy.presence().count() == 0);
+    CHECK(!copy.hasValue());
+
+    // Nested node without own bitmap reports its presence too
+    item.plain.sub.exists = true;
+    CHECK(item.presence().test(2));
+    item.plain.sub.exists = false;
+    CHECK(!item.hasValue());
+}
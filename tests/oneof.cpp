@@ -13,133 +13,116 @@
     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
     ========================================================================
 */
-#include "examples/example7.h"
-#include "examples/example8.h"
+#include "examples/example.h"
 #include <catch2/catch.hpp>
 
-TEST_CASE("Oneof serialization/deserialization")
+// Card which keeps the oneof in the variant, alternatives are in the order of the oneof fields
+struct Card : public pack::Node
 {
-    test7::Item origin;
-    origin.name = "some name";
-    origin.val1 = "some string";
-    origin.val2 = 42;
-
-    auto check = [](const test7::Item& item) {
-        REQUIRE("some name" == item.name);
-        REQUIRE(42 == item.val2);
-        REQUIRE(item.val1.empty());
-    };
+    pack::String                                     name    = FIELD("name");
+    pack::Variant<test::Person::Phone, test::Person> contact = FIELD("contact");
 
-    check(origin);
+    using pack::Node::Node;
+    META(Card, name, contact);
 
-    SECTION("Serialization yaml")
+    const std::string& fileDescriptor() const override
     {
-        std::string cnt = *pack::yaml::serialize(origin);
-        REQUIRE(!cnt.empty());
-
-        test7::Item restored;
-        pack::yaml::deserialize(cnt, restored);
-
-        check(restored);
+        return example::descriptor();
     }
 
-    SECTION("Serialization json")
+    std::string protoName() const override
     {
-        std::string cnt = *pack::json::serialize(origin);
-        REQUIRE(!cnt.empty());
-
-        test7::Item restored;
-        pack::json::deserialize(cnt, restored);
-
-        check(restored);
+        return "test.Card";
     }
+};
 
-    SECTION("Serialization zconfig")
-    {
-        std::string cnt = pack::zconfig::serialize(origin);
-        REQUIRE(!cnt.empty());
-
-        test7::Item restored;
-        pack::zconfig::deserialize(cnt, restored);
+TEST_CASE("Oneof serialization/deserialization")
+{
+    test::Contacts origin;
+    origin.phone.number = "555"_s;
+    origin.email        = "some string"_s;
 
-        check(restored);
-    }
+    auto check = [](const test::Contacts& item) {
+        REQUIRE("some string"_s == item.email);
+        REQUIRE(!item.phone.hasValue());
+    };
 
     SECTION("Serialization protobuf")
     {
-        std::string cnt = pack::protobuf::serialize(origin);
-        REQUIRE(!cnt.empty());
+        auto cnt = pack::protobuf::serialize(origin);
+        REQUIRE(cnt);
 
-        test7::Item restored;
-        pack::protobuf::deserialize(cnt, restored);
+        // Both fields are on the wire, the last one wins
+        test::Contacts restored;
+        REQUIRE(pack::protobuf::deserialize(*cnt, restored));
 
         check(restored);
     }
 }
 
-TEST_CASE("Oneof adv serialization/deserialization")
+TEST_CASE("Oneof variant serialization/deserialization")
 {
-    test8::Item origin;
-    origin.name = "some name";
-
-    origin.val1.value1 = "some string";
-    origin.val1.num1 = 42;
-
-    origin.val2.value2 = "some string 2";
-    origin.val2.num2 = 43;
-
-    auto check = [](const test8::Item& item) {
-        REQUIRE("some name" == item.name);
-        REQUIRE(!item.val1.hasValue());
-        REQUIRE(item.val2.hasValue());
-        REQUIRE("some string 2" == item.val2.value2);
-        REQUIRE(43 == item.val2.num2);
+    Card origin;
+    origin.name = "some name"_s;
+
+    auto& person = origin.contact.reset<test::Person>();
+    person.name  = "some string"_s;
+    person.id    = 42;
+
+    auto check = [](const Card& item) {
+        REQUIRE("some name"_s == item.name);
+        REQUIRE(item.contact.is<test::Person>());
+        REQUIRE("some string"_s == item.contact.get<test::Person>().name);
+        REQUIRE(42 == item.contact.get<test::Person>().id);
     };
 
     check(origin);
 
-    SECTION("Serialization yaml")
-    {
-        std::string cnt = *pack::yaml::serialize(origin);
-        REQUIRE(!cnt.empty());
-
-        test8::Item restored;
-        pack::yaml::deserialize(cnt, restored);
-
-        check(restored);
-    }
-
-    SECTION("Serialization json")
+    SECTION("Serialization protobuf")
     {
-        std::string cnt = *pack::json::serialize(origin);
-        REQUIRE(!cnt.empty());
+        auto cnt = pack::protobuf::serialize(origin);
+        REQUIRE(cnt);
 
-        test8::Item restored;
-        pack::json::deserialize(cnt, restored);
+        Card restored;
+        restored.contact.reset<test::Person::Phone>().ext = 1;
+        REQUIRE(pack::protobuf::deserialize(*cnt, restored));
 
         check(restored);
     }
 
-    SECTION("Serialization zconfig")
+    SECTION("Oneof fields")
     {
-        std::string cnt = pack::zconfig::serialize(origin);
-        REQUIRE(!cnt.empty());
-
-        test8::Item restored;
-        pack::zconfig::deserialize(cnt, restored);
-
-        check(restored);
+        auto cnt = pack::protobuf::serialize(origin);
+        REQUIRE(cnt);
+
+        test::Card fields;
+        REQUIRE(pack::protobuf::deserialize(*cnt, fields));
+        REQUIRE("some name"_s == fields.name);
+        REQUIRE(!fields.phone.hasValue());
+        REQUIRE("some string"_s == fields.person.name);
+
+        fields.person.clear();
+        fields.phone.ext = 5;
+        auto other = pack::protobuf::serialize(fields);
+        REQUIRE(other);
+
+        Card restored;
+        REQUIRE(pack::protobuf::deserialize(*other, restored));
+        REQUIRE(restored.contact.is<test::Person::Phone>());
+        REQUIRE(5 == restored.contact.get<test::Person::Phone>().ext);
     }
 
-    SECTION("Serialization protobuf")
+    SECTION("Empty alternative")
     {
-        std::string cnt = pack::protobuf::serialize(origin);
-        REQUIRE(!cnt.empty());
+        Card empty;
+        empty.contact.reset<test::Person>();
 
-        test8::Item restored;
-        pack::protobuf::deserialize(cnt, restored);
+        auto cnt = pack::protobuf::serialize(empty);
+        REQUIRE(cnt);
+        CHECK(pack::toStdString(*cnt) == std::string("\x1a\x00", 2));
 
-        check(restored);
+        Card restored;
+        REQUIRE(pack::protobuf::deserialize(*cnt, restored));
+        REQUIRE(restored.contact.is<test::Person>());
     }
 }
-
@@ -14,11 +14,18 @@
     ========================================================================================================================================
 */
 #include <catch2/catch.hpp>
+#include <cmath>
 #include <iostream>
 #include <pack/pack.h>
 
 namespace options {
 
+enum class Color
+{
+    Red,
+    Green
+};
+
 struct Test : public pack::Node
 {
     struct Inner : public Node
@@ -109,3 +116,42 @@ TEST_CASE("Serialization options pretty print 2")
     }
 })"_s);
 }
+
+TEST_CASE("Shared defaults")
+{
+    options::Test first;
+    options::Test second;
+    CHECK(first.value == "val"_s);
+    CHECK(!first.value.hasValue());
+    CHECK(&first.value.defValue() == &second.value.defValue());
+
+    first.value = "other"_s;
+    CHECK(first.value.hasValue());
+    CHECK(second.value.defValue() == "val"_s);
+    first.clear();
+    CHECK(first.value == "val"_s);
+
+    pack::String str1{pack::Default("runtime default"_s)};
+    pack::String str2{pack::Default("other default"_s)};
+    CHECK(str1 == "runtime default"_s);
+    CHECK(str2 == "other default"_s);
+}
+
+TEST_CASE("Runtime defaults")
+{
+    pack::Double one(pack::Default(1.5));
+    pack::Double nan(pack::Default(std::nan("")));
+    pack::Double zero(pack::Default(0.0));
+    pack::Double negZero(pack::Default(-0.0));
+    CHECK(one.value() == 1.5);
+    CHECK(std::isnan(nan.value()));
+    CHECK(std::isnan(nan.defValue()));
+    CHECK(!std::signbit(zero.value()));
+    CHECK(std::signbit(negZero.value()));
+    CHECK(std::signbit(negZero.defValue()));
+
+    pack::Enum<options::Color> color(pack::Default(options::Color::Green));
+    pack::Enum<options::Color> copy(color);
+    CHECK(copy.defValue() == options::Color::Green);
+    CHECK(&copy.defValue() != &color.defValue());
+}
@@ -0,0 +1,206 @@
+/*  ========================================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ========================================================================================================================================
+*/
+#include <catch2/catch.hpp>
+#include <pack/pack.h>
+#include <pack/patch.h>
+
+namespace patch {
+
+struct Leaf : public pack::Node
+{
+    pack::String name  = FIELD("name");
+    pack::Int32  value = FIELD("value");
+
+    using pack::Node::Node;
+    META(Leaf, name, value);
+};
+
+struct Tagged : public pack::Node
+{
+    pack::String name = FIELD("name");
+    pack::String tag  = FIELD("tag");
+
+    using pack::Node::Node;
+    META(Tagged, name, tag);
+};
+
+struct State : public pack::Node
+{
+    pack::String     title = FIELD("title");
+    Leaf             main  = FIELD("main");
+    pack::List<Leaf> items = FIELD("items");
+    pack::Map<Leaf>  named = FIELD("named");
+    pack::Int32List  ids   = FIELD("ids");
+
+    using pack::Node::Node;
+    META(State, title, main, items, named, ids);
+};
+
+static Leaf leaf(const std::string& name, int value)
+{
+    Leaf ret;
+    ret.name  = pack::fromStdString(name);
+    ret.value = value;
+    return ret;
+}
+
+static State makeState()
+{
+    State state;
+    state.title = "state"_s;
+    state.main  = leaf("main", 1);
+    for (int i = 0; i < 3; ++i) {
+        state.items.append(leaf("item" + std::to_string(i), i));
+    }
+    state.named.append("first"_s) = leaf("first", 42);
+    state.ids                     = {1, 2, 3, 4};
+    return state;
+}
+
+} // namespace patch
+
+TEST_CASE("Patch")
+{
+    auto from = patch::makeState();
+
+    SECTION("same")
+    {
+        auto to = from;
+        auto ret = pack::diff(from, to);
+        REQUIRE(ret);
+        CHECK(ret->changes.empty());
+    }
+
+    SECTION("changes")
+    {
+        auto to = from;
+        to.title      = "changed"_s;
+        to.main.value = 2;
+        to.items[1].name = "changed"_s;
+        to.items.append(patch::leaf("item3", 3));
+        to.named.remove("first"_s);
+        to.named.append("second"_s) = patch::leaf("second", 1);
+        to.ids = {1, 5, 6, 7, 4};
+
+        auto ret = pack::diff(from, to);
+        REQUIRE(ret);
+        CHECK(!ret->changes.empty());
+        CHECK(from != to);
+
+        auto applied = from;
+        REQUIRE(pack::apply(*ret, applied));
+        CHECK(applied == to);
+
+        SECTION("json")
+        {
+            auto cnt = pack::json::serialize(*ret);
+            REQUIRE(cnt);
+
+            pack::Patch restored;
+            REQUIRE(pack::json::deserialize(*cnt, restored));
+            CHECK(restored == *ret);
+        }
+
+        SECTION("yaml")
+        {
+            auto cnt = pack::yaml::serialize(*ret);
+            REQUIRE(cnt);
+
+            pack::Patch restored;
+            REQUIRE(pack::yaml::deserialize(*cnt, restored));
+            CHECK(restored == *ret);
+        }
+
+#ifdef WITH_PROTOBUF
+        SECTION("protobuf")
+        {
+            auto cnt = pack::protobuf::serialize(*ret);
+            REQUIRE(cnt);
+
+            pack::Patch restored;
+            REQUIRE(pack::protobuf::deserialize(*cnt, restored));
+            CHECK(restored == *ret);
+        }
+#endif
+    }
+
+    SECTION("shrink")
+    {
+        auto to = from;
+        to.items.clear();
+        to.ids = {4};
+
+        auto ret = pack::diff(from, to);
+        REQUIRE(ret);
+
+        auto applied = from;
+        REQUIRE(pack::apply(*ret, applied));
+        CHECK(applied == to);
+    }
+
+    SECTION("variant")
+    {
+        pack::Variant<patch::Leaf, patch::Tagged> var(patch::leaf("leaf", 1));
+
+        auto same = var;
+        same.get<patch::Leaf>().value = 2;
+
+        auto ret = pack::diff(var, same);
+        REQUIRE(ret);
+        REQUIRE(ret->changes.size() == 1);
+        CHECK(ret->changes[0].path == pack::StringList({"value"_s}));
+
+        patch::Tagged tagged;
+        tagged.name = "tagged"_s;
+        tagged.tag  = "tag"_s;
+        pack::Variant<patch::Leaf, patch::Tagged> other(tagged);
+
+        auto replace = pack::diff(var, other);
+        REQUIRE(replace);
+
+        auto applied = var;
+        REQUIRE(pack::apply(*replace, applied));
+        REQUIRE(applied.is<patch::Tagged>());
+        CHECK(applied.get<patch::Tagged>() == tagged);
+    }
+
+    SECTION("incremental")
+    {
+        auto to = from;
+        to.items[2].value = 42;
+
+        auto ret = pack::diff(from, to);
+        REQUIRE(ret);
+        REQUIRE(ret->changes.size() == 1);
+
+        auto applied = from;
+        auto cached  = pack::json::serialize(applied, pack::Option::Incremental);
+        REQUIRE(cached);
+        REQUIRE(pack::apply(*ret, applied));
+        CHECK(*pack::json::serialize(applied, pack::Option::Incremental) == *pack::json::serialize(to));
+    }
+
+    SECTION("errors")
+    {
+        pack::Patch bad;
+        auto& change = bad.changes.append();
+        change.operation = pack::Change::Operation::Remove;
+        change.path = {"items"_s, "10"_s};
+
+        auto applied = from;
+        CHECK(!pack::apply(bad, applied));
+    }
+}
@@ -3,6 +3,20 @@
 
 #include "examples/example.h"
 
+// Person without the generated codec, goes through the reflection
+struct ReflectedPerson : public test::Person
+{
+    bool encodeProto(std::string& /*out*/) const override
+    {
+        return false;
+    }
+
+    bool decodeProto(std::string_view /*data*/) override
+    {
+        return false;
+    }
+};
+
 TEST_CASE("Protobuf types")
 {
     test::Person person;
@@ -66,4 +80,197 @@ TEST_CASE("Protobuf types")
 
         check(restored);
     }
+
+    SECTION("protobuf buffer")
+    {
+        auto cnt = pack::protobuf::serialize(person);
+        REQUIRE(cnt);
+
+        std::string out = "prefix";
+        REQUIRE(pack::protobuf::serialize(person, out));
+        CHECK(out.substr(0, 6) == "prefix");
+        CHECK(out.substr(6) == pack::toStdString(*cnt));
+
+        std::vector<char> bytes;
+        REQUIRE(pack::protobuf::serialize(person, bytes));
+        CHECK(std::string(bytes.begin(), bytes.end()) == out.substr(6));
+
+        test::Person restored;
+        REQUIRE(pack::protobuf::deserialize(std::string_view(out).substr(6), restored));
+        check(restored);
+
+        test::Person fromBytes;
+        REQUIRE(pack::protobuf::deserialize(reinterpret_cast<const std::byte*>(bytes.data()), bytes.size(), fromBytes));
+        check(fromBytes);
+    }
+
+    SECTION("protobuf wire")
+    {
+        test::Person small;
+        small.name = "a"_s;
+        small.id   = -1;
+        small.ids  = {1, 300};
+
+        std::string out;
+        REQUIRE(pack::protobuf::serialize(small, out));
+        CHECK(out == std::string("\x0a\x01" "a" "\x10\xff\xff\xff\xff\xff\xff\xff\xff\xff\x01" "\x4a\x03\x01\xac\x02", 19));
+
+        // Unknown field and not packed repeated value
+        std::string extended = out + std::string("\xf0\x01\x05" "\x48\x07", 5);
+        test::Person restored;
+        REQUIRE(pack::protobuf::deserialize(std::string_view(extended), restored));
+        CHECK(restored.name == "a"_s);
+        CHECK(restored.id == -1);
+        CHECK(restored.ids == pack::Int32List({1, 300, 7}));
+
+        test::Person truncated;
+        CHECK(!pack::protobuf::deserialize(std::string_view(out).substr(0, out.size() - 1), truncated));
+    }
+
+    SECTION("nesting limit")
+    {
+        // Unknown groups of the field 1, nested as deep as protobuf allows and one level deeper
+        auto groups = [](size_t depth) {
+            return std::string(depth, '\x0b') + std::string(depth, '\x0c');
+        };
+
+        test::Person    generated;
+        ReflectedPerson reflected;
+        CHECK(pack::protobuf::deserialize(std::string_view(groups(100)), generated));
+        CHECK(pack::protobuf::deserialize(std::string_view(groups(100)), reflected));
+        CHECK(!pack::protobuf::deserialize(std::string_view(groups(101)), generated));
+        CHECK(!pack::protobuf::deserialize(std::string_view(groups(101)), reflected));
+
+        std::string hostile(4 << 20, '\x0b');
+        CHECK(!pack::protobuf::deserialize(std::string_view(hostile), generated));
+        CHECK(!pack::protobuf::deserialize(std::string_view(hostile), reflected));
+    }
+
+    SECTION("generated codec")
+    {
+        person.kind        = test::Person::Kind::Colleague;
+        person.phone.ext   = 12;
+        person.delta       = -300;
+        person.crc         = 0xdeadbeef;
+        person.weights     = {0.5, -2.25};
+        person.active      = true;
+        auto& phone        = person.phones.append();
+        phone.number       = "555"_s;
+        person.phones.append().ext = 1;
+        person.ids.append(0);
+
+        std::string generated;
+        REQUIRE(person.encodeProto(generated));
+
+        // Incremental serialization goes through the reflection, generated code should give the same
+        auto reflected = pack::protobuf::serialize(person, pack::Option::Incremental);
+        REQUIRE(reflected);
+        CHECK(generated == pack::toStdString(*reflected));
+
+        test::Person restored;
+        restored.names = {"stale"_s};
+        restored.name  = "stale"_s;
+        REQUIRE(restored.decodeProto(generated));
+        CHECK(restored.name == "dead"_s);
+        CHECK(restored.names.size() == 3);
+        restored.names.removeAt(0);
+        CHECK(restored.compare(person));
+
+        for (auto opt : {pack::Option::No, pack::Option::PrettyPrint, pack::Option::WithDefaults | pack::Option::PrettyPrint}) {
+            std::string json;
+            REQUIRE(person.encodeJson(json, opt));
+            CHECK(*pack::json::serialize(person, opt | pack::Option::Incremental) == pack::fromStdString(json));
+            CHECK(*pack::json::serialize(person, opt) == pack::fromStdString(json));
+        }
+
+        test::Person empty;
+        std::string  json;
+        REQUIRE(empty.encodeJson(json, pack::Option::WithDefaults));
+        CHECK(*pack::json::serialize(empty, pack::Option::WithDefaults | pack::Option::Incremental) == pack::fromStdString(json));
+    }
+
+    SECTION("reflection")
+    {
+        person.phone.number = "123"_s;
+        person.revision     = 5;
+        person.phones.append().ext = 7;
+
+        std::string generated;
+        REQUIRE(person.encodeProto(generated));
+
+        // Field numbers above the directly indexed ones, known and unknown
+        ReflectedPerson restored;
+        REQUIRE(pack::protobuf::deserialize(std::string_view(generated + std::string("\xc0\xbb\x01\x01", 4)), restored));
+        check(restored);
+        CHECK(restored.revision == 5);
+        CHECK(restored.phone.number == "123"_s);
+        CHECK(restored.phones.size() == 1);
+        CHECK(restored.phones[0].ext == 7);
+
+        std::string out;
+        REQUIRE(pack::protobuf::serialize(restored, out));
+        CHECK(out == generated);
+    }
+
+    SECTION("map")
+    {
+        test::Contacts contacts;
+        contacts.counts.append("a"_s) = 1;
+
+        std::string out;
+        REQUIRE(pack::protobuf::serialize(contacts, out));
+        CHECK(out == std::string("\x0a\x05\x0a\x01" "a" "\x10\x01", 7));
+
+        contacts.counts.append("b"_s)        = 0;
+        contacts.phones.append("-7"_s).number = "555"_s;
+        contacts.phones.append("42"_s).ext    = 1;
+
+        auto cnt = pack::protobuf::serialize(contacts);
+        REQUIRE(cnt);
+
+        test::Contacts restored;
+        REQUIRE(pack::protobuf::deserialize(*cnt, restored));
+        CHECK(restored.counts.keys() == std::vector<pack::string_t>({"a"_s, "b"_s}));
+        CHECK(restored.counts["a"_s] == 1);
+        CHECK(restored.counts["b"_s] == 0);
+        CHECK(restored.phones.keys() == std::vector<pack::string_t>({"-7"_s, "42"_s}));
+        CHECK(restored.phones["-7"_s].number == "555"_s);
+        CHECK(restored.phones["42"_s].ext == 1);
+
+        // Keys of the message are numbers
+        contacts.phones.append("seven"_s);
+        CHECK(!pack::protobuf::serialize(contacts));
+    }
+
+    SECTION("packed lists")
+    {
+        test::Person packed;
+        for (int i = 0; i < 10000; ++i) {
+            packed.ids.append(i % 7 ? i * 131 : -i);
+            packed.weights.append(i / 3.0);
+        }
+
+        std::string generated;
+        REQUIRE(packed.encodeProto(generated));
+
+        auto reflected = pack::protobuf::serialize(packed, pack::Option::Incremental);
+        REQUIRE(reflected);
+        CHECK(generated == pack::toStdString(*reflected));
+
+        test::Person restored;
+        REQUIRE(pack::protobuf::deserialize(std::string_view(generated), restored));
+        CHECK(restored.ids == packed.ids);
+        CHECK(restored.weights == packed.weights);
+
+        ReflectedPerson viaReflection;
+        REQUIRE(pack::protobuf::deserialize(std::string_view(generated), viaReflection));
+        CHECK(viaReflection.ids == packed.ids);
+        CHECK(viaReflection.weights == packed.weights);
+
+        // Packed doubles which are not the multiple of the value size
+        test::Person broken;
+        CHECK(!pack::protobuf::deserialize(std::string_view("\x7a\x03\x00\x00\x00", 5), broken));
+        ReflectedPerson brokenReflection;
+        CHECK(!pack::protobuf::deserialize(std::string_view("\x7a\x03\x00\x00\x00", 5), brokenReflection));
+    }
 }
@@ -153,7 +153,50 @@ TEST_CASE("Node copy/move")
         CHECK(other.id == 42);
         CHECK(other.name == "Person"_s);
 
+        // Moved-from node is still usable
+        origin = other;
         CHECK(other == origin);
         CHECK(other.compare(origin));
     }
 }
+
+TEST_CASE("Field lookup")
+{
+    simple::Person origin;
+    origin.id    = 42;
+    origin.email = "person@email.org"_s;
+
+    auto byKey = origin.fieldByKey("email");
+    REQUIRE(byKey);
+    CHECK(&byKey->get() == &origin.email);
+
+    auto byName = origin.fieldByName(std::string_view("id"));
+    REQUIRE(byName);
+    CHECK(&byName->get() == &origin.id);
+
+    CHECK(!origin.fieldByKey("unknown"));
+    CHECK(!origin.fieldByName("unknown"));
+    CHECK(simple::Person::staticFields().indexOfName("email") == 2);
+    CHECK(simple::Person::staticFields().indexOfKey("name", origin) == 0);
+}
+
+TEST_CASE("Shared keys")
+{
+    simple::Person first;
+    simple::Person second;
+    CHECK(first.email.key() == "email"_s);
+    CHECK(&first.email.key() == &second.email.key());
+
+    // Runtime keys belong to the attribute
+    pack::String str1{pack::Key("runtime key"_s)};
+    pack::String str2{pack::Key("runtime key"_s)};
+    CHECK(str1.key() == "runtime key"_s);
+    CHECK(&str1.key() != &str2.key());
+
+    pack::String copy(str1);
+    CHECK(copy.key() == "runtime key"_s);
+    CHECK(&copy.key() != &str1.key());
+
+    pack::String moved(std::move(copy));
+    CHECK(moved.key() == "runtime key"_s);
+}
@@ -0,0 +1,162 @@
+/*  ========================================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ========================================================================================================================================
+*/
+#include <catch2/catch.hpp>
+#include <pack/pack.h>
+#include <sstream>
+#include <unistd.h>
+
+namespace sink {
+
+struct Item : public pack::Node
+{
+    pack::Int32      id    = FIELD("id");
+    pack::String     name  = FIELD("name");
+    pack::StringList names = FIELD("names");
+
+    using pack::Node::Node;
+    META(Item, id, name, names);
+};
+
+} // namespace sink
+
+TEST_CASE("Serialize to buffer")
+{
+    sink::Item item;
+    item.id    = 42;
+    item.name  = "dead parrot"_s;
+    item.names = {"a"_s, "b"_s};
+
+    SECTION("json")
+    {
+        auto expected = pack::json::serialize(item, pack::Option::PrettyPrint);
+        REQUIRE(expected);
+
+        std::string out = "prefix";
+        out.reserve(1024);
+        const char* data = out.data();
+        REQUIRE(pack::json::serialize(item, out, pack::Option::PrettyPrint));
+        CHECK(out == "prefix" + pack::toStdString(*expected));
+        CHECK(out.data() == data);
+
+        std::vector<char> bytes;
+        REQUIRE(pack::json::serialize(item, bytes, pack::Option::PrettyPrint));
+        CHECK(std::string(bytes.begin(), bytes.end()) == pack::toStdString(*expected));
+
+        sink::Item restored;
+        REQUIRE(pack::json::deserialize(pack::fromStdString(out.substr(6)), restored));
+        CHECK(restored.compare(item));
+    }
+
+    SECTION("yaml")
+    {
+        auto expected = pack::yaml::serialize(item);
+        REQUIRE(expected);
+
+        std::string out = "prefix";
+        REQUIRE(pack::yaml::serialize(item, out));
+        CHECK(out == "prefix" + pack::toStdString(*expected));
+
+        std::vector<char> bytes;
+        REQUIRE(pack::yaml::serialize(item, bytes));
+        CHECK(std::string(bytes.begin(), bytes.end()) == pack::toStdString(*expected));
+
+        sink::Item restored;
+        REQUIRE(pack::yaml::deserialize(std::string_view(out).substr(6), restored));
+        CHECK(restored.compare(item));
+
+        sink::Item fromBytes;
+        REQUIRE(pack::yaml::deserialize(reinterpret_cast<const std::byte*>(bytes.data()), bytes.size(), fromBytes));
+        CHECK(fromBytes.compare(item));
+    }
+}
+
+TEST_CASE("Serialize to sink")
+{
+    sink::Item item;
+    item.id   = 42;
+    item.name = "dead parrot"_s;
+
+    auto expected = pack::json::serialize(item);
+    REQUIRE(expected);
+
+    SECTION("stream")
+    {
+        std::stringstream ss;
+        pack::StreamSink  sink(ss);
+        REQUIRE(pack::json::serialize(item, sink));
+        REQUIRE(pack::yaml::serialize(item, sink));
+        CHECK(ss.str() == pack::toStdString(*expected) + pack::toStdString(*pack::yaml::serialize(item)));
+    }
+
+    SECTION("fd")
+    {
+        int fds[2];
+        REQUIRE(pipe(fds) == 0);
+        {
+            pack::FdSink sink(fds[1]);
+            REQUIRE(pack::json::serialize(item, sink));
+            close(fds[1]);
+        }
+
+        std::string out;
+        char        buff[16];
+        ssize_t     size;
+        while ((size = read(fds[0], buff, sizeof(buff))) > 0) {
+            out.append(buff, size_t(size));
+        }
+        close(fds[0]);
+        CHECK(out == pack::toStdString(*expected));
+    }
+
+    SECTION("buffer")
+    {
+        char buff[8];
+
+        pack::BufferSink small(buff, sizeof(buff));
+        CHECK(!pack::json::serialize(item, small));
+
+        std::string      out;
+        int              overflows = 0;
+        pack::BufferSink sink(buff, sizeof(buff), [&](const char* data, size_t size) -> pack::Expected<void> {
+            ++overflows;
+            out.append(data, size);
+            return {};
+        });
+        REQUIRE(pack::json::serialize(item, sink));
+        REQUIRE(sink.flush());
+        CHECK(sink.size() == 0);
+        CHECK(overflows > 1);
+        CHECK(out == pack::toStdString(*expected));
+
+        pack::BufferSink failing(buff, sizeof(buff), [](const char*, size_t) -> pack::Expected<void> {
+            return pack::unexpected("no space"_s);
+        });
+        auto ret = pack::json::serialize(item, failing);
+        REQUIRE(!ret);
+        CHECK(ret.error() == "no space"_s);
+    }
+
+    SECTION("file")
+    {
+        std::string fileName = "sink-test.json";
+        REQUIRE(pack::json::serializeFile(pack::fromStdString(fileName), item));
+
+        sink::Item restored;
+        REQUIRE(pack::json::deserializeFile(pack::fromStdString(fileName), restored));
+        CHECK(restored.compare(item));
+        unlink(fileName.c_str());
+    }
+}
@@ -0,0 +1,248 @@
+/*  ========================================================================================================================================
+    Copyright (C) 2020 Eaton
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    ========================================================================================================================================
+*/
+#include <catch2/catch.hpp>
+#include <pack/pack.h>
+#include <sstream>
+
+namespace yaml {
+
+struct Item : public pack::Node
+{
+    pack::String name  = FIELD("name");
+    pack::Double value = FIELD("value");
+    pack::Bool   flag  = FIELD("flag");
+
+    using pack::Node::Node;
+    META(Item, name, value, flag);
+};
+
+struct Doc : public pack::Node
+{
+    pack::String     title  = FIELD("title");
+    Item             item   = FIELD("item");
+    pack::List<Item> items  = FIELD("items");
+    pack::Map<Item>  byName = FIELD("byName");
+    pack::StringList tags   = FIELD("tags");
+
+    using pack::Node::Node;
+    META(Doc, title, item, items, byName, tags);
+};
+
+} // namespace yaml
+
+TEST_CASE("Yaml writer output")
+{
+    SECTION("values")
+    {
+        yaml::Doc doc;
+        doc.title = "multi\nline: text"_s;
+        doc.items.append();
+        doc.items.append().value = 0.1;
+        doc.byName.append("empty"_s);
+        doc.byName.append("full"_s).name = "true"_s;
+        doc.tags = {"a"_s, "- b"_s};
+
+        auto expected = "title: \"multi\\nline: text\"\n"
+                        "items:\n"
+                        "  - ~\n"
+                        "  - value: 0.10000000000000001\n"
+                        "byName:\n"
+                        "  empty: ~\n"
+                        "  full:\n"
+                        "    name: true\n"
+                        "tags:\n"
+                        "  - a\n"
+                        "  - \"- b\""_s;
+        CHECK(*pack::yaml::serialize(doc) == expected);
+
+        yaml::Doc restored;
+        REQUIRE(pack::yaml::deserialize(expected, restored));
+        CHECK(restored.title == doc.title);
+        CHECK(restored.items.size() == 2);
+        CHECK(restored.items[1].value == 0.1);
+        CHECK(restored.byName["full"_s].name == "true"_s);
+        CHECK(restored.tags == doc.tags);
+    }
+
+    SECTION("defaults")
+    {
+        yaml::Doc doc;
+        CHECK(*pack::yaml::serialize(doc) == ""_s);
+
+        auto expected = "title: \"\"\n"
+                        "item:\n"
+                        "  name: \"\"\n"
+                        "  value: 0\n"
+                        "  flag: false\n"
+                        "items:\n"
+                        "  []\n"
+                        "byName:\n"
+                        "  {}\n"
+                        "tags:\n"
+                        "  []"_s;
+        CHECK(*pack::yaml::serialize(doc, pack::Option::WithDefaults) == expected);
+    }
+}
+
+TEST_CASE("Yaml reader")
+{
+    SECTION("anchors and aliases")
+    {
+        auto content = "item: &base {name: base, value: 1.5}\n"
+                       "items: [*base, {name: other}, *base]\n"
+                       "byName: {first: *base}\n"
+                       "tags: &tags [a, b]\n"
+                       "title: &title t"_s;
+
+        yaml::Doc doc;
+        REQUIRE(pack::yaml::deserialize(content, doc));
+        CHECK(doc.title == "t"_s);
+        CHECK(doc.item.name == "base"_s);
+        CHECK(doc.item.value == 1.5);
+        REQUIRE(doc.items.size() == 3);
+        CHECK(doc.items[0].name == "base"_s);
+        CHECK(doc.items[1].name == "other"_s);
+        CHECK(doc.items[2].value == 1.5);
+        CHECK(doc.byName["first"_s].name == "base"_s);
+        REQUIRE(doc.tags.size() == 2);
+        CHECK(doc.tags[1] == "b"_s);
+    }
+
+    SECTION("unknown and complex keys")
+    {
+        auto content = "unknown: {nested: [1, {deep: 2}]}\n"
+                       "? [complex, key]\n"
+                       ": {name: skipped}\n"
+                       "title: kept\n"
+                       "title: duplicate\n"
+                       "item: {name: n, extra: [x]}"_s;
+
+        yaml::Doc doc;
+        REQUIRE(pack::yaml::deserialize(content, doc));
+        CHECK(doc.title == "kept"_s);
+        CHECK(doc.item.name == "n"_s);
+        CHECK(doc.items.empty());
+    }
+
+    SECTION("mismatched shapes")
+    {
+        yaml::Doc doc;
+        CHECK(!pack::yaml::deserialize("items: {name: x}"_s, doc));
+        CHECK(!pack::yaml::deserialize("byName: [x]"_s, doc));
+        CHECK(!pack::yaml::deserialize("title: [x]"_s, doc));
+        CHECK(!pack::yaml::deserialize("item: value"_s, doc));
+        CHECK(!pack::yaml::deserialize("byName: {[a]: {name: b}}"_s, doc));
+        CHECK(pack::yaml::deserialize("item: [x]\nitems: ~\nbyName: {}"_s, doc));
+
+        pack::Int32 value;
+        CHECK(!pack::yaml::deserialize(""_s, value));
+        CHECK(!pack::yaml::deserialize("{a: [1,"_s, value));
+    }
+
+    SECTION("conversion error has the position")
+    {
+        yaml::Item item;
+        auto       ret = pack::yaml::deserialize("name: a\nvalue: x"_s, item);
+        REQUIRE(!ret);
+        CHECK(ret.error() == "yaml-cpp: error at line 2, column 8: bad conversion"_s);
+    }
+
+    SECTION("from string literal")
+    {
+        yaml::Doc doc;
+        REQUIRE(pack::yaml::deserialize("title: x", doc));
+        CHECK(doc.title == "x"_s);
+    }
+}
+
+TEST_CASE("Yaml multi-document")
+{
+    std::vector<yaml::Item> items(3);
+    items[0].name  = "first"_s;
+    items[2].value = 2.5;
+    items[2].flag  = true;
+
+    auto expected = "name: first\n"
+                    "---\n"
+                    "~\n"
+                    "---\n"
+                    "value: 2.5\n"
+                    "flag: true"_s;
+
+    SECTION("round trip")
+    {
+        CHECK(*pack::yaml::serializeAll(items) == expected);
+
+        std::vector<yaml::Item> restored;
+        REQUIRE(pack::yaml::deserializeAll<yaml::Item>(pack::toStdString(expected), [&](const yaml::Item& item) {
+            restored.push_back(item);
+        }));
+        REQUIRE(restored.size() == 3);
+        CHECK(restored[0].name == "first"_s);
+        CHECK(!restored[1].name.hasValue());
+        CHECK(!restored[2].name.hasValue());
+        CHECK(restored[2].value == 2.5);
+        CHECK(restored[2].flag == true);
+    }
+
+    SECTION("streams")
+    {
+        std::stringstream  stream;
+        pack::StreamSink   sink(stream);
+        REQUIRE(pack::yaml::serializeAll(items, sink));
+        CHECK(pack::fromStdString(stream.str()) == expected);
+
+        int count = 0;
+        REQUIRE(pack::yaml::deserializeAll<yaml::Item>(stream, [&](yaml::Item& item) {
+            ++count;
+            return !item.flag.hasValue();
+        }));
+        CHECK(count == 3);
+    }
+
+    SECTION("stop and errors")
+    {
+        int count = 0;
+        REQUIRE(pack::yaml::deserializeAll<yaml::Item>("a: 1\n---\nb: 2\n---\nc: 3", [&](yaml::Item&) {
+            return ++count < 2;
+        }));
+        CHECK(count == 2);
+
+        count    = 0;
+        auto ret = pack::yaml::deserializeAll<yaml::Item>("name: a\n---\nvalue: x", [&](yaml::Item&) {
+            ++count;
+        });
+        REQUIRE(!ret);
+        CHECK(ret.error() == "Document 2: yaml-cpp: error at line 3, column 8: bad conversion"_s);
+        CHECK(count == 1);
+
+        count = 0;
+        REQUIRE(pack::yaml::deserializeAll<yaml::Item>("", [&](yaml::Item&) {
+            ++count;
+        }));
+        CHECK(count == 0);
+        CHECK(*pack::yaml::serializeAll(std::vector<yaml::Item>{}) == ""_s);
+    }
+
+    SECTION("anchors are scoped to the document")
+    {
+        std::vector<pack::string_t> names;
+        CHECK(!pack::yaml::deserializeAll<yaml::Item>("name: &n a\n---\nname: *n", [&](yaml::Item& item) {
+            names.push_back(item.name);
+        }));
+        CHECK(names.size() == 1);
+    }
+}